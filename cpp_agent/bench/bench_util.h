@@ -0,0 +1,88 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace bench {
+
+/**
+ * @brief 基准程序共用的计时与输出工具
+ *
+ * 各基准程序第一个命令行参数为规模倍数（默认1），用于在较慢的机器上缩短运行时间
+ * 或在正式测量时拉长运行时间。
+ */
+class Stopwatch {
+public:
+    Stopwatch() : start_(std::chrono::steady_clock::now()) {}
+
+    void restart() { start_ = std::chrono::steady_clock::now(); }
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 阻止编译器把只为测量而计算的结果优化掉
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline double scaleFromArgs(int argc, char** argv) {
+    if (argc > 1) {
+        double scale = std::atof(argv[1]);
+        if (scale > 0) {
+            return scale;
+        }
+    }
+    return 1.0;
+}
+
+#ifndef AGENT_BENCH_FIXTURE_DIR
+#define AGENT_BENCH_FIXTURE_DIR "bench/fixtures"
+#endif
+
+// 读取bench/fixtures下的样例数据，读取失败时直接退出
+inline std::string readFixture(const std::string& name) {
+    std::string path = std::string(AGENT_BENCH_FIXTURE_DIR) + "/" + name;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "无法读取样例文件: %s\n", path.c_str());
+        std::exit(1);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// 输出一行结果：吞吐量（MB/s）和操作速率
+inline void report(const std::string& name, size_t bytes, size_t ops, double seconds) {
+    if (seconds <= 0) {
+        seconds = 1e-9;
+    }
+    std::printf("%-40s %10.1f MB/s %12.0f ops/s  (%zu ops, %.3fs)\n", name.c_str(),
+                static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds,
+                static_cast<double>(ops) / seconds, ops, seconds);
+}
+
+// 输出一行结果：只有操作速率和平均耗时
+inline void reportOps(const std::string& name, size_t ops, double seconds) {
+    if (seconds <= 0) {
+        seconds = 1e-9;
+    }
+    std::printf("%-40s %12.0f ops/s %10.3f us/op  (%zu ops, %.3fs)\n", name.c_str(),
+                static_cast<double>(ops) / seconds, seconds * 1e6 / static_cast<double>(ops ? ops : 1),
+                ops, seconds);
+}
+
+} // namespace bench
+
+#endif // BENCH_UTIL_H
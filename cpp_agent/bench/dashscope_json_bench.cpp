@@ -0,0 +1,255 @@
+// DashScope请求/响应JSON处理基准：新的JsonDocument/JsonWriter对比旧的子串查找、正则和ostringstream实现
+//
+// 用法：dashscope_json_bench [规模倍数]
+// 样例数据：
+//   fixtures/dashscope_response.json          message格式的对话回复（带缩进，中文未转义）
+//   fixtures/dashscope_response_escaped.json  同一回复，中文以\uXXXX转义
+//   fixtures/dashscope_chat_prompt.txt        含10轮短期上下文和长期偏好的对话提示词（约2KB）
+// legacy命名空间中是被替换前的实现（JsonParser::extractContentFromNestedJson、callLLM中的
+// 正则回退、escapeJsonString + ostringstream），原样保留以便对比。
+
+#include "bench_util.h"
+#include "utils/json.h"
+#include "utils/json_writer.h"
+#include <cstdio>
+#include <regex>
+#include <sstream>
+#include <string>
+
+namespace legacy {
+
+std::string unescapeJsonString(const std::string& str) {
+    std::string unescaped;
+    unescaped.reserve(str.length());
+    for (size_t i = 0; i < str.length(); ++i) {
+        if (str[i] == '\\' && i + 1 < str.length()) {
+            switch (str[i + 1]) {
+                case 'n': unescaped += '\n'; i++; break;
+                case 'r': unescaped += '\r'; i++; break;
+                case 't': unescaped += '\t'; i++; break;
+                case 'b': unescaped += '\b'; i++; break;
+                case 'f': unescaped += '\f'; i++; break;
+                case '"': unescaped += '"'; i++; break;
+                case '\\': unescaped += '\\'; i++; break;
+                case '/': unescaped += '/'; i++; break;
+                case 'u':
+                    if (i + 5 < str.length()) {
+                        unescaped += '?';
+                        i += 5;
+                    } else {
+                        unescaped += str[i];
+                    }
+                    break;
+                default: unescaped += str[i]; break;
+            }
+        } else {
+            unescaped += str[i];
+        }
+    }
+    return unescaped;
+}
+
+std::string escapeJsonString(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.length() * 2);
+    for (size_t i = 0; i < str.length(); ++i) {
+        unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c < 0x20) {
+            switch (c) {
+                case '\n': escaped += "\\n"; break;
+                case '\r': escaped += "\\r"; break;
+                case '\t': escaped += "\\t"; break;
+                case '\b': escaped += "\\b"; break;
+                case '\f': escaped += "\\f"; break;
+                default: {
+                    char hex[7];
+                    snprintf(hex, sizeof(hex), "\\u%04x", c);
+                    escaped += hex;
+                    break;
+                }
+            }
+        } else {
+            switch (c) {
+                case '"': escaped += "\\\""; break;
+                case '\\': escaped += "\\\\"; break;
+                case '/': escaped += "\\/"; break;
+                default: escaped += c; break;
+            }
+        }
+    }
+    return escaped;
+}
+
+std::string extractStringValue(const std::string& json, size_t key_start) {
+    size_t colon_pos = json.find(':', key_start);
+    if (colon_pos == std::string::npos) {
+        return "";
+    }
+    size_t value_start = colon_pos + 1;
+    while (value_start < json.length() &&
+           (json[value_start] == ' ' || json[value_start] == '\t' ||
+            json[value_start] == '\n' || json[value_start] == '\r')) {
+        value_start++;
+    }
+    if (value_start >= json.length() || json[value_start] != '"') {
+        return "";
+    }
+    value_start++;
+    size_t value_end = value_start;
+    bool escaped = false;
+    while (value_end < json.length()) {
+        if (escaped) {
+            escaped = false;
+            value_end++;
+            continue;
+        }
+        if (json[value_end] == '\\') {
+            escaped = true;
+            value_end++;
+            continue;
+        }
+        if (json[value_end] == '"') {
+            break;
+        }
+        value_end++;
+    }
+    if (value_end > value_start) {
+        return unescapeJsonString(json.substr(value_start, value_end - value_start));
+    }
+    return "";
+}
+
+std::string extractContentFromNestedJson(const std::string& json) {
+    size_t message_pos = json.find("\"message\"");
+    if (message_pos == std::string::npos) {
+        return "";
+    }
+    size_t content_pos = json.find("\"content\"", message_pos);
+    if (content_pos == std::string::npos) {
+        return "";
+    }
+    return extractStringValue(json, content_pos);
+}
+
+// callLLM在子串查找失败时的回退路径：每次调用都重新编译正则
+std::string extractContentByRegex(const std::string& json) {
+    std::regex content_regex1(R"xxx("message"\s*:\s*\{[^}]*"content"\s*:\s*"([^"]*)")xxx");
+    std::smatch match1;
+    if (std::regex_search(json, match1, content_regex1)) {
+        return unescapeJsonString(match1[1].str());
+    }
+    std::regex content_regex2(R"xxx("content"\s*:\s*"([^"]*)")xxx");
+    std::smatch match2;
+    if (std::regex_search(json, match2, content_regex2)) {
+        return unescapeJsonString(match2[1].str());
+    }
+    return "";
+}
+
+std::string buildRequestBody(const std::string& prompt) {
+    std::string json_escaped = escapeJsonString(prompt);
+    std::ostringstream json_body;
+    json_body << "{"
+              << "\"model\":\"qwen-turbo\","
+              << "\"input\":{"
+              << "\"messages\":[{"
+              << "\"role\":\"user\","
+              << "\"content\":\"" << json_escaped << "\""
+              << "}]"
+              << "},"
+              << "\"parameters\":{"
+              << "\"temperature\":0.5,"
+              << "\"result_format\":\"message\""
+              << "}"
+              << "}";
+    return json_body.str();
+}
+
+} // namespace legacy
+
+namespace current {
+
+// 与llm.cpp中extractReplyContent相同的取值路径
+std::string extractReplyContent(const std::string& body) {
+    utils::JsonDocument doc;
+    if (!doc.parse(body)) {
+        return "";
+    }
+    const utils::JsonValue* content = doc.find("output.choices[0].message.content");
+    if (!content || !content->isString()) {
+        content = doc.find("output.text");
+    }
+    return content ? std::string(content->asString()) : "";
+}
+
+// 与llm.cpp中buildRequestBody相同的写法
+std::string buildRequestBody(const std::string& prompt) {
+    utils::JsonWriter json;
+    json.beginObject()
+        .key("model").value("qwen-turbo")
+        .key("input").beginObject()
+            .key("messages").beginArray()
+                .beginObject().key("role").value("user").key("content").value(prompt).endObject()
+            .endArray()
+        .endObject()
+        .key("parameters").beginObject().rawMembers("\"temperature\":0.5,\"result_format\":\"message\"")
+        .endObject()
+        .endObject();
+    return json.str();
+}
+
+} // namespace current
+
+namespace {
+
+template <typename Fn>
+void run(const std::string& name, const std::string& input, size_t iterations, Fn fn) {
+    bench::Stopwatch watch;
+    for (size_t i = 0; i < iterations; ++i) {
+        std::string result = fn(input);
+        bench::doNotOptimize(result.data());
+    }
+    bench::report(name, input.size() * iterations, iterations, watch.seconds());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double scale = bench::scaleFromArgs(argc, argv);
+    size_t iterations = static_cast<size_t>(200000 * scale);
+    size_t regex_iterations = static_cast<size_t>(5000 * scale);
+    if (iterations == 0) iterations = 1;
+    if (regex_iterations == 0) regex_iterations = 1;
+
+    std::string response = bench::readFixture("dashscope_response.json");
+    std::string response_escaped = bench::readFixture("dashscope_response_escaped.json");
+    std::string prompt = bench::readFixture("dashscope_chat_prompt.txt");
+
+    // 两种实现在未转义的样例上结果应一致；转义样例上旧实现把\uXXXX替换为'?'
+    std::string expected = current::extractReplyContent(response);
+    if (expected.empty() || legacy::extractContentFromNestedJson(response) != expected ||
+        current::extractReplyContent(response_escaped) != expected) {
+        std::fprintf(stderr, "样例数据的解析结果不一致\n");
+        return 1;
+    }
+
+    std::printf("DashScope响应解析 (回复文本%zu字节)\n", expected.size());
+    run("legacy substring (pretty)", response, iterations, legacy::extractContentFromNestedJson);
+    run("legacy regex fallback (pretty)", response, regex_iterations, legacy::extractContentByRegex);
+    run("JsonDocument (pretty)", response, iterations, current::extractReplyContent);
+    run("legacy substring (\\u escaped)", response_escaped, iterations, legacy::extractContentFromNestedJson);
+    run("legacy regex fallback (\\u escaped)", response_escaped, regex_iterations,
+        legacy::extractContentByRegex);
+    run("JsonDocument (\\u escaped)", response_escaped, iterations, current::extractReplyContent);
+
+    std::printf("\nDashScope请求体构造 (提示词%zu字节)\n", prompt.size());
+    run("legacy escapeJsonString", prompt, iterations, legacy::escapeJsonString);
+    run("JsonWriter::appendEscaped", prompt, iterations, [](const std::string& text) {
+        std::string out;
+        utils::JsonWriter::appendEscaped(out, text);
+        return out;
+    });
+    run("legacy ostringstream body", prompt, iterations, legacy::buildRequestBody);
+    run("JsonWriter body", prompt, iterations, current::buildRequestBody);
+    return 0;
+}
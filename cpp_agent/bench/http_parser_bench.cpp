@@ -0,0 +1,125 @@
+// HttpRequestParser解析吞吐量基准
+//
+// 用法：http_parser_bench [规模倍数]
+// 覆盖三类输入：单个Content-Length请求、流水线中的多个请求、chunked请求体；
+// 流水线和chunked输入还分别以整块和按1460字节分段（模拟TCP读）两种方式喂给解析器。
+
+#include "bench_util.h"
+#include "server/http_parser.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using server::HttpRequest;
+using server::HttpRequestParser;
+
+namespace {
+
+const size_t segment_bytes = 1460;
+
+std::string chatRequest(const std::string& body) {
+    return "POST /chat HTTP/1.1\r\n"
+           "Host: localhost:8443\r\n"
+           "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+           "Accept: application/json, text/plain, */*\r\n"
+           "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+           "Content-Type: application/json\r\n"
+           "Connection: keep-alive\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "\r\n" + body;
+}
+
+std::string chunkedRequest(const std::string& body, size_t chunk_size) {
+    std::string request = "POST /chat HTTP/1.1\r\n"
+                          "Host: localhost:8443\r\n"
+                          "Content-Type: application/json\r\n"
+                          "Transfer-Encoding: chunked\r\n"
+                          "\r\n";
+    char size_line[24];
+    for (size_t off = 0; off < body.size(); off += chunk_size) {
+        size_t n = std::min(chunk_size, body.size() - off);
+        snprintf(size_line, sizeof(size_line), "%zx\r\n", n);
+        request += size_line;
+        request.append(body, off, n);
+        request += "\r\n";
+    }
+    request += "0\r\n\r\n";
+    return request;
+}
+
+std::string chatBody(size_t input_bytes) {
+    std::string input;
+    while (input.size() < input_bytes) {
+        input += "今天天气不错，我想去公园钓鱼，顺便跑跑步。";
+    }
+    return "{\"session_id\":\"s-20261016-0001\",\"user_id\":\"u-10086\",\"user_input\":\"" + input + "\"}";
+}
+
+// 解析buffer中的全部请求，返回完成的请求数；segmented为true时按segment_bytes逐段增加可见长度
+size_t parseAll(HttpRequestParser& parser, std::string& buffer, bool segmented, HttpRequest& request) {
+    size_t requests = 0;
+    size_t offset = 0;
+    size_t visible = segmented ? std::min(segment_bytes, buffer.size()) : buffer.size();
+    while (offset < buffer.size()) {
+        HttpRequestParser::Status status = parser.parse(&buffer[offset], visible - offset);
+        if (status == HttpRequestParser::Status::Complete) {
+            parser.fill(buffer.data() + offset, request);
+            bench::doNotOptimize(request.body.size());
+            offset += parser.consumed();
+            parser.reset();
+            requests++;
+            continue;
+        }
+        if (status == HttpRequestParser::Status::Error || visible == buffer.size()) {
+            std::fprintf(stderr, "解析失败: %s\n", parser.errorMessage().c_str());
+            std::exit(1);
+        }
+        visible = std::min(visible + segment_bytes, buffer.size());
+    }
+    return requests;
+}
+
+// input作为原始数据，每轮复制到工作缓冲区（chunked解码会原地改写缓冲区）
+void run(const std::string& name, const std::string& input, size_t total_bytes, bool segmented) {
+    HttpRequestParser parser;
+    HttpRequest request;
+    std::string buffer;
+    size_t rounds = std::max<size_t>(1, total_bytes / input.size());
+
+    size_t requests = 0;
+    bench::Stopwatch watch;
+    for (size_t i = 0; i < rounds; ++i) {
+        buffer.assign(input);
+        requests += parseAll(parser, buffer, segmented, request);
+    }
+    bench::report(name, rounds * input.size(), requests, watch.seconds());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t total = static_cast<size_t>(256.0 * 1024 * 1024 * bench::scaleFromArgs(argc, argv));
+
+    std::string small = chatRequest(chatBody(64));
+    std::string large = chatRequest(chatBody(16 * 1024));
+
+    std::string pipelined;
+    for (int i = 0; i < 32; ++i) {
+        pipelined += i % 8 == 0 ? large : small;
+    }
+    std::string chunked = chunkedRequest(chatBody(64 * 1024), 4096);
+    std::string chunked_small;
+    for (int i = 0; i < 16; ++i) {
+        chunked_small += chunkedRequest(chatBody(512), 128);
+    }
+
+    std::printf("HttpRequestParser 吞吐量 (每项约%zu MB输入)\n", total / (1024 * 1024));
+    run("single/content-length small", small, total, false);
+    run("single/content-length 16KB", large, total, false);
+    run("pipelined x32", pipelined, total, false);
+    run("pipelined x32 (1460B segments)", pipelined, total, true);
+    run("chunked 64KB/4KB chunks", chunked, total, false);
+    run("chunked 64KB/4KB chunks (segments)", chunked, total, true);
+    run("pipelined chunked x16/128B chunks", chunked_small, total, false);
+    return 0;
+}
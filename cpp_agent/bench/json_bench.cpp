@@ -0,0 +1,178 @@
+// JSON解析、反转义和转义吞吐量基准
+//
+// 用法：json_bench [规模倍数]
+// - 解析：JsonDocument（DOM）和JsonReader（SAX，空处理器）分别解析DashScope响应样例和
+//   生成的大文档（ASCII为主 / 中文为主 / 中文全部以\uXXXX转义）
+// - 反转义：JsonReader::unescape在无转义长文本（整段memcpy的快速路径）、少量转义、
+//   全部\uXXXX（含代理对）三种输入上的吞吐量
+// - 转义：JsonWriter::appendEscaped在ASCII、中文、含控制字符文本上的吞吐量
+
+#include "bench_util.h"
+#include "utils/json.h"
+#include "utils/json_writer.h"
+#include <cstdio>
+#include <string>
+
+namespace {
+
+class NullHandler : public utils::JsonHandler {
+public:
+    size_t events = 0;
+    bool onNull() override { events++; return true; }
+    bool onBool(bool) override { events++; return true; }
+    bool onNumber(std::string_view, double) override { events++; return true; }
+    bool onString(std::string_view) override { events++; return true; }
+    bool onKey(std::string_view) override { events++; return true; }
+    bool onStartObject() override { events++; return true; }
+    bool onEndObject(size_t) override { events++; return true; }
+    bool onStartArray() override { events++; return true; }
+    bool onEndArray(size_t) override { events++; return true; }
+};
+
+const char* const ascii_sentence = "The quick brown fox jumps over the lazy dog; user likes fishing and running. ";
+const char* const cjk_sentence = "今天天气不错，我想去公园钓鱼，顺便跑跑步，晚上回家看一部电影。";
+
+std::string repeat(const std::string& text, size_t bytes) {
+    std::string out;
+    out.reserve(bytes + text.size());
+    while (out.size() < bytes) {
+        out += text;
+    }
+    return out;
+}
+
+// 把UTF-8文本中的非ASCII码点全部写成\uXXXX（码点大于U+FFFF时写成代理对）
+std::string escapeNonAscii(const std::string& text) {
+    std::string out;
+    char buf[16];
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80) {
+            out += static_cast<char>(c);
+            ++i;
+            continue;
+        }
+        size_t len = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+        uint32_t cp = c & (len == 2 ? 0x1F : len == 3 ? 0x0F : 0x07);
+        for (size_t k = 1; k < len; ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            std::snprintf(buf, sizeof(buf), "\\u%04X\\u%04X", 0xD800 + (cp >> 10), 0xDC00 + (cp & 0x3FF));
+        } else {
+            std::snprintf(buf, sizeof(buf), "\\u%04X", cp);
+        }
+        out += buf;
+        i += len;
+    }
+    return out;
+}
+
+// 生成对象数组形式的文档，每个元素含若干字符串、数字和布尔字段，总大小约bytes
+std::string makeDocument(const std::string& text_sample, size_t bytes, bool escape_non_ascii) {
+    std::string doc = "[";
+    for (int i = 0; doc.size() < bytes; ++i) {
+        std::string element;
+        utils::JsonWriter json(element);
+        json.beginObject()
+            .key("id").value(i)
+            .key("user_id").value("u-" + std::to_string(100000 + i))
+            .key("score").value(i * 0.25)
+            .key("active").value(i % 3 == 0)
+            .key("tags").beginArray().value("钓鱼").value("跑步").value("movie").endArray()
+            .key("content").value(text_sample)
+            .endObject();
+        if (i) doc += ',';
+        doc += escape_non_ascii ? escapeNonAscii(element) : element;
+    }
+    doc += ']';
+    return doc;
+}
+
+template <typename Fn>
+void run(const std::string& name, size_t bytes_per_op, size_t total_bytes, Fn fn) {
+    size_t iterations = total_bytes / bytes_per_op;
+    if (iterations == 0) iterations = 1;
+    bench::Stopwatch watch;
+    for (size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    bench::report(name, bytes_per_op * iterations, iterations, watch.seconds());
+}
+
+void benchParse(const std::string& name, const std::string& input, size_t total) {
+    utils::JsonDocument doc;
+    if (!doc.parse(input)) {
+        std::fprintf(stderr, "%s: 解析失败: %s\n", name.c_str(), doc.error().c_str());
+        std::exit(1);
+    }
+    run("dom  " + name, input.size(), total, [&]() {
+        doc.parse(input);
+        bench::doNotOptimize(doc.root().size());
+    });
+    NullHandler handler;
+    run("sax  " + name, input.size(), total, [&]() {
+        utils::JsonReader::parse(input, handler);
+        bench::doNotOptimize(handler.events);
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t total = static_cast<size_t>(256.0 * 1024 * 1024 * bench::scaleFromArgs(argc, argv));
+    std::string emoji_cjk = std::string(cjk_sentence) + "😀🎣🏃";
+
+    std::printf("解析 (每项约%zu MB输入)\n", total / (1024 * 1024));
+    benchParse("dashscope response", bench::readFixture("dashscope_response.json"), total);
+    benchParse("dashscope response \\u", bench::readFixture("dashscope_response_escaped.json"), total);
+    benchParse("1MB ascii", makeDocument(repeat(ascii_sentence, 200), 1 << 20, false), total);
+    benchParse("1MB cjk", makeDocument(repeat(cjk_sentence, 200), 1 << 20, false), total);
+    benchParse("1MB cjk \\u escaped", makeDocument(repeat(emoji_cjk, 100), 1 << 20, true), total);
+
+    std::printf("\n反转义\n");
+    std::string out;
+    struct UnescapeCase {
+        const char* name;
+        std::string input;
+    };
+    UnescapeCase unescape_cases[] = {
+        {"64KB ascii, no escapes", repeat(ascii_sentence, 64 * 1024)},
+        {"64KB cjk, no escapes", repeat(cjk_sentence, 64 * 1024)},
+        {"64KB ascii, \\n every 80B", repeat(std::string(ascii_sentence) + "\\n", 64 * 1024)},
+        {"64KB all \\uXXXX + pairs", escapeNonAscii(repeat(emoji_cjk, 64 * 1024))},
+    };
+    for (const auto& c : unescape_cases) {
+        run(std::string("unescape ") + c.name, c.input.size(), total, [&]() {
+            out.clear();
+            utils::JsonReader::unescape(c.input, out);
+            bench::doNotOptimize(out.data());
+        });
+    }
+
+    std::printf("\n转义\n");
+    std::string controls;
+    for (int i = 0; i < 80; ++i) {
+        controls += ascii_sentence[i % 40];
+        if (i % 10 == 0) controls += i % 20 ? '\n' : '"';
+    }
+    struct EscapeCase {
+        const char* name;
+        std::string input;
+    };
+    EscapeCase escape_cases[] = {
+        {"64KB ascii", repeat(ascii_sentence, 64 * 1024)},
+        {"64KB cjk", repeat(cjk_sentence, 64 * 1024)},
+        {"64KB ascii, quote/newline every 10B", repeat(controls, 64 * 1024)},
+        {"2KB chat prompt", bench::readFixture("dashscope_chat_prompt.txt")},
+    };
+    for (const auto& c : escape_cases) {
+        run(std::string("escape ") + c.name, c.input.size(), total, [&]() {
+            out.clear();
+            utils::JsonWriter::appendEscaped(out, c.input);
+            bench::doNotOptimize(out.data());
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,205 @@
+// LongTermMemory启动耗时基准：百万用户快照 + WAL
+//
+// 用法：long_term_bench [规模倍数]
+// 在临时目录中依次运行三个子进程（LongTermMemory是单例，数据文件路径相对于当前目录）：
+//   1. 生成快照：为100万个用户各合并5个关键词，close()时压缩为快照
+//   2. 生成WAL：关闭压缩，更新10%的用户（一半是快照中已有的用户，一半是新用户），
+//      等写线程把更新追加到WAL后直接退出，相当于上次运行未来得及压缩就重启
+//   3. 启动：计时init()（映射快照 + 重放WAL），再计时首批查询——快照中的用户、
+//      WAL中的用户和不存在的用户；同一批快照用户再查一遍作为对照
+// 第3步分别在用posix_fadvise把数据文件逐出页缓存之后（cold）和紧接着再跑一次（warm）测量。
+
+#include "bench_util.h"
+#include "memory/long_term.h"
+#include "utils/config.h"
+#include <cstdlib>
+#include <fcntl.h>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char* const snapshot_path = "./data/long_term_memory.snap";
+const char* const wal_path = "./data/long_term_memory.wal";
+const size_t lookups = 100000;
+
+const char* const topics[] = {
+    "钓鱼", "跑步", "电影", "咖啡", "摄影", "徒步", "围棋", "烘焙", "骑行", "游泳",
+    "露营", "书法", "吉他", "滑雪", "园艺", "旅行", "篮球", "瑜伽", "茶道", "科幻",
+};
+
+std::string userId(size_t i) { return "u-" + std::to_string(10000000 + i); }
+
+// 从2000个关键词（20个主题 × 100个变体）中为用户挑选5个
+std::string keywordsFor(size_t user, size_t round) {
+    std::mt19937 rng(static_cast<uint32_t>(user * 31 + round));
+    std::uniform_int_distribution<int> pick(0, 1999);
+    std::string keywords;
+    for (int k = 0; k < 5; ++k) {
+        int id = pick(rng);
+        if (k) keywords += "，";
+        keywords += topics[id % 20];
+        keywords += std::to_string(id / 20);
+    }
+    return keywords;
+}
+
+size_t fileSize(const char* path) {
+    struct stat st;
+    return ::stat(path, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+void evictFromPageCache(const char* path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+}
+
+// 后台压缩会与被测的重放和查询争用锁，基准中一律关闭，只在close()时压缩
+void disableCompaction() {
+    auto& config = utils::Config::getInstance();
+    config.setString("long_term_compact_interval_sec", "0");
+    config.setString("long_term_compact_wal_bytes", "0");
+    config.setString("long_term_fsync", "never");
+}
+
+void buildSnapshot(size_t users) {
+    disableCompaction();
+    auto& memory = memory::LongTermMemory::getInstance();
+    if (memory.init() != 0) {
+        std::_Exit(1);
+    }
+    bench::Stopwatch watch;
+    for (size_t i = 0; i < users; ++i) {
+        memory.mergeAndSaveLongTerm(userId(i), keywordsFor(i, 0));
+    }
+    double merge_seconds = watch.seconds();
+    watch.restart();
+    memory.close();
+    std::printf("%-40s %10.3f s\n", "merge (写入overlay)", merge_seconds);
+    std::printf("%-40s %10.3f s  (%.1f MB)\n", "close (压缩为快照)", watch.seconds(),
+                static_cast<double>(fileSize(snapshot_path)) / (1024.0 * 1024.0));
+}
+
+void buildWal(size_t users, size_t updates) {
+    disableCompaction();
+    utils::Config::getInstance().setString("long_term_flush_interval_ms", "20");
+    auto& memory = memory::LongTermMemory::getInstance();
+    if (memory.init() != 0) {
+        std::_Exit(1);
+    }
+    for (size_t i = 0; i < updates; ++i) {
+        // 偶数次更新快照中已有的用户，奇数次写入新用户
+        size_t user = i % 2 == 0 ? (i * 7919) % users : users + i;
+        memory.mergeAndSaveLongTerm(userId(user), keywordsFor(user, 1));
+    }
+    // 写线程每20ms追加一批；WAL连续200ms不再增长即视为全部写完，不调用close()以免压缩
+    size_t last = 0;
+    int stable = 0;
+    while (stable < 10) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        size_t size = fileSize(wal_path);
+        stable = size > 0 && size == last ? stable + 1 : 0;
+        last = size;
+    }
+    std::printf("%-40s %10zu 条更新  (%.1f MB)\n", "WAL", updates,
+                static_cast<double>(last) / (1024.0 * 1024.0));
+    std::fflush(stdout);
+    std::_Exit(0);
+}
+
+void runLookups(const char* name, const std::vector<std::string>& ids) {
+    auto& memory = memory::LongTermMemory::getInstance();
+    bench::Stopwatch watch;
+    for (const auto& id : ids) {
+        bench::doNotOptimize(memory.getLongTerm(id).size());
+    }
+    bench::reportOps(name, ids.size(), watch.seconds());
+}
+
+void startup(const char* label, size_t users, size_t updates) {
+    disableCompaction();
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick_snapshot(0, users - 1);
+    std::uniform_int_distribution<size_t> pick_update(0, updates / 2 - 1);
+    std::vector<std::string> snapshot_ids, wal_ids, missing_ids;
+    for (size_t i = 0; i < lookups; ++i) {
+        snapshot_ids.push_back(userId(pick_snapshot(rng)));
+        wal_ids.push_back(userId(users + pick_update(rng) * 2 + 1));
+        missing_ids.push_back("u-missing-" + std::to_string(i));
+    }
+
+    std::printf("\n== 启动 (%s) ==\n", label);
+    bench::Stopwatch watch;
+    if (memory::LongTermMemory::getInstance().init() != 0) {
+        std::_Exit(1);
+    }
+    std::printf("%-40s %10.3f ms\n", "init (mmap快照 + 重放WAL)", watch.seconds() * 1e3);
+    runLookups("first lookups: snapshot users", snapshot_ids);
+    runLookups("first lookups: WAL users", wal_ids);
+    runLookups("first lookups: missing users", missing_ids);
+    runLookups("repeat lookups: snapshot users", snapshot_ids);
+    std::fflush(stdout);
+    std::_Exit(0);   // 不调用close()，保留WAL供下一次启动测量
+}
+
+template <typename Fn>
+bool runChild(const char* name, Fn fn) {
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        fn();
+        std::fflush(stdout);
+        std::_Exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::fprintf(stderr, "%s子进程异常退出\n", name);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double scale = bench::scaleFromArgs(argc, argv);
+    size_t users = static_cast<size_t>(1000000 * scale);
+    if (users < 100) users = 100;
+    size_t updates = users / 10;
+
+    char dir[] = "/tmp/long_term_bench.XXXXXX";
+    if (!mkdtemp(dir) || ::chdir(dir) != 0) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    std::printf("LongTermMemory 启动基准 (快照%zu个用户，WAL %zu条更新，数据目录 %s)\n\n", users, updates, dir);
+
+    bool ok = runChild("生成快照", [&]() { buildSnapshot(users); }) &&
+              runChild("生成WAL", [&]() { buildWal(users, updates); });
+    if (ok) {
+        evictFromPageCache(snapshot_path);
+        evictFromPageCache(wal_path);
+        ok = runChild("启动", [&]() { startup("cold: 数据文件已逐出页缓存", users, updates); }) &&
+             runChild("启动", [&]() { startup("warm: 数据文件在页缓存中", users, updates); });
+    }
+
+    ::unlink(snapshot_path);
+    ::unlink(wal_path);
+    ::rmdir("./data");
+    ::rmdir(dir);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// ShortTermMemory多线程读写竞争基准，对比不同分片数
+//
+// 用法：short_term_bench [规模倍数]
+// ShortTermMemory是单例，分片数（short_term_shards）在构造时确定，因此每个分片数在单独的
+// 子进程中测量。每个场景中各线程对随机会话执行读取（appendShortTermContext，即拼接提示词
+// 的路径）和写入（saveShortTerm），报告总吞吐量：
+//   - uniform：4096个会话均匀访问，读写比90:10和50:50
+//   - hot：所有线程集中访问8个会话，读写比90:10（同一分片内的读取依赖读写锁并发）
+
+#include "bench_util.h"
+#include "memory/short_term.h"
+#include "utils/config.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const int rounds_per_session = 10;
+
+std::string userId(int i) { return "u-" + std::to_string(100000 + i); }
+std::string sessionId(int i) { return "s-" + std::to_string(i) + "-20261016"; }
+
+memory::ChatRound makeRound(int session, int n) {
+    memory::ChatRound round;
+    round.user_id = userId(session);
+    round.session_id = sessionId(session);
+    round.input = "第" + std::to_string(n) + "次提问：周末想去钓鱼，你觉得天气怎么样？顺便推荐一下装备吧";
+    round.reply = "周末天气晴朗，很适合钓鱼！建议带上遮阳帽、折叠椅和足够的饮用水。";
+    round.timestamp = std::chrono::system_clock::now();
+    return round;
+}
+
+void runScenario(const char* name, int sessions, int read_percent, int threads, size_t ops_per_thread) {
+    auto& mem = memory::ShortTermMemory::getInstance();
+    std::vector<std::thread> workers;
+    bench::Stopwatch watch;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&mem, sessions, read_percent, ops_per_thread, t]() {
+            std::mt19937 rng(static_cast<uint32_t>(t + 1));
+            std::uniform_int_distribution<int> pick(0, sessions - 1);
+            std::uniform_int_distribution<int> percent(0, 99);
+            // 会话ID预先生成，避免把字符串构造计入锁竞争的测量
+            std::vector<std::string> users;
+            std::vector<std::string> session_ids;
+            for (int i = 0; i < sessions; ++i) {
+                users.push_back(userId(i));
+                session_ids.push_back(sessionId(i));
+            }
+            std::string prompt;
+            for (size_t i = 0; i < ops_per_thread; ++i) {
+                int s = pick(rng);
+                if (percent(rng) < read_percent) {
+                    prompt.clear();
+                    mem.appendShortTermContext(users[s], session_ids[s], prompt);
+                    bench::doNotOptimize(prompt.size());
+                } else {
+                    mem.saveShortTerm(makeRound(s, static_cast<int>(i)));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = watch.seconds();
+    char label[96];
+    std::snprintf(label, sizeof(label), "%s threads=%d", name, threads);
+    bench::reportOps(label, ops_per_thread * static_cast<size_t>(threads), seconds);
+}
+
+// 在子进程中以指定分片数运行所有场景
+void runWithShards(int shards, double scale) {
+    auto& config = utils::Config::getInstance();
+    config.setString("short_term_shards", std::to_string(shards));
+    config.setString("short_term_max_bytes", "0");   // 不限制内存预算，只测量锁竞争
+    auto& mem = memory::ShortTermMemory::getInstance();
+
+    const int uniform_sessions = 4096;
+    for (int s = 0; s < uniform_sessions; ++s) {
+        for (int n = 0; n < rounds_per_session; ++n) {
+            mem.saveShortTerm(makeRound(s, n));
+        }
+    }
+
+    // 线程数超过CPU核数时结果主要反映调度开销，同时列出核数便于对照
+    int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> thread_counts = {1, 2, 4, 8, 16};
+    if (hardware > 16) {
+        thread_counts.push_back(hardware);
+    }
+    size_t ops = static_cast<size_t>(200000 * scale);
+    if (ops == 0) ops = 1;
+
+    std::printf("\n== short_term_shards=%d (CPU核数 %d) ==\n", shards, hardware);
+    for (int threads : thread_counts) {
+        runScenario("uniform read90", uniform_sessions, 90, threads, ops);
+    }
+    for (int threads : thread_counts) {
+        runScenario("uniform read50", uniform_sessions, 50, threads, ops);
+    }
+    for (int threads : thread_counts) {
+        runScenario("hot(8) read90", 8, 90, threads, ops);
+    }
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double scale = bench::scaleFromArgs(argc, argv);
+    std::printf("ShortTermMemory 竞争基准 (每线程%zu次操作，每会话预置%d轮)\n",
+                static_cast<size_t>(200000 * scale), rounds_per_session);
+    std::fflush(stdout);
+
+    for (int shards : {1, 4, 16, 64}) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            runWithShards(shards, scale);
+            std::_Exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::fprintf(stderr, "分片数%d的子进程异常退出\n", shards);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -3,258 +3,528 @@
 #include "../memory/long_term.h"
 #include "../utils/logger.h"
 #include "../utils/config.h"
-#include "../utils/json_parser.h"
-#include <curl/curl.h>
+#include "../utils/json.h"
+#include "../utils/json_writer.h"
+#include "../utils/http_client.h"
+#include "../utils/sse_parser.h"
+#include "../utils/single_flight.h"
+#include "../utils/metrics.h"
+#include "../utils/trace.h"
 #include <iostream>
+#include <future>
+#include <memory>
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
 #include <cstdio>
-#include <regex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 
 namespace llm {
 
-struct WriteData {
-    std::string data;
+static utils::HttpClientRequest buildRequest(const std::string& api_url,
+                                             const std::string& api_key,
+                                             std::string request_body) {
+    utils::HttpClientRequest request;
+    request.url = api_url;
+    request.headers.push_back("Content-Type: application/json");
+    request.headers.push_back("Authorization: Bearer " + api_key);
+    request.body = std::move(request_body);
+    return request;
+}
+
+static const char* const llm_model = "qwen-turbo";
+// 各路由的模型参数，同时参与缓存键的计算
+static const char* const chat_parameters = "\"temperature\":0.5,\"result_format\":\"message\"";
+static const char* const keywords_parameters = "\"temperature\":0.1,\"result_format\":\"message\",\"max_tokens\":100";
+
+// 构造单轮对话的请求体，parameters为预先序列化的参数成员
+static std::string buildRequestBody(const std::string& prompt, const char* parameters, bool stream) {
+    utils::TraceSpan span("buildRequestBody", "json");
+    utils::JsonWriter json;
+    json.beginObject()
+        .key("model").value(llm_model)
+        .key("input").beginObject()
+            .key("messages").beginArray()
+                .beginObject().key("role").value("user").key("content").value(prompt).endObject()
+            .endArray()
+        .endObject()
+        .key("parameters").beginObject().rawMembers(parameters);
+    if (stream) {
+        json.key("incremental_output").value(true);
+    }
+    json.endObject().endObject();
+    return json.str();
+}
+
+/**
+ * 大模型响应缓存：以(路由, 模型, 参数, 规范化后的提示词)的哈希为键。
+ * 各路由TTL单独配置，为0表示该路由不使用缓存；对话回复温度较高，默认不缓存，
+ * 关键词提取温度低、结果稳定，默认缓存。同键的并发请求合并为一次上游调用。
+ */
+struct ResponseCache {
+    ResponseCache()
+        : results(static_cast<size_t>(std::max(0, utils::Config::getInstance().getInt("llm_cache_max_bytes", 2097152)))),
+          chat_ttl(std::max(0, utils::Config::getInstance().getInt("llm_cache_chat_ttl_sec", 0))),
+          keywords_ttl(std::max(0, utils::Config::getInstance().getInt("llm_cache_keywords_ttl_sec", 600))),
+          lookups(0), upstream_calls(0) {
+    }
+
+    utils::LruCache<std::string> results;
+    utils::SingleFlight<std::string> flights;
+    std::chrono::seconds chat_ttl;
+    std::chrono::seconds keywords_ttl;
+    std::atomic<uint64_t> lookups;
+    std::atomic<uint64_t> upstream_calls;
 };
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t realsize = size * nmemb;
-    WriteData* wd = static_cast<WriteData*>(userp);
-    wd->data.append(static_cast<char*>(contents), realsize);
-    return realsize;
+static ResponseCache& responseCache() {
+    static ResponseCache cache;
+    return cache;
 }
 
-std::string extractHabitKeywords(const std::string& user_id) {
-    auto& short_mem = memory::ShortTermMemory::getInstance();
-    std::string short_context = short_mem.getShortTermContext(user_id);
+// 规范化提示词：合并连续空白、去掉首尾空白，避免仅空白不同的提示词缓存不命中
+static std::string normalizePrompt(const std::string& prompt) {
+    std::string normalized;
+    normalized.reserve(prompt.size());
+    bool pending_space = false;
+    for (char c : prompt) {
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            pending_space = !normalized.empty();
+            continue;
+        }
+        if (pending_space) {
+            normalized.push_back(' ');
+            pending_space = false;
+        }
+        normalized.push_back(c);
+    }
+    return normalized;
+}
+
+static uint64_t responseKey(const char* route, const char* parameters, const std::string& prompt) {
+    return utils::cacheKey({route, llm_model, parameters, normalizePrompt(prompt)});
+}
+
+// 对话请求的上游耗时（取自curl计时，不含缓存命中和排队）
+static utils::Histogram& upstreamSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_llm_upstream_seconds", "对话请求的大模型上游传输耗时");
+    return histogram;
+}
+
+// 一次关键词提取的耗时（含缓存命中和合并等待）
+static utils::Histogram& keywordsSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_llm_keywords_seconds", "extractHabitKeywords从调用到得到关键词的耗时");
+    return histogram;
+}
+
+static void observeUpstream(const utils::HttpClientResponse& response) {
+    if (response.transferOk()) {
+        upstreamSeconds().observeMicros(static_cast<uint64_t>(response.timing.total_us));
+    }
+}
+
+using FetchCallback = std::function<void(const std::string& value, std::exception_ptr error)>;
+
+/**
+ * 经缓存执行一次上游调用：命中时直接回调；未命中时同键的并发调用合并，
+ * 由第一个调用者执行fetch，成功结果按ttl写入缓存。ttl为0时直接执行fetch。
+ */
+static void cachedFetch(uint64_t key, std::chrono::seconds ttl,
+                        std::function<void(FetchCallback)> fetch, FetchCallback done) {
+    auto& cache = responseCache();
+    if (ttl.count() == 0 || !cache.results.enabled()) {
+        cache.upstream_calls++;
+        fetch(std::move(done));
+        return;
+    }
+
+    if (++cache.lookups % 100 == 0) {
+        ResponseCacheStats stats = getResponseCacheStats();
+        LOG_INFO("LLM", "响应缓存统计: 命中率 " + std::to_string(static_cast<int>(stats.cache.hitRatio() * 100)) +
+                 "%, 节省上游调用 " + std::to_string(stats.savedCalls()) +
+                 ", 条目 " + std::to_string(stats.cache.entries) +
+                 ", 占用 " + std::to_string(stats.cache.bytes / 1024) + "KB");
+    }
+
+    std::string value;
+    if (cache.results.get(key, value)) {
+        LOG_DEBUG("LLM", "响应缓存命中");
+        done(value, nullptr);
+        return;
+    }
+    if (!cache.flights.join(key, std::move(done))) {
+        LOG_DEBUG("LLM", "合并相同提示词的请求");
+        return;
+    }
+
+    cache.upstream_calls++;
+    fetch([key, ttl](const std::string& result, std::exception_ptr error) {
+        auto& cache = responseCache();
+        if (!error) {
+            // 条目大小估计：回复内容 + 链表/哈希表节点开销
+            cache.results.put(key, result, result.size() + 128, std::chrono::steady_clock::now() + ttl);
+        }
+        cache.flights.complete(key, result, error);
+    });
+}
+
+ResponseCacheStats getResponseCacheStats() {
+    auto& cache = responseCache();
+    ResponseCacheStats stats;
+    stats.cache = cache.results.stats();
+    stats.coalesced = cache.flights.coalesced();
+    stats.upstream_calls = cache.upstream_calls;
+    return stats;
+}
+
+// 从DashScope响应中取出回复文本：result_format为message时在choices[0].message.content，
+// 否则在output.text；响应不是有效JSON或没有这两个字段时返回空
+static std::string extractReplyContent(const std::string& body) {
+    utils::JsonDocument doc;
+    if (!doc.parse(body)) {
+        LOG_DEBUG("LLM", "响应不是有效的JSON: " + doc.error());
+        return "";
+    }
+    const utils::JsonValue* content = doc.find("output.choices[0].message.content");
+    if (!content || !content->isString()) {
+        content = doc.find("output.text");
+    }
+    return content ? std::string(content->asString()) : "";
+}
+
+// 解析关键词提取响应；上游调用失败时抛出异常（不写入缓存），没有关键词时返回"无"
+static std::string parseKeywordsResponse(const utils::HttpClientResponse& response) {
+    if (!response.transferOk()) {
+        LOG_ERROR("LLM", "调用关键词提取API失败: " + response.error);
+        throw std::runtime_error("调用关键词提取API失败");
+    }
+    
+    if (response.status != 200) {
+        LOG_WARN("LLM", "关键词提取API返回错误状态码: " + std::to_string(response.status));
+        throw std::runtime_error("关键词提取API返回错误，状态码: " + std::to_string(response.status));
+    }
+    
+    std::string keywords = extractReplyContent(response.body);
     
+    if (!keywords.empty()) {
+        // 去除首尾空格
+        keywords.erase(0, keywords.find_first_not_of(" \t\n\r"));
+        keywords.erase(keywords.find_last_not_of(" \t\n\r") + 1);
+        
+        if (keywords.empty() || keywords == "无") {
+            return "无";
+        }
+        return keywords;
+    }
+    
+    LOG_DEBUG("LLM", "关键词提取API响应: " + response.body.substr(0, 300));
+    return "无";
+}
+
+void extractKeywordsFromContextAsync(const std::string& short_context, KeywordsCallback done) {
     std::ostringstream prompt;
-    prompt << "\n请基于用户最近10轮对话上下文，提取其中明确提及的「习惯/爱好」类核心关键词，要求：\n"
+    prompt << "\n请基于用户的近期对话上下文，提取其中明确提及的「习惯/爱好」类核心关键词，要求：\n"
            << "1. 仅返回中文关键词，用逗号分隔，无任何解释、说明或多余文字；\n"
            << "2. 关键词简洁（如：钓鱼、看电影、户外、跑步），不重复；\n"
            << "3. 只提取用户明确提及的内容，不猜测、不编造、不扩展；\n"
            << "4. 无相关习惯/爱好则返回\"无\"。\n\n"
-           << "用户近10轮对话上下文：" << short_context << "\n";
+           << "用户近期对话上下文：" << short_context << "\n";
     
     auto& config = utils::Config::getInstance();
     std::string api_key = config.getString("dashscope_api_key", "");
     if (api_key.empty()) {
         LOG_WARN("LLM", "dashscope_api_key未配置，无法提取关键词");
-        return "无";
+        done("无");
+        return;
     }
     
     std::string api_url = "https://dashscope.aliyuncs.com/api/v1/services/aigc/text-generation/generation";
     
     std::string prompt_str = prompt.str();
-    std::string json_escaped_prompt = utils::JsonParser::escapeJsonString(prompt_str);
-    
-    std::ostringstream json_body;
-    json_body << "{"
-              << "\"model\":\"qwen-turbo\","
-              << "\"input\":{"
-              << "\"messages\":[{"
-              << "\"role\":\"user\","
-              << "\"content\":\"" << json_escaped_prompt << "\""
-              << "}]"
-              << "},"
-              << "\"parameters\":{"
-              << "\"temperature\":0.1,"
-              << "\"result_format\":\"message\","
-              << "\"max_tokens\":100"
-              << "}"
-              << "}";
-    
-    std::string request_body = json_body.str();
+    std::string request_body = buildRequestBody(prompt_str, keywords_parameters, false);
     LOG_DEBUG("LLM", "关键词提取请求体: " + request_body.substr(0, 300));
-    
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        return "无";
+    auto start = std::chrono::steady_clock::now();
+    
+    auto fetch = [api_url, api_key, request_body](FetchCallback fetched) {
+        auto& client = utils::AsyncHttpClient::getInstance();
+        client.send(buildRequest(api_url, api_key, request_body),
+                    [fetched](utils::HttpClientResponse& response) {
+            std::string keywords;
+            try {
+                keywords = parseKeywordsResponse(response);
+            } catch (...) {
+                fetched("", std::current_exception());
+                return;
+            }
+            fetched(keywords, nullptr);
+        });
+    };
+    cachedFetch(responseKey("keywords", keywords_parameters, prompt_str), responseCache().keywords_ttl,
+                fetch, [done, start](const std::string& keywords, std::exception_ptr error) {
+        keywordsSeconds().observeSince(start);
+        done(error ? "无" : keywords);
+    });
+}
+
+void extractHabitKeywordsAsync(const std::string& session_id, const std::string& user_id,
+                               KeywordsCallback done) {
+    auto& short_mem = memory::ShortTermMemory::getInstance();
+    extractKeywordsFromContextAsync(short_mem.getShortTermContext(user_id, session_id), std::move(done));
+}
+
+std::string extractHabitKeywords(const std::string& session_id, const std::string& user_id) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    extractHabitKeywordsAsync(session_id, user_id, [promise](const std::string& keywords) {
+        promise->set_value(keywords);
+    });
+    return future.get();
+}
+
+// 解析大模型响应，失败时抛出异常
+static std::string parseReplyResponse(const utils::HttpClientResponse& response) {
+    if (!response.transferOk()) {
+        LOG_ERROR("LLM", "调用大模型API失败: " + response.error);
+        throw std::runtime_error("调用大模型失败");
     }
     
-    WriteData response_data;
-    
-    // 设置请求头（必须在设置POSTFIELDS之前）
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    std::string auth_header = "Authorization: Bearer " + api_key;
-    headers = curl_slist_append(headers, auth_header.c_str());
-    
-    curl_easy_setopt(curl, CURLOPT_URL, api_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request_body.length()));
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
-    
-    long response_code = 0;
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    
-    if (res != CURLE_OK) {
-        LOG_ERROR("LLM", "调用关键词提取API失败: " + std::string(curl_easy_strerror(res)));
-        return "无";
+    if (response.status != 200) {
+        LOG_ERROR("LLM", "API返回错误状态码: " + std::to_string(response.status));
+        LOG_ERROR("LLM", "响应内容: " + response.body);
+        throw std::runtime_error("API返回错误，状态码: " + std::to_string(response.status));
     }
     
-    if (response_code != 200) {
-        LOG_WARN("LLM", "关键词提取API返回错误状态码: " + std::to_string(response_code));
-        return "无";
-    }
+    // 记录响应内容（用于调试）
+    LOG_DEBUG("LLM", "API响应: " + response.body.substr(0, 500)); // 只记录前500字符
     
-    std::string keywords = utils::JsonParser::extractContentFromNestedJson(response_data.data);
+    std::string reply = extractReplyContent(response.body);
     
-    if (!keywords.empty()) {
-        // 去除首尾空格
-        keywords.erase(0, keywords.find_first_not_of(" \t\n\r"));
-        keywords.erase(keywords.find_last_not_of(" \t\n\r") + 1);
-        
-        if (keywords.empty() || keywords == "无") {
-            return "无";
-        }
-        return keywords;
+    if (reply.empty()) {
+        LOG_ERROR("LLM", "响应格式错误，无法提取回复内容");
+        LOG_ERROR("LLM", "完整响应: " + response.body);
+        throw std::runtime_error("响应格式错误，无法提取回复内容。响应: " + response.body.substr(0, 500));
     }
-    
-    LOG_DEBUG("LLM", "关键词提取API响应: " + response_data.data.substr(0, 300));
-    return "无";
+    return reply;
 }
 
-std::string callLLM(const std::string& /* session_id */,
-                    const std::string& user_id,
-                    const std::string& user_input) {
+// 构造对话请求的提示词（含短期上下文和长期偏好）
+static std::string buildChatPrompt(const std::string& session_id, const std::string& user_id,
+                                   const std::string& user_input) {
+    utils::TraceSpan span("buildChatPrompt", "llm");
     auto& long_mem = memory::LongTermMemory::getInstance();
     auto& short_mem = memory::ShortTermMemory::getInstance();
     
     std::string long_keywords = long_mem.getLongTerm(user_id);
-    std::string long_mem_str = "用户偏好关键词：" + long_keywords;
+    
+    // 固定文本只拷贝一次，短期上下文直接追加在提示词缓冲区中
+    std::string prompt;
+    prompt.reserve(2048 + user_input.size());
+    prompt += "\n你是一个生活化、有同理心的AI助手，核心目标是基于用户的全量对话信息和长期偏好，生成有温度、个性化的回复。\n"
+              "【参考信息】\n"
+              "1. 历史会话上下文（最近若干轮，按时间从旧到新排序）：";
+    short_mem.appendShortTermContext(user_id, session_id, prompt);
+    prompt += "\n"
+              "   - 规则：优先参考近3轮对话内容，确保回复承接上下文，不偏离用户对话逻辑\n"
+              "2. 用户的长期偏好/记忆（核心标签+偏好程度）：";
     if (long_keywords == "无") {
-        long_mem_str = "用户暂无偏好信息";
+        prompt += "用户暂无偏好信息";
+    } else {
+        prompt += "用户偏好关键词：";
+        prompt += long_keywords;
     }
-    
-    std::string short_mem_str = short_mem.getShortTermContext(user_id);
-    
-    std::ostringstream prompt;
-    prompt << "\n你是一个生活化、有同理心的AI助手，核心目标是基于用户的全量对话信息和长期偏好，生成有温度、个性化的回复。\n"
-           << "【参考信息】\n"
-           << "1. 历史会话上下文（最近10轮，按时间从旧到新排序）：" << short_mem_str << "\n"
-           << "   - 规则：优先参考近3轮对话内容，确保回复承接上下文，不偏离用户对话逻辑\n"
-           << "2. 用户的长期偏好/记忆（核心标签+偏好程度）：" << long_mem_str << "\n"
-           << "   - 规则：仅作为个性化补充，不强行关联，避免偏离当前提问核心\n"
-           << "3. 用户当前的提问/输入（含语气倾向）：" << user_input << "\n\n"
-           << "【回复核心要求】\n"
-           << "1. 语气风格：亲切自然，贴合用户当前输入的语气（用户轻松则活泼，用户提问则耐心，用户倾诉则共情）；\n"
-           << "2. 内容要求：优先精准回应当前提问，再自然融入匹配的长期偏好（如用户喜欢钓鱼则可轻提相关）；\n"
-           << "3. 表达规范：避免生硬机器感、套话和模板化回复，用词生活化；\n"
-           << "4. 字数控制：整体回复控制在80-120字，逻辑清晰、语句通顺，无冗余信息；\n"
-           << "5. 避坑点：不编造未提及的偏好，不忽视历史对话中的关键信息，不使用专业术语。\n";
-    
-    LOG_DEBUG("LLM", "Prompt: " + prompt.str());
+    prompt += "\n"
+              "   - 规则：仅作为个性化补充，不强行关联，避免偏离当前提问核心\n"
+              "3. 用户当前的提问/输入（含语气倾向）：";
+    prompt += user_input;
+    prompt += "\n\n"
+              "【回复核心要求】\n"
+              "1. 语气风格：亲切自然，贴合用户当前输入的语气（用户轻松则活泼，用户提问则耐心，用户倾诉则共情）；\n"
+              "2. 内容要求：优先精准回应当前提问，再自然融入匹配的长期偏好（如用户喜欢钓鱼则可轻提相关）；\n"
+              "3. 表达规范：避免生硬机器感、套话和模板化回复，用词生活化；\n"
+              "4. 字数控制：整体回复控制在80-120字，逻辑清晰、语句通顺，无冗余信息；\n"
+              "5. 避坑点：不编造未提及的偏好，不忽视历史对话中的关键信息，不使用专业术语。\n";
+    
+    LOG_DEBUG("LLM", "Prompt: " + prompt);
+    return prompt;
+}
+
+// 构造对话请求体；stream为true时开启增量输出（每个SSE事件只包含新增的内容）
+static std::string buildChatBody(const std::string& prompt, bool stream) {
+    std::string request_body = buildRequestBody(prompt, chat_parameters, stream);
+    LOG_DEBUG("LLM", "请求体: " + request_body.substr(0, 500));
+    return request_body;
+}
+
+void callLLMAsync(const std::string& session_id,
+                  const std::string& user_id,
+                  const std::string& user_input,
+                  ReplyCallback done) {
+    std::string prompt = buildChatPrompt(session_id, user_id, user_input);
     
     auto& config = utils::Config::getInstance();
     std::string api_key = config.getString("dashscope_api_key", "");
     if (api_key.empty()) {
         LOG_ERROR("LLM", "dashscope_api_key未配置");
-        throw std::runtime_error("请先在config.json中配置dashscope_api_key");
+        done("", std::make_exception_ptr(std::runtime_error("请先在config.json中配置dashscope_api_key")));
+        return;
     }
     
     std::string api_url = "https://dashscope.aliyuncs.com/api/v1/services/aigc/text-generation/generation";
-    
-    std::string json_escaped = utils::JsonParser::escapeJsonString(prompt.str());
-    
-    std::ostringstream json_body;
-    json_body << "{"
-              << "\"model\":\"qwen-turbo\","
-              << "\"input\":{"
-              << "\"messages\":[{"
-              << "\"role\":\"user\","
-              << "\"content\":\"" << json_escaped << "\""
-              << "}]"
-              << "},"
-              << "\"parameters\":{"
-              << "\"temperature\":0.5,"
-              << "\"result_format\":\"message\""
-              << "}"
-              << "}";
-    
-    std::string request_body = json_body.str();
-    LOG_DEBUG("LLM", "请求体: " + request_body.substr(0, 500));
 
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error("请求创建失败");
+    std::string request_body = buildChatBody(prompt, false);
+    auto fetch = [api_url, api_key, request_body](FetchCallback fetched) {
+        auto& client = utils::AsyncHttpClient::getInstance();
+        client.send(buildRequest(api_url, api_key, request_body),
+                    [fetched](utils::HttpClientResponse& response) {
+            observeUpstream(response);
+            std::string reply;
+            try {
+                reply = parseReplyResponse(response);
+            } catch (...) {
+                fetched("", std::current_exception());
+                return;
+            }
+            fetched(reply, nullptr);
+        });
+    };
+    cachedFetch(responseKey("chat", chat_parameters, prompt), responseCache().chat_ttl, fetch,
+                [done, user_id](const std::string& reply, std::exception_ptr error) {
+        if (error) {
+            done("", error);
+            return;
+        }
+        // 关键词提取和长期记忆合并由MemoryEnrichment在后台完成，这里直接返回回复
+        LOG_INFO("LLM", "成功生成回复 (用户: " + user_id + ", 长度: " + std::to_string(reply.length()) + ")");
+        done(reply, nullptr);
+    });
+}
+
+// 流式请求的解析状态：on_data在HTTP客户端事件线程中更新，完成回调在传输结束后读取
+struct StreamState {
+    explicit StreamState(TokenCallback cb)
+        : on_token(std::move(cb)),
+          parser([this](const std::string& event, const std::string& data) { onEvent(event, data); }) {
     }
-    
-    WriteData response_data;
-    
-    // 设置请求头（必须在设置POSTFIELDS之前）
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    std::string auth_header = "Authorization: Bearer " + api_key;
-    headers = curl_slist_append(headers, auth_header.c_str());
-    
-    curl_easy_setopt(curl, CURLOPT_URL, api_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request_body.length()));
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
-    
-    long response_code = 0;
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    
-    if (res != CURLE_OK) {
-        LOG_ERROR("LLM", "调用大模型API失败: " + std::string(curl_easy_strerror(res)));
-        throw std::runtime_error("调用大模型失败");
+
+    void onEvent(const std::string& event, const std::string& data) {
+        if (event == "error") {
+            utils::JsonDocument doc;
+            error = doc.parse(data) ? doc.getString("message", data.substr(0, 300)) : data.substr(0, 300);
+            return;
+        }
+        std::string delta = extractReplyContent(data);
+        if (delta.empty()) {
+            return;
+        }
+        reply += delta;
+        if (!cancelled && !on_token(delta)) {
+            cancelled = true;
+        }
     }
+
+    TokenCallback on_token;
+    utils::SseParser parser;
+    std::string reply;
+    std::string error;
+    bool cancelled = false;
+};
+
+void callLLMStreamAsync(const std::string& session_id,
+                        const std::string& user_id,
+                        const std::string& user_input,
+                        TokenCallback on_token,
+                        ReplyCallback done) {
+    std::string prompt = buildChatPrompt(session_id, user_id, user_input);
     
-    if (response_code != 200) {
-        LOG_ERROR("LLM", "API返回错误状态码: " + std::to_string(response_code));
-        LOG_ERROR("LLM", "响应内容: " + response_data.data);
-        throw std::runtime_error("API返回错误，状态码: " + std::to_string(response_code));
+    auto& config = utils::Config::getInstance();
+    std::string api_key = config.getString("dashscope_api_key", "");
+    if (api_key.empty()) {
+        LOG_ERROR("LLM", "dashscope_api_key未配置");
+        done("", std::make_exception_ptr(std::runtime_error("请先在config.json中配置dashscope_api_key")));
+        return;
     }
     
-    // 记录响应内容（用于调试）
-    LOG_DEBUG("LLM", "API响应: " + response_data.data.substr(0, 500)); // 只记录前500字符
-    
-    std::string reply = utils::JsonParser::extractContentFromNestedJson(response_data.data);
+    std::string api_url = "https://dashscope.aliyuncs.com/api/v1/services/aigc/text-generation/generation";
     
-    // 如果上面的方法失败，尝试简单的正则表达式（向后兼容）
-    if (reply.empty()) {
-        // 尝试匹配 message.content 结构
-        std::regex content_regex1(R"xxx("message"\s*:\s*\{[^}]*"content"\s*:\s*"([^"]*)")xxx");
-        std::smatch match1;
-        if (std::regex_search(response_data.data, match1, content_regex1)) {
-            reply = utils::JsonParser::unescapeJsonString(match1[1].str());
-        } else {
-            // 尝试简单的content匹配
-            std::regex content_regex2(R"xxx("content"\s*:\s*"([^"]*)")xxx");
-            std::smatch match2;
-            if (std::regex_search(response_data.data, match2, content_regex2)) {
-                reply = utils::JsonParser::unescapeJsonString(match2[1].str());
+    // 与非流式对话共用缓存条目（增量输出不影响回复内容）；命中时整段作为一个token返回
+    auto& cache = responseCache();
+    uint64_t key = responseKey("chat", chat_parameters, prompt);
+    bool use_cache = cache.chat_ttl.count() > 0 && cache.results.enabled();
+    std::string cached_reply;
+    if (use_cache && cache.results.get(key, cached_reply)) {
+        LOG_DEBUG("LLM", "响应缓存命中（流式）");
+        on_token(cached_reply);
+        done(cached_reply, nullptr);
+        return;
+    }
+    cache.upstream_calls++;
+
+    auto state = std::make_shared<StreamState>(std::move(on_token));
+    utils::HttpClientRequest request = buildRequest(api_url, api_key, buildChatBody(prompt, true));
+    request.headers.push_back("Accept: text/event-stream");
+    request.headers.push_back("X-DashScope-SSE: enable");
+    request.on_data = [state](const char* data, size_t len) {
+        state->parser.feed(data, len);
+        return !state->cancelled;
+    };
+
+    auto& client = utils::AsyncHttpClient::getInstance();
+    client.send(std::move(request), [state, done, user_id, use_cache, key](utils::HttpClientResponse& response) {
+        observeUpstream(response);
+        if (state->cancelled) {
+            LOG_INFO("LLM", "流式回复已取消 (用户: " + user_id + ")");
+            done("", std::make_exception_ptr(std::runtime_error("客户端已断开")));
+            return;
+        }
+        if (!response.transferOk() || response.status != 200) {
+            // 错误响应未走流式解析，按普通响应处理以得到错误信息
+            try {
+                parseReplyResponse(response);
+            } catch (...) {
+                done("", std::current_exception());
+                return;
             }
         }
-    }
-    
-    if (!reply.empty()) {
-        // 提取关键词并更新长期记忆
-        std::string new_keywords = extractHabitKeywords(user_id);
-        if (new_keywords != "无") {
-            LOG_DEBUG("LLM", "提取到用户关键词: " + new_keywords + " (用户: " + user_id + ")");
+        if (!state->error.empty()) {
+            LOG_ERROR("LLM", "流式响应返回错误: " + state->error);
+            done("", std::make_exception_ptr(std::runtime_error("大模型返回错误: " + state->error)));
+            return;
+        }
+        if (state->reply.empty()) {
+            LOG_ERROR("LLM", "流式响应中没有回复内容");
+            done("", std::make_exception_ptr(std::runtime_error("响应格式错误，无法提取回复内容")));
+            return;
         }
-        long_mem.mergeAndSaveLongTerm(user_id, new_keywords);
         
-        LOG_INFO("LLM", "成功生成回复 (用户: " + user_id + ", 长度: " + std::to_string(reply.length()) + ")");
-        return reply;
-    }
-    
-    LOG_ERROR("LLM", "响应格式错误，无法提取回复内容");
-    LOG_ERROR("LLM", "完整响应: " + response_data.data);
-    throw std::runtime_error("响应格式错误，无法提取回复内容。响应: " + response_data.data.substr(0, 500));
+        if (use_cache) {
+            auto& cache = responseCache();
+            cache.results.put(key, state->reply, state->reply.size() + 128,
+                              std::chrono::steady_clock::now() + cache.chat_ttl);
+        }
+        LOG_INFO("LLM", "成功生成流式回复 (用户: " + user_id + ", 长度: " + std::to_string(state->reply.length()) +
+                 ", 首字节: " + std::to_string(response.timing.starttransfer_us / 1000) + "ms)");
+        done(state->reply, nullptr);
+    });
+}
+
+std::string callLLM(const std::string& session_id,
+                    const std::string& user_id,
+                    const std::string& user_input) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    callLLMAsync(session_id, user_id, user_input,
+                 [promise](const std::string& reply, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(reply);
+        }
+    });
+    return future.get();
 }
 
 } // namespace llm
@@ -2,14 +2,58 @@
 #define LLM_H
 
 #include <string>
+#include <functional>
+#include <exception>
+#include "../utils/lru_cache.h"
 
 namespace llm {
 
-std::string extractHabitKeywords(const std::string& user_id);
+// 异步回调：成功时error为空；失败时reply为空，error携带异常
+using ReplyCallback = std::function<void(const std::string& reply, std::exception_ptr error)>;
+// 关键词提取不会失败，出错时返回"无"
+using KeywordsCallback = std::function<void(const std::string& keywords)>;
+// 流式输出：每收到一段新增文本调用一次，返回false取消生成
+using TokenCallback = std::function<bool(const std::string& delta)>;
+
+std::string extractHabitKeywords(const std::string& session_id, const std::string& user_id);
 std::string callLLM(const std::string& session_id, 
                     const std::string& user_id, 
                     const std::string& user_input);
 
+// 异步版本：不阻塞调用线程，回调在HTTP客户端回调线程中执行
+void extractHabitKeywordsAsync(const std::string& session_id, const std::string& user_id,
+                               KeywordsCallback done);
+// 基于给定的对话上下文提取关键词（供后台记忆增强使用）
+void extractKeywordsFromContextAsync(const std::string& short_context, KeywordsCallback done);
+void callLLMAsync(const std::string& session_id,
+                  const std::string& user_id,
+                  const std::string& user_input,
+                  ReplyCallback done);
+
+// 流式版本：开启DashScope增量输出，边接收边回调on_token（在HTTP客户端事件线程中
+// 执行，需快速返回）；生成结束后以完整回复调用done
+void callLLMStreamAsync(const std::string& session_id,
+                        const std::string& user_id,
+                        const std::string& user_input,
+                        TokenCallback on_token,
+                        ReplyCallback done);
+
+/**
+ * @brief 大模型响应缓存统计
+ *
+ * 缓存按路由配置TTL：llm_cache_chat_ttl_sec（对话，默认0即关闭）、
+ * llm_cache_keywords_ttl_sec（关键词提取，默认600秒），共用llm_cache_max_bytes内存预算。
+ */
+struct ResponseCacheStats {
+    utils::LruCacheStats cache;
+    uint64_t coalesced = 0;        // 与进行中的相同请求合并的次数
+    uint64_t upstream_calls = 0;   // 实际发起的上游请求数
+
+    uint64_t savedCalls() const { return cache.hits + coalesced; }
+};
+
+ResponseCacheStats getResponseCacheStats();
+
 } // namespace llm
 
 #endif // LLM_H
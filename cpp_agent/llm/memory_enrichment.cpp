@@ -0,0 +1,207 @@
+#include "memory_enrichment.h"
+#include "llm.h"
+#include "../memory/long_term.h"
+#include "../utils/config.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <future>
+#include <memory>
+
+namespace llm {
+
+// (user_id, session_id)组合键；user_id带长度前缀，任意ID内容都不会产生冲突
+static std::string pendingKey(const std::string& user_id, const std::string& session_id) {
+    std::string key = std::to_string(user_id.size());
+    key.reserve(key.size() + user_id.size() + session_id.size() + 1);
+    key += ':';
+    key += user_id;
+    key += session_id;
+    return key;
+}
+
+MemoryEnrichment::MemoryEnrichment()
+    : capacity_(0), batch_size_(1), drain_timeout_(0), initialized_(false), should_stop_(false),
+      submitted_(0), deduplicated_(0), dropped_(0), processed_(0),
+      last_lag_ms_(0), max_lag_ms_(0) {
+}
+
+MemoryEnrichment::~MemoryEnrichment() {
+    close();
+}
+
+MemoryEnrichment& MemoryEnrichment::getInstance() {
+    static MemoryEnrichment instance;
+    return instance;
+}
+
+int MemoryEnrichment::init() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (initialized_) {
+        return 0;
+    }
+
+    auto& config = utils::Config::getInstance();
+    int threads = config.getInt("enrichment_worker_threads", 2);
+    int capacity = config.getInt("enrichment_queue_capacity", 1024);
+    int batch_size = config.getInt("enrichment_batch_size", 8);
+    int drain_timeout_ms = config.getInt("enrichment_drain_timeout_ms", 5000);
+    capacity_ = capacity > 0 ? static_cast<size_t>(capacity) : 1;
+    batch_size_ = batch_size > 0 ? static_cast<size_t>(batch_size) : 1;
+    drain_timeout_ = std::chrono::milliseconds(std::max(0, drain_timeout_ms));
+    if (threads <= 0) {
+        threads = 1;
+    }
+
+    should_stop_ = false;
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back(&MemoryEnrichment::workerLoop, this);
+    }
+
+    initialized_ = true;
+    LOG_INFO("Enrichment", "记忆增强流水线初始化完成 (线程: " + std::to_string(threads) +
+             ", 队列容量: " + std::to_string(capacity_) +
+             ", 批大小: " + std::to_string(batch_size_) + ")");
+    return 0;
+}
+
+void MemoryEnrichment::close() {
+    if (!initialized_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        should_stop_ = true;
+        drain_deadline_ = std::chrono::steady_clock::now() + drain_timeout_;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+    initialized_ = false;
+}
+
+bool MemoryEnrichment::submit(const std::string& user_id, const std::string& session_id,
+                              const std::string& context) {
+    if (!initialized_) {
+        return false;
+    }
+
+    std::string key = pendingKey(user_id, session_id);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        submitted_++;
+
+        auto it = pending_.find(key);
+        if (it != pending_.end()) {
+            // 同一会话已有待处理任务：只更新上下文，保留原提交时间
+            it->second.context = context;
+            it->second.log_context = utils::LogContext::current();
+            deduplicated_++;
+            return true;
+        }
+
+        if (pending_.size() >= capacity_) {
+            dropped_++;
+            LOG_WARN("Enrichment", "记忆增强队列已满，丢弃任务 (用户: " + user_id +
+                     ", 会话: " + session_id + ")");
+            return false;
+        }
+
+        Job job;
+        job.user_id = user_id;
+        job.session_id = session_id;
+        job.context = context;
+        job.enqueued_at = std::chrono::steady_clock::now();
+        job.log_context = utils::LogContext::current();
+        order_.push_back(key);
+        pending_.emplace(std::move(key), std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+EnrichmentStats MemoryEnrichment::getStats() const {
+    EnrichmentStats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.queue_depth = pending_.size();
+    }
+    stats.submitted = submitted_;
+    stats.deduplicated = deduplicated_;
+    stats.dropped = dropped_;
+    stats.processed = processed_;
+    stats.last_lag_ms = last_lag_ms_;
+    stats.max_lag_ms = max_lag_ms_;
+    return stats;
+}
+
+void MemoryEnrichment::workerLoop() {
+    while (true) {
+        std::vector<Job> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return should_stop_ || !order_.empty(); });
+            if (order_.empty()) {
+                break; // should_stop_ 且队列已清空
+            }
+            // 关闭时每个任务都是一次大模型请求，超过截止时间就放弃剩余任务，避免退出被拖住
+            if (should_stop_ && std::chrono::steady_clock::now() >= drain_deadline_) {
+                size_t remaining = order_.size();
+                dropped_ += remaining;
+                order_.clear();
+                pending_.clear();
+                LOG_WARN("Enrichment", "关闭超时，丢弃 " + std::to_string(remaining) + " 个未处理的记忆增强任务");
+                break;
+            }
+            while (!order_.empty() && batch.size() < batch_size_) {
+                auto it = pending_.find(order_.front());
+                order_.pop_front();
+                batch.push_back(std::move(it->second));
+                pending_.erase(it);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (const auto& job : batch) {
+            uint64_t lag = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                now - job.enqueued_at).count());
+            last_lag_ms_ = lag;
+            uint64_t max_lag = max_lag_ms_;
+            while (lag > max_lag && !max_lag_ms_.compare_exchange_weak(max_lag, lag)) {
+            }
+        }
+
+        processBatch(batch);
+    }
+}
+
+void MemoryEnrichment::processBatch(std::vector<Job>& batch) {
+    // 批内任务并发发起提取请求，全部返回后再逐个合并到长期记忆
+    std::vector<std::future<std::string>> results;
+    results.reserve(batch.size());
+    for (const auto& job : batch) {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        results.push_back(promise->get_future());
+        utils::ScopedLogContext log_scope(job.log_context);
+        extractKeywordsFromContextAsync(job.context, [promise](const std::string& keywords) {
+            promise->set_value(keywords);
+        });
+    }
+
+    auto& long_mem = memory::LongTermMemory::getInstance();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        std::string new_keywords = results[i].get();
+        utils::ScopedLogContext log_scope(batch[i].log_context);
+        if (new_keywords != "无") {
+            LOG_DEBUG("Enrichment", "提取到用户关键词: " + new_keywords + " (用户: " + batch[i].user_id + ")");
+            long_mem.mergeAndSaveLongTerm(batch[i].user_id, new_keywords);
+        }
+        processed_++;
+    }
+}
+
+} // namespace llm
@@ -0,0 +1,98 @@
+#ifndef MEMORY_ENRICHMENT_H
+#define MEMORY_ENRICHMENT_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include "../utils/logger.h"
+
+namespace llm {
+
+/**
+ * @brief 记忆增强队列统计
+ */
+struct EnrichmentStats {
+    size_t queue_depth = 0;        // 等待处理的任务数
+    uint64_t submitted = 0;        // 提交次数
+    uint64_t deduplicated = 0;     // 与同一会话待处理任务合并的次数
+    uint64_t dropped = 0;          // 队列已满或关闭时来不及处理而被丢弃的任务数
+    uint64_t processed = 0;        // 已完成的任务数
+    uint64_t last_lag_ms = 0;      // 最近一个任务从提交到开始处理的延迟
+    uint64_t max_lag_ms = 0;
+};
+
+/**
+ * @brief 后台记忆增强流水线
+ *
+ * 聊天回复返回后，把(user_id, session_id, 对话上下文)提交到有界队列，由后台工作线程
+ * 调用大模型提取习惯/爱好关键词并合并到长期记忆，不占用聊天请求的响应时间。
+ * - 同一会话的待处理任务会合并，只保留最新的上下文；同一用户的不同会话各自排队
+ * - 工作线程每次最多取enrichment_batch_size个任务，并发发起提取请求
+ * - 队列满（enrichment_queue_capacity）时丢弃新任务并计数
+ * - close()后继续处理剩余任务，最多enrichment_drain_timeout_ms，超时后丢弃剩余任务并计数
+ */
+class MemoryEnrichment {
+public:
+    static MemoryEnrichment& getInstance();
+
+    int init();
+    void close();
+
+    /**
+     * @brief 提交一个关键词提取任务
+     * @param user_id 用户ID
+     * @param session_id 会话ID
+     * @param context 该会话的近期对话上下文
+     * @return 队列已满或未初始化时返回false
+     */
+    bool submit(const std::string& user_id, const std::string& session_id, const std::string& context);
+
+    EnrichmentStats getStats() const;
+
+private:
+    MemoryEnrichment();
+    ~MemoryEnrichment();
+    MemoryEnrichment(const MemoryEnrichment&) = delete;
+    MemoryEnrichment& operator=(const MemoryEnrichment&) = delete;
+
+    struct Job {
+        std::string user_id;
+        std::string session_id;
+        std::string context;
+        std::chrono::steady_clock::time_point enqueued_at;
+        utils::LogContextPtr log_context;   // 提交时所在请求的日志上下文
+    };
+
+    void workerLoop();
+    void processBatch(std::vector<Job>& batch);
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> order_;                  // 待处理会话键，按提交顺序
+    std::unordered_map<std::string, Job> pending_;   // (user_id, session_id)键 -> 待处理任务
+    std::vector<std::thread> workers_;
+
+    size_t capacity_;
+    size_t batch_size_;
+    std::chrono::milliseconds drain_timeout_;
+    std::chrono::steady_clock::time_point drain_deadline_;   // close()之后排空队列的截止时间
+
+    std::atomic<bool> initialized_;
+    std::atomic<bool> should_stop_;
+    std::atomic<uint64_t> submitted_;
+    std::atomic<uint64_t> deduplicated_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> processed_;
+    std::atomic<uint64_t> last_lag_ms_;
+    std::atomic<uint64_t> max_lag_ms_;
+};
+
+} // namespace llm
+
+#endif // MEMORY_ENRICHMENT_H
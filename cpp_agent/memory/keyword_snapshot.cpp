@@ -0,0 +1,227 @@
+#include "keyword_snapshot.h"
+#include "../utils/logger.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace memory {
+
+static constexpr char snapshot_magic[8] = {'L', 'T', 'M', 'S', 'N', 'A', 'P', '1'};
+static constexpr uint32_t snapshot_version = 1;
+static constexpr size_t header_size = 32;
+static constexpr size_t entry_size = 16;
+static constexpr size_t write_buffer_size = 1 << 20;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t index_offset;
+};
+static_assert(sizeof(SnapshotHeader) == header_size, "快照头部必须是32字节");
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+SnapshotReader::SnapshotReader()
+    : data_(nullptr), file_size_(0), count_(0), index_offset_(0) {
+}
+
+SnapshotReader::~SnapshotReader() {
+    close();
+}
+
+int SnapshotReader::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        LOG_ERROR("LongTermMemory", "打开快照失败: " + std::string(strerror(errno)));
+        return -1;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size) {
+        ::close(fd);
+        LOG_ERROR("LongTermMemory", "快照文件不完整: " + path);
+        return -1;
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+    void* mapped = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        LOG_ERROR("LongTermMemory", "映射快照失败: " + std::string(strerror(errno)));
+        return -1;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+    bool valid = std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) == 0 &&
+                 header.version == snapshot_version &&
+                 header.index_offset >= header_size && header.index_offset % 8 == 0 &&
+                 header.index_offset <= file_size &&
+                 header.count == (file_size - header.index_offset) / entry_size &&
+                 (file_size - header.index_offset) % entry_size == 0;
+    if (!valid) {
+        ::munmap(mapped, file_size);
+        LOG_ERROR("LongTermMemory", "快照格式错误: " + path);
+        return -1;
+    }
+
+    // 查找是二分的随机访问，关闭预读
+    ::madvise(mapped, file_size, MADV_RANDOM);
+    data_ = static_cast<const char*>(mapped);
+    file_size_ = file_size;
+    count_ = static_cast<size_t>(header.count);
+    index_offset_ = static_cast<size_t>(header.index_offset);
+    return 0;
+}
+
+void SnapshotReader::close() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), file_size_);
+    }
+    data_ = nullptr;
+    file_size_ = 0;
+    count_ = 0;
+    index_offset_ = 0;
+}
+
+void SnapshotReader::swap(SnapshotReader& other) {
+    std::swap(data_, other.data_);
+    std::swap(file_size_, other.file_size_);
+    std::swap(count_, other.count_);
+    std::swap(index_offset_, other.index_offset_);
+}
+
+const SnapshotReader::Entry* SnapshotReader::entry(size_t i) const {
+    const Entry* e = reinterpret_cast<const Entry*>(data_ + index_offset_ + i * entry_size);
+    // 数据区越界的条目视为损坏，当作空条目
+    if (e->offset < header_size || e->offset > index_offset_ ||
+        index_offset_ - e->offset < static_cast<uint64_t>(e->key_size) + e->value_size) {
+        return nullptr;
+    }
+    return e;
+}
+
+std::string_view SnapshotReader::key(size_t i) const {
+    const Entry* e = entry(i);
+    return e ? std::string_view(data_ + e->offset, e->key_size) : std::string_view();
+}
+
+std::string_view SnapshotReader::value(size_t i) const {
+    const Entry* e = entry(i);
+    return e ? std::string_view(data_ + e->offset + e->key_size, e->value_size) : std::string_view();
+}
+
+bool SnapshotReader::find(std::string_view key, std::string_view& value) const {
+    size_t lo = 0;
+    size_t hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = this->key(mid).compare(key);
+        if (cmp == 0) {
+            value = this->value(mid);
+            return true;
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+SnapshotWriter::SnapshotWriter()
+    : fd_(-1), offset_(0), count_(0) {
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool SnapshotWriter::open(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR("LongTermMemory", "创建快照文件失败: " + std::string(strerror(errno)));
+        return false;
+    }
+    // 头部在finish时回填
+    buffer_.assign(header_size, '\0');
+    buffer_.reserve(write_buffer_size);
+    offset_ = header_size;
+    return true;
+}
+
+bool SnapshotWriter::flushBuffer() {
+    if (!writeAll(fd_, buffer_.data(), buffer_.size())) {
+        LOG_ERROR("LongTermMemory", "写快照失败: " + std::string(strerror(errno)));
+        return false;
+    }
+    buffer_.clear();
+    return true;
+}
+
+bool SnapshotWriter::add(std::string_view key, std::string_view value) {
+    char entry[entry_size];
+    uint32_t key_size = static_cast<uint32_t>(key.size());
+    uint32_t value_size = static_cast<uint32_t>(value.size());
+    std::memcpy(entry, &offset_, 8);
+    std::memcpy(entry + 8, &key_size, 4);
+    std::memcpy(entry + 12, &value_size, 4);
+    index_.insert(index_.end(), entry, entry + entry_size);
+
+    buffer_.append(key.data(), key.size());
+    buffer_.append(value.data(), value.size());
+    offset_ += key.size() + value.size();
+    count_++;
+    return buffer_.size() < write_buffer_size || flushBuffer();
+}
+
+bool SnapshotWriter::finish() {
+    // 索引按8字节对齐，映射后可直接按结构体访问
+    size_t padding = (8 - offset_ % 8) % 8;
+    buffer_.append(padding, '\0');
+    SnapshotHeader header;
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.reserved = 0;
+    header.count = count_;
+    header.index_offset = offset_ + padding;
+
+    bool ok = flushBuffer() && writeAll(fd_, index_.data(), index_.size());
+    if (ok && ::pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        ok = false;
+    }
+    if (ok && ::fsync(fd_) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        LOG_ERROR("LongTermMemory", "写快照失败: " + std::string(strerror(errno)));
+    }
+    ::close(fd_);
+    fd_ = -1;
+    return ok;
+}
+
+} // namespace memory
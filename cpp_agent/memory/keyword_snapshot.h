@@ -0,0 +1,79 @@
+#ifndef KEYWORD_SNAPSHOT_H
+#define KEYWORD_SNAPSHOT_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace memory {
+
+/**
+ * @brief 长期记忆二进制快照
+ *
+ * 文件布局（主机字节序）：
+ *   [头部 32字节: magic "LTMSNAP1", u32 版本, u32 保留, u64 条目数, u64 索引偏移]
+ *   [数据区: 每个条目的user_id紧跟keywords]
+ *   [索引: 按user_id升序排列的 {u64 数据偏移, u32 user_id长度, u32 keywords长度}]
+ * 读取时整体mmap，打开只校验头部和文件大小（O(1)），查找在索引上二分，条目在访问时做边界检查。
+ */
+class SnapshotReader {
+public:
+    SnapshotReader();
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    // 打开并映射快照，成功返回0；文件不存在返回1；格式错误返回-1
+    int open(const std::string& path);
+    void close();
+    // 交换两个快照的映射（用于压缩后原子地切换到新快照）
+    void swap(SnapshotReader& other);
+
+    size_t size() const { return count_; }
+    std::string_view key(size_t i) const;
+    std::string_view value(size_t i) const;
+    bool find(std::string_view key, std::string_view& value) const;
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint32_t key_size;
+        uint32_t value_size;
+    };
+
+    const Entry* entry(size_t i) const;
+
+    const char* data_;
+    size_t file_size_;
+    size_t count_;
+    size_t index_offset_;
+};
+
+/**
+ * @brief 顺序写出快照：add必须按user_id升序调用，finish写索引和头部并fsync
+ */
+class SnapshotWriter {
+public:
+    SnapshotWriter();
+    ~SnapshotWriter();
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool add(std::string_view key, std::string_view value);
+    bool finish();
+
+private:
+    bool flushBuffer();
+
+    int fd_;
+    uint64_t offset_;
+    std::string buffer_;
+    std::vector<char> index_;
+    uint64_t count_;
+};
+
+} // namespace memory
+
+#endif // KEYWORD_SNAPSHOT_H
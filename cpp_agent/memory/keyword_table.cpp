@@ -0,0 +1,56 @@
+#include "keyword_table.h"
+#include <algorithm>
+
+namespace memory {
+
+uint32_t KeywordTable::intern(std::string_view text) {
+    auto it = ids_.find(text);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(texts_.size());
+    texts_.emplace_back(text);
+    ids_.emplace(texts_.back(), id);
+    return id;
+}
+
+void mergeKeywords(KeywordList& list, const std::vector<uint32_t>& new_ids, int64_t now, size_t max_keys) {
+    // 同一用户的强化时间严格递增，同一毫秒内的多次合并也能分出先后
+    for (const auto& entry : list) {
+        now = std::max(now, entry.last_seen + 1);
+    }
+
+    // 两个有序序列归并，O(k)
+    KeywordList merged;
+    merged.reserve(list.size() + new_ids.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < list.size() || j < new_ids.size()) {
+        if (j == new_ids.size() || (i < list.size() && list[i].id < new_ids[j])) {
+            merged.push_back(list[i++]);
+        } else if (i == list.size() || new_ids[j] < list[i].id) {
+            merged.push_back(KeywordEntry{new_ids[j++], 1, now});
+        } else {
+            KeywordEntry entry = list[i++];
+            entry.count++;
+            entry.last_seen = now;
+            merged.push_back(entry);
+            j++;
+        }
+    }
+
+    if (merged.size() > max_keys) {
+        // 选出要保留的max_keys个（最近被强化的优先），再恢复按id排序
+        std::nth_element(merged.begin(), merged.begin() + max_keys, merged.end(),
+                         [](const KeywordEntry& a, const KeywordEntry& b) {
+                             if (a.last_seen != b.last_seen) return a.last_seen > b.last_seen;
+                             return a.count > b.count;
+                         });
+        merged.resize(max_keys);
+        std::sort(merged.begin(), merged.end(),
+                  [](const KeywordEntry& a, const KeywordEntry& b) { return a.id < b.id; });
+    }
+    list.swap(merged);
+}
+
+} // namespace memory
@@ -0,0 +1,49 @@
+#ifndef KEYWORD_TABLE_H
+#define KEYWORD_TABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+namespace memory {
+
+/**
+ * @brief 用户的一个偏好关键词：被强化的次数和最近一次被强化的时间（Unix毫秒）
+ */
+struct KeywordEntry {
+    uint32_t id;
+    uint32_t count;
+    int64_t last_seen;
+};
+
+// 按关键词id升序排列，合并时做有序集合的并
+using KeywordList = std::vector<KeywordEntry>;
+
+/**
+ * @brief 全局关键词驻留表：同一个关键词只保存一份文本，用户记录中只存id
+ *
+ * 非线程安全，由LongTermMemory在mutex_内访问；id一经分配不会回收。
+ */
+class KeywordTable {
+public:
+    uint32_t intern(std::string_view text);
+    std::string_view text(uint32_t id) const { return texts_[id]; }
+    size_t size() const { return texts_.size(); }
+
+private:
+    std::deque<std::string> texts_;                      // deque追加时不移动已有元素，键可以引用其中的文本
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+/**
+ * @brief 把new_ids（已排序去重）并入list：已有的关键词计数加一并刷新时间，新的关键词追加；
+ * 超过max_keys时淘汰最久未被强化的关键词（时间相同时淘汰计数少的）
+ */
+void mergeKeywords(KeywordList& list, const std::vector<uint32_t>& new_ids, int64_t now, size_t max_keys);
+
+} // namespace memory
+
+#endif // KEYWORD_TABLE_H
@@ -1,12 +1,18 @@
 #include "long_term.h"
 #include "../utils/logger.h"
+#include "../utils/config.h"
+#include "../utils/json.h"
+#include "../utils/metrics.h"
+#include "../utils/trace.h"
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 #include <iostream>
-#include <regex>
+#include <array>
 #include <cstring>
 #include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
 #if __cplusplus >= 201703L && defined(__has_include)
   #if __has_include(<filesystem>)
     #include <filesystem>
@@ -22,8 +28,153 @@
 
 namespace memory {
 
+// WAL记录格式（主机字节序）：[u32 负载长度][u32 负载CRC32][u32 user_id长度][user_id][keywords]
+// 每条记录是该用户更新后的完整关键词，重放是幂等的
+static constexpr size_t wal_header_size = 8;
+static constexpr uint32_t max_wal_record = 16 * 1024 * 1024;
+
+// 写线程一次落盘（追加WAL，按策略fsync）和一次压缩的耗时，只统计有数据要写的轮次
+static utils::Histogram& flushSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_long_term_flush_seconds", "长期记忆一次批量写WAL（含按策略fsync）的耗时");
+    return histogram;
+}
+
+static utils::Histogram& compactSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_long_term_compact_seconds", "长期记忆一次压缩为快照的耗时");
+    return histogram;
+}
+
+static constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> crc_table = makeCrcTable();
+
+static uint32_t crc32(const char* data, size_t size) {
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        c = crc_table[(c ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+static void appendU32(std::string& out, uint32_t value) {
+    char buf[sizeof(value)];
+    std::memcpy(buf, &value, sizeof(value));
+    out.append(buf, sizeof(buf));
+}
+
+static uint32_t readU32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void appendWalRecord(std::string& out, const std::string& user_id, const std::string& keywords) {
+    uint32_t payload_size = static_cast<uint32_t>(4 + user_id.size() + keywords.size());
+    size_t start = out.size();
+    out.reserve(start + wal_header_size + payload_size);
+    appendU32(out, payload_size);
+    appendU32(out, 0);   // CRC占位，负载写完后回填
+    appendU32(out, static_cast<uint32_t>(user_id.size()));
+    out += user_id;
+    out += keywords;
+    uint32_t crc = crc32(out.data() + start + wal_header_size, payload_size);
+    std::memcpy(&out[start + 4], &crc, sizeof(crc));
+}
+
+// 旧版JSON文件的宽松读取：依次匹配 "key" : "value"，字符串以下一个'"'结束、不做反转义，
+// 与旧版的读写方式一致。返回读取到的键值对数
+template <typename Fn>
+static size_t scanLegacyPairs(std::string_view content, Fn&& fn) {
+    auto skipSpace = [&content](size_t pos) {
+        while (pos < content.size() && std::isspace(static_cast<unsigned char>(content[pos]))) {
+            pos++;
+        }
+        return pos;
+    };
+    size_t pairs = 0;
+    size_t pos = 0;
+    while ((pos = content.find('"', pos)) != std::string_view::npos) {
+        size_t key_end = content.find('"', pos + 1);
+        if (key_end == std::string_view::npos) {
+            break;
+        }
+        size_t colon = skipSpace(key_end + 1);
+        if (key_end == pos + 1 || colon >= content.size() || content[colon] != ':') {
+            pos = key_end;   // 不是键，从结尾的引号重新开始匹配
+            continue;
+        }
+        size_t value_start = skipSpace(colon + 1);
+        if (value_start >= content.size() || content[value_start] != '"') {
+            pos = value_start;
+            continue;
+        }
+        size_t value_end = content.find('"', value_start + 1);
+        if (value_end == std::string_view::npos) {
+            break;
+        }
+        fn(content.substr(pos + 1, key_end - pos - 1),
+           content.substr(value_start + 1, value_end - value_start - 1));
+        pairs++;
+        pos = value_end + 1;
+    }
+    return pairs;
+}
+
+// 写满size字节，被信号中断时重试
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// rename之后fsync所在目录，保证目录项本身落盘
+static void syncParentDir(const std::string& path) {
+    fs::path parent = fs::path(path).parent_path();
+    int fd = ::open(parent.empty() ? "." : parent.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
 LongTermMemory::LongTermMemory() 
-    : initialized_(false), should_stop_(false) {
+    : wal_fd_(-1), wal_bytes_(0), wal_unsynced_(false), initialized_(false), should_stop_(false),
+      dirty_changes_(0), pending_seq_(0), committed_seq_(0) {
+    auto& config = utils::Config::getInstance();
+    std::string policy = config.getString("long_term_fsync", "interval");
+    if (policy == "always") {
+        fsync_policy_ = FsyncPolicy::Always;
+    } else if (policy == "never") {
+        fsync_policy_ = FsyncPolicy::Never;
+    } else {
+        fsync_policy_ = FsyncPolicy::Interval;
+    }
+    fsync_interval_ms_ = std::max(1, config.getInt("long_term_fsync_interval_ms", 1000));
+    flush_interval_ms_ = std::max(1, config.getInt("long_term_flush_interval_ms", 200));
+    flush_max_changes_ = static_cast<size_t>(std::max(1, config.getInt("long_term_flush_max_changes", 256)));
+    compact_interval_sec_ = std::max(0, config.getInt("long_term_compact_interval_sec", 300));
+    compact_wal_bytes_ = static_cast<size_t>(std::max(0, config.getInt("long_term_compact_wal_bytes", 4194304)));
 }
 
 LongTermMemory::~LongTermMemory() {
@@ -43,30 +194,73 @@ int LongTermMemory::init() {
     }
     
     // 创建数据目录
-    fs::path file_path(persist_file);
+    fs::path file_path(snapshot_file);
     fs::create_directories(file_path.parent_path());
     
-    // 加载历史数据
+    // 映射快照（不存在时从旧的JSON文件迁移），再重放快照之后的更新
     if (loadFromFile() != 0) {
         LOG_WARN("LongTermMemory", "加载数据失败，将使用空存储");
-        store_.clear();
+        snapshot_.close();
+        overlay_.clear();
+    }
+    if (replayWal() != 0 || openWal() != 0) {
+        return -1;
     }
     
     // 启动异步写文件线程
     should_stop_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+    last_compact_ = last_sync_;
     write_thread_ = std::thread(&LongTermMemory::asyncWriteLoop, this);
     
     initialized_ = true;
-    LOG_INFO("LongTermMemory", "长期记忆模块初始化完成");
+    LOG_INFO("LongTermMemory", "长期记忆模块初始化完成 (快照用户数: " + std::to_string(snapshot_.size()) +
+             ", 未压缩的更新: " + std::to_string(overlay_.size()) + ")");
     return 0;
 }
 
 int LongTermMemory::loadFromFile() {
-    std::ifstream file(persist_file);
+    int rc = snapshot_.open(snapshot_file);
+    if (rc < 0) {
+        // 保留损坏的快照供排查，避免下次压缩时被覆盖
+        std::string corrupt = std::string(snapshot_file) + ".corrupt";
+        ::rename(snapshot_file, corrupt.c_str());
+        LOG_ERROR("LongTermMemory", "快照无法读取，已重命名为 " + corrupt);
+        return -1;
+    }
+    if (rc == 0) {
+        return 0;
+    }
+    // 快照不存在：有旧版JSON文件时迁移为二进制快照
+    if (!fs::exists(legacy_file)) {
+        return 0;
+    }
+    if (loadLegacyJson() != 0) {
+        // 保留无法迁移的JSON供排查；不改名的话之后写出的快照会让它再也不被读取
+        overlay_.clear();
+        std::string corrupt = std::string(legacy_file) + ".corrupt";
+        ::rename(legacy_file, corrupt.c_str());
+        LOG_ERROR("LongTermMemory", "旧版JSON文件无法迁移，已重命名为 " + corrupt);
+        return -1;
+    }
+    size_t migrated = overlay_.size();
+    if (saveToFile(encodeOverlayLocked(nullptr)) != 0 || snapshot_.open(snapshot_file) != 0) {
+        // 迁移失败时数据仍在overlay_中，下次压缩会再写快照
+        return 0;
+    }
+    overlay_.clear();
+    std::string backup = std::string(legacy_file) + ".migrated";
+    if (::rename(legacy_file, backup.c_str()) != 0) {
+        LOG_WARN("LongTermMemory", "重命名旧版JSON文件失败: " + std::string(strerror(errno)));
+    }
+    LOG_INFO("LongTermMemory", "已将 " + std::to_string(migrated) + " 个用户从JSON迁移为二进制快照，原文件保留为 " + backup);
+    return 0;
+}
+
+int LongTermMemory::loadLegacyJson() {
+    std::ifstream file(legacy_file);
     if (!file.is_open()) {
-        // 文件不存在，初始化空存储
-        store_.clear();
-        return saveToFile();
+        return -1;
     }
     
     std::string content((std::istreambuf_iterator<char>(file)),
@@ -74,207 +268,552 @@ int LongTermMemory::loadFromFile() {
     file.close();
     
     if (content.empty()) {
-        store_.clear();
         return 0;
     }
     
-    // 简单的JSON解析（仅处理简单的key-value map）
     // 格式: {"user_id": "keywords", ...}
-    store_.clear();
-    
-    // 移除空格和换行
-    content.erase(std::remove_if(content.begin(), content.end(),
-        [](char c) { return std::isspace(c); }), content.end());
-    
-    // 移除外层大括号
-    if (content.front() == '{') content.erase(0, 1);
-    if (content.back() == '}') content.pop_back();
-    
-    // 解析键值对
-    std::regex pair_regex(R"xxx("([^"]+)"\s*:\s*"([^"]*)")xxx");
-    std::sregex_iterator iter(content.begin(), content.end(), pair_regex);
-    std::sregex_iterator end;
-    
-    for (; iter != end; ++iter) {
-        std::smatch match = *iter;
-        store_[match[1].str()] = match[2].str();
+    utils::JsonDocument doc;
+    if (doc.parse(content) && doc.root().isObject()) {
+        const utils::JsonValue& root = doc.root();
+        for (size_t i = 0; i < root.size(); ++i) {
+            const utils::JsonMember& member = root.member(i);
+            if (member.value.isString()) {
+                overlay_[std::string(member.key)] = decodeLocked(member.value.asString());
+            }
+        }
+        return 0;
     }
     
+    // 旧版写文件时没有转义，关键词中的'\'或控制字符会让严格解析失败；
+    // 此时按旧版读取方式逐个扫描"key": "value"，值原样保留
+    LOG_WARN("LongTermMemory", "长期记忆文件不是合法JSON (" +
+             (doc.error().empty() ? std::string("顶层不是JSON对象") : doc.error()) + ")，按旧格式逐项读取");
+    size_t pairs = scanLegacyPairs(content, [this](std::string_view key, std::string_view value) {
+        overlay_[std::string(key)] = decodeLocked(value);
+    });
+    if (pairs == 0 && content.find_first_not_of(" \t\r\n{}") != std::string::npos) {
+        return -1;
+    }
     return 0;
 }
 
-int LongTermMemory::saveToFile() {
-    std::ofstream file(persist_file);
-    if (!file.is_open()) {
+int LongTermMemory::saveToFile(const std::map<std::string, std::string>& updates) {
+    // 当前快照与更新按user_id归并，顺序写出新快照；
+    // 先写临时文件并fsync，再rename覆盖，崩溃时旧快照保持完整
+    std::string tmp_path = std::string(snapshot_file) + ".tmp";
+    SnapshotWriter writer;
+    if (!writer.open(tmp_path)) {
+        return -1;
+    }
+    bool ok = true;
+    size_t i = 0;
+    auto it = updates.begin();
+    while (ok && (i < snapshot_.size() || it != updates.end())) {
+        std::string_view key = i < snapshot_.size() ? snapshot_.key(i) : std::string_view();
+        int cmp = i >= snapshot_.size() ? 1 : (it == updates.end() ? -1 : key.compare(it->first));
+        if (cmp < 0) {
+            ok = writer.add(key, snapshot_.value(i));
+            i++;
+        } else {
+            ok = writer.add(it->first, it->second);
+            i += cmp == 0 ? 1 : 0;
+            ++it;
+        }
+    }
+    if (!writer.finish() || !ok || ::rename(tmp_path.c_str(), snapshot_file) != 0) {
+        LOG_ERROR("LongTermMemory", "写快照失败: " + std::string(strerror(errno)));
+        ::unlink(tmp_path.c_str());
         return -1;
     }
+    syncParentDir(snapshot_file);
+    return 0;
+}
+
+// 展示顺序：强化次数多的在前，其次是最近被强化的
+struct KeywordView {
+    std::string_view text;
+    uint32_t count;
+    int64_t last_seen;
+};
+
+static std::string joinKeywordViews(std::vector<KeywordView>& views) {
+    std::sort(views.begin(), views.end(), [](const KeywordView& a, const KeywordView& b) {
+        if (a.count != b.count) return a.count > b.count;
+        if (a.last_seen != b.last_seen) return a.last_seen > b.last_seen;
+        return a.text < b.text;
+    });
+    std::string joined;
+    for (size_t i = 0; i < views.size(); ++i) {
+        if (i > 0) joined += "，";
+        joined += views[i].text;
+    }
+    return joined;
+}
+
+// 结构化编码：[0x01]{[u32 次数][i64 最近强化时间][u32 长度][文本]}*；旧版值是不以0x01开头的纯文本
+static constexpr char keywords_encoding_tag = '\x01';
+
+// 解析结构化编码，格式错误时返回false
+static bool decodeKeywordViews(std::string_view value, std::vector<KeywordView>& views) {
+    size_t pos = 1;
+    while (pos < value.size()) {
+        if (value.size() - pos < 16) {
+            return false;
+        }
+        KeywordView view;
+        uint32_t size;
+        std::memcpy(&view.count, value.data() + pos, 4);
+        std::memcpy(&view.last_seen, value.data() + pos + 4, 8);
+        std::memcpy(&size, value.data() + pos + 12, 4);
+        pos += 16;
+        if (value.size() - pos < size) {
+            return false;
+        }
+        view.text = value.substr(pos, size);
+        pos += size;
+        views.push_back(view);
+    }
+    return true;
+}
+
+bool LongTermMemory::lookupLocked(const std::string& user_id, std::string& keywords) const {
+    auto it = overlay_.find(user_id);
+    if (it != overlay_.end()) {
+        keywords = it->second.joined;
+        return true;
+    }
+    std::string_view value;
+    if (!snapshot_.find(user_id, value)) {
+        return false;
+    }
+    // 只读路径不驻留关键词，直接从快照中的编码生成展示文本
+    if (value.empty() || value[0] != keywords_encoding_tag) {
+        keywords.assign(value.data(), value.size());
+        return true;
+    }
+    std::vector<KeywordView> views;
+    if (!decodeKeywordViews(value, views)) {
+        LOG_WARN("LongTermMemory", "快照中用户 " + user_id + " 的关键词格式错误");
+        views.clear();
+    }
+    keywords = joinKeywordViews(views);
+    return true;
+}
+
+LongTermMemory::UserKeywords* LongTermMemory::findForUpdateLocked(const std::string& user_id) {
+    auto it = overlay_.find(user_id);
+    if (it != overlay_.end()) {
+        return &it->second;
+    }
+    std::string_view value;
+    if (!snapshot_.find(user_id, value)) {
+        return nullptr;
+    }
+    return &overlay_.emplace(user_id, decodeLocked(value)).first->second;
+}
+
+LongTermMemory::UserKeywords LongTermMemory::decodeLocked(std::string_view value) {
+    UserKeywords user;
+    if (value.empty() || value[0] != keywords_encoding_tag) {
+        // 旧版逗号分隔的文本：次数记为1，时间未知
+        for (const auto& key : splitKeywords(value)) {
+            user.keywords.push_back(KeywordEntry{keyword_table_.intern(key), 1, 0});
+        }
+    } else {
+        std::vector<KeywordView> views;
+        if (!decodeKeywordViews(value, views)) {
+            LOG_WARN("LongTermMemory", "关键词记录格式错误，已忽略");
+            views.clear();
+        }
+        for (const auto& view : views) {
+            user.keywords.push_back(KeywordEntry{keyword_table_.intern(view.text), view.count, view.last_seen});
+        }
+    }
+    std::sort(user.keywords.begin(), user.keywords.end(),
+              [](const KeywordEntry& a, const KeywordEntry& b) { return a.id < b.id; });
+    user.keywords.erase(std::unique(user.keywords.begin(), user.keywords.end(),
+                                    [](const KeywordEntry& a, const KeywordEntry& b) { return a.id == b.id; }),
+                        user.keywords.end());
+    user.joined = joinLocked(user.keywords);
+    return user;
+}
+
+std::string LongTermMemory::encodeLocked(const UserKeywords& user) const {
+    std::string value(1, keywords_encoding_tag);
+    for (const auto& entry : user.keywords) {
+        std::string_view text = keyword_table_.text(entry.id);
+        appendU32(value, entry.count);
+        char last_seen[8];
+        std::memcpy(last_seen, &entry.last_seen, sizeof(last_seen));
+        value.append(last_seen, sizeof(last_seen));
+        appendU32(value, static_cast<uint32_t>(text.size()));
+        value.append(text.data(), text.size());
+    }
+    return value;
+}
+
+std::string LongTermMemory::joinLocked(const KeywordList& list) const {
+    std::vector<KeywordView> views;
+    views.reserve(list.size());
+    for (const auto& entry : list) {
+        views.push_back(KeywordView{keyword_table_.text(entry.id), entry.count, entry.last_seen});
+    }
+    return joinKeywordViews(views);
+}
+
+std::map<std::string, std::string> LongTermMemory::encodeOverlayLocked(std::vector<uint64_t>* versions) const {
+    std::map<std::string, std::string> encoded;
+    for (const auto& pair : overlay_) {
+        encoded.emplace_hint(encoded.end(), pair.first, encodeLocked(pair.second));
+        if (versions != nullptr) {
+            versions->push_back(pair.second.version);
+        }
+    }
+    return encoded;
+}
+
+int LongTermMemory::replayWal() {
+    std::ifstream file(wal_file, std::ios::binary);
+    if (!file.is_open()) {
+        wal_bytes_ = 0;
+        return 0;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    file.close();
     
-    file << "{\n";
-    bool first = true;
-    for (const auto& pair : store_) {
-        if (!first) file << ",\n";
-        file << "  \"" << pair.first << "\": \"" << pair.second << "\"";
-        first = false;
-    }
-    file << "\n}\n";
+    size_t pos = 0;
+    size_t records = 0;
+    while (content.size() - pos >= wal_header_size) {
+        uint32_t payload_size = readU32(content.data() + pos);
+        uint32_t crc = readU32(content.data() + pos + 4);
+        if (payload_size < 4 || payload_size > max_wal_record ||
+            content.size() - pos - wal_header_size < payload_size) {
+            break;
+        }
+        const char* payload = content.data() + pos + wal_header_size;
+        uint32_t user_size = readU32(payload);
+        if (crc32(payload, payload_size) != crc || user_size > payload_size - 4) {
+            break;
+        }
+        overlay_[std::string(payload + 4, user_size)] =
+            decodeLocked(std::string_view(payload + 4 + user_size, payload_size - 4 - user_size));
+        pos += wal_header_size + payload_size;
+        records++;
+    }
     
-    file.close();
+    // 崩溃时最后一条记录可能只写了一半：截掉无法校验的尾部，后续追加从有效位置开始
+    if (pos < content.size()) {
+        LOG_WARN("LongTermMemory", "WAL在偏移 " + std::to_string(pos) + " 处损坏或不完整，丢弃尾部 " +
+                 std::to_string(content.size() - pos) + " 字节");
+        if (::truncate(wal_file, static_cast<off_t>(pos)) != 0) {
+            LOG_ERROR("LongTermMemory", "截断WAL失败: " + std::string(strerror(errno)));
+            return -1;
+        }
+    }
+    wal_bytes_ = pos;
+    if (records > 0) {
+        LOG_INFO("LongTermMemory", "已从WAL重放 " + std::to_string(records) + " 条更新");
+    }
     return 0;
 }
 
-std::vector<std::string> LongTermMemory::splitKeywords(const std::string& str) {
-    if (str.empty() || str == "无") {
-        return {};
+int LongTermMemory::openWal() {
+    wal_fd_ = ::open(wal_file, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (wal_fd_ < 0) {
+        LOG_ERROR("LongTermMemory", "打开WAL失败: " + std::string(strerror(errno)));
+        return -1;
+    }
+    return 0;
+}
+
+bool LongTermMemory::writeWal(const std::string& batch) {
+    if (!writeAll(wal_fd_, batch.data(), batch.size())) {
+        LOG_ERROR("LongTermMemory", "写WAL失败: " + std::string(strerror(errno)));
+        return false;
     }
+    wal_bytes_ += batch.size();
+    wal_unsynced_ = true;
+    return true;
+}
+
+void LongTermMemory::syncWal() {
+    if (wal_unsynced_ && ::fdatasync(wal_fd_) != 0) {
+        LOG_ERROR("LongTermMemory", "WAL fsync失败: " + std::string(strerror(errno)));
+    }
+    wal_unsynced_ = false;
+    last_sync_ = std::chrono::steady_clock::now();
+}
+
+std::string LongTermMemory::takeDirtyLocked(uint64_t& seq) {
+    std::unordered_set<std::string> dirty;
+    {
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        dirty.swap(dirty_users_);
+        dirty_changes_ = 0;
+        seq = pending_seq_;
+    }
+    std::string batch;
+    for (const auto& user_id : dirty) {
+        auto it = overlay_.find(user_id);
+        if (it != overlay_.end()) {
+            appendWalRecord(batch, user_id, encodeLocked(it->second));
+        }
+    }
+    return batch;
+}
+
+void LongTermMemory::flushDirty() {
+    // 脏集合与最新值在同一把锁下读取：之后的更新会重新标记为脏，不会丢失
+    std::string batch;
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch = takeDirtyLocked(seq);
+    }
+    if (!batch.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        writeWal(batch);
+        if (fsync_policy_ == FsyncPolicy::Always) {
+            syncWal();
+        }
+        flushSeconds().observeSince(start);
+    }
+    last_flush_ = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        committed_seq_ = seq;
+    }
+    commit_cv_.notify_all();
+}
+
+void LongTermMemory::compact() {
+    // 在同一临界区内复制overlay_并取走脏集合：新快照恰好包含这些更新，之后的更新进入新的WAL。
+    // 只复制上次压缩以来的更新，快照本身只由写线程替换，归并时无需持锁
+    std::map<std::string, std::string> updates;
+    std::vector<uint64_t> versions;
+    std::string batch;
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        updates = encodeOverlayLocked(&versions);
+        batch = takeDirtyLocked(seq);
+    }
+    if (updates.empty() && batch.empty()) {
+        last_compact_ = std::chrono::steady_clock::now();
+        return;   // 快照已是最新
+    }
+    auto start = std::chrono::steady_clock::now();
     
-    std::string processed = str;
-    // 替换中文标点为英文逗号
-    // 注意：中文字符在UTF-8中是3字节，需要按字符串处理
-    size_t pos = 0;
-    const std::string comma_cn = "，";
-    const std::string comma_jp = "、";
-    while ((pos = processed.find(comma_cn, pos)) != std::string::npos) {
-        processed.replace(pos, comma_cn.length(), ",");
-        pos += 1;
+    // 先把待写记录追加到WAL，快照写失败时它们仍然可恢复
+    if (!batch.empty()) {
+        writeWal(batch);
     }
-    pos = 0;
-    while ((pos = processed.find(comma_jp, pos)) != std::string::npos) {
-        processed.replace(pos, comma_jp.length(), ",");
-        pos += 1;
+    SnapshotReader fresh;
+    if (saveToFile(updates) == 0 && fresh.open(snapshot_file) == 0) {
+        {
+            // 切换到新快照，并移除已写入快照且之后没有再更新的条目
+            std::lock_guard<std::mutex> lock(mutex_);
+            snapshot_.swap(fresh);
+            size_t i = 0;
+            for (const auto& pair : updates) {
+                auto it = overlay_.find(pair.first);
+                if (it != overlay_.end() && it->second.version == versions[i]) {
+                    overlay_.erase(it);
+                }
+                i++;
+            }
+        }
+        fresh.close();   // 旧快照的映射，读取方都在mutex_内拷贝结果，此时已无引用
+        if (::ftruncate(wal_fd_, 0) != 0) {
+            LOG_ERROR("LongTermMemory", "清空WAL失败: " + std::string(strerror(errno)));
+        } else {
+            wal_bytes_ = 0;
+            wal_unsynced_ = true;
+        }
+        LOG_DEBUG("LongTermMemory", "已压缩为快照 (用户数: " + std::to_string(snapshot_.size()) + ")");
+    } else {
+        LOG_WARN("LongTermMemory", "写快照失败，保留WAL");
     }
+    syncWal();
+    last_compact_ = std::chrono::steady_clock::now();
+    compactSeconds().observeSince(start);
     
-    std::vector<std::string> result;
-    std::istringstream iss(processed);
-    std::string token;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        committed_seq_ = seq;
+    }
+    commit_cv_.notify_all();
+}
+
+std::vector<std::string_view> LongTermMemory::splitKeywords(std::string_view str) {
+    std::vector<std::string_view> result;
+    if (str.empty() || str == "无") {
+        return result;
+    }
     
-    while (std::getline(iss, token, ',')) {
-        // 去除首尾空格
-        token.erase(0, token.find_first_not_of(" \t"));
-        token.erase(token.find_last_not_of(" \t") + 1);
-        
-        if (!token.empty()) {
-            result.push_back(token);
+    // 分隔符：英文逗号、中文逗号"，"(EF BC 8C)、顿号"、"(E3 80 81)；只扫描一遍，不改写原串
+    size_t start = 0;
+    size_t pos = 0;
+    auto emit = [&](size_t end) {
+        std::string_view token = str.substr(start, end - start);
+        size_t first = token.find_first_not_of(" \t");
+        if (first != std::string_view::npos) {
+            size_t last = token.find_last_not_of(" \t");
+            result.push_back(token.substr(first, last - first + 1));
         }
+    };
+    while (pos < str.size()) {
+        size_t sep = 0;
+        if (str[pos] == ',') {
+            sep = 1;
+        } else if (str.compare(pos, 3, "，") == 0 || str.compare(pos, 3, "、") == 0) {
+            sep = 3;
+        }
+        if (sep == 0) {
+            pos++;
+            continue;
+        }
+        emit(pos);
+        pos += sep;
+        start = pos;
     }
-    
+    emit(str.size());
     return result;
 }
 
 std::string LongTermMemory::mergeAndSaveLongTerm(const std::string& user_id, 
                                                   const std::string& new_keywords) {
-    std::map<std::string, std::string> data_copy;
+    utils::TraceSpan span("mergeAndSaveLongTerm", "memory");
+    std::string merged;
+    uint64_t seq;
+    bool notify;
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    auto new_keys = splitKeywords(new_keywords);
     
     {
         std::lock_guard<std::mutex> lock(mutex_);
         
-        if (new_keywords.empty() || new_keywords == "无") {
-            auto it = store_.find(user_id);
-            if (it == store_.end() || it->second.empty()) {
-                return "无";
-            }
-            return it->second;
-        }
-        
-        // 拆分新旧关键词
-        std::string existing_str = store_[user_id];
-        auto existing_keys = splitKeywords(existing_str);
-        auto new_keys = splitKeywords(new_keywords);
-        
-        // 去重合并
-        std::map<std::string, bool> merged_map;
-        for (const auto& k : existing_keys) {
-            merged_map[k] = true;
-        }
-        for (const auto& k : new_keys) {
-            merged_map[k] = true;
+        if (new_keys.empty()) {
+            std::string existing;
+            lookupLocked(user_id, existing);
+            return existing.empty() ? "无" : existing;
         }
         
-        // 转为向量，限制最多50个
-        std::vector<std::string> merged_vec;
-        for (const auto& pair : merged_map) {
-            merged_vec.push_back(pair.first);
+        // 新关键词转为驻留id并排序去重，再与已有的有序数组归并
+        std::vector<uint32_t> new_ids;
+        new_ids.reserve(new_keys.size());
+        for (const auto& key : new_keys) {
+            new_ids.push_back(keyword_table_.intern(key));
         }
+        std::sort(new_ids.begin(), new_ids.end());
+        new_ids.erase(std::unique(new_ids.begin(), new_ids.end()), new_ids.end());
         
-        if (merged_vec.size() > max_long_keys) {
-            merged_vec.erase(merged_vec.begin() + max_long_keys, merged_vec.end());
+        UserKeywords* user = findForUpdateLocked(user_id);
+        if (user == nullptr) {
+            user = &overlay_[user_id];
         }
+        mergeKeywords(user->keywords, new_ids, now, max_long_keys);
+        user->joined = joinLocked(user->keywords);
+        user->version++;
+        merged = user->joined;
         
-        // 拼接并更新内存
-        std::ostringstream oss;
-        for (size_t i = 0; i < merged_vec.size(); ++i) {
-            if (i > 0) oss << "，";
-            oss << merged_vec[i];
-        }
-        store_[user_id] = oss.str();
-        
-        // 复制数据用于异步写入
-        data_copy = store_;
+        // 在mutex_内标记为脏：写线程在同一把锁下读取脏集合和最新值
+        std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+        dirty_users_.insert(user_id);
+        seq = ++pending_seq_;
+        notify = ++dirty_changes_ >= flush_max_changes_ || fsync_policy_ == FsyncPolicy::Always;
+    }
+    if (notify) {
+        queue_cv_.notify_one();
     }
     
-    // 异步写入
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        write_queue_.push(data_copy);
+    // Always策略下等待本次更新fsync完成；同一批等待者共用一次fsync
+    if (fsync_policy_ == FsyncPolicy::Always && initialized_) {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        commit_cv_.wait(lock, [this, seq] { return committed_seq_ >= seq || !initialized_; });
     }
-    queue_cv_.notify_one();
     
-    return data_copy[user_id];
+    return merged;
 }
 
 std::string LongTermMemory::getLongTerm(const std::string& user_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = store_.find(user_id);
-    if (it == store_.end() || it->second.empty()) {
-        return "无";
+    utils::TraceSpan span("getLongTerm", "memory");
+    std::string keywords;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lookupLocked(user_id, keywords);
     }
-    return it->second;
+    return keywords.empty() ? "无" : keywords;
 }
 
 void LongTermMemory::asyncWriteLoop() {
-    while (!should_stop_) {
-        std::map<std::string, std::string> data_to_write;
-        
+    // Always策略下不做去抖，有更新就立即提交，避免调用方多等一个周期
+    bool debounce = fsync_policy_ != FsyncPolicy::Always;
+    int wait_ms = flush_interval_ms_;
+    if (fsync_policy_ == FsyncPolicy::Interval) {
+        wait_ms = std::min(wait_ms, fsync_interval_ms_);
+    }
+    auto wait_time = std::chrono::milliseconds(std::min(wait_ms, 1000));
+    last_flush_ = std::chrono::steady_clock::now();
+    
+    while (true) {
+        bool stop;
+        bool has_dirty;
+        bool enough_changes;
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            queue_cv_.wait_for(lock, std::chrono::seconds(1), [this] {
-                return !write_queue_.empty() || should_stop_;
+            queue_cv_.wait_for(lock, wait_time, [this, debounce] {
+                return should_stop_ || dirty_changes_ >= flush_max_changes_ || (!debounce && !dirty_users_.empty());
             });
-            
-            if (should_stop_ && write_queue_.empty()) {
-                break;
-            }
-            
-            if (!write_queue_.empty()) {
-                data_to_write = write_queue_.front();
-                write_queue_.pop();
-            }
+            stop = should_stop_;
+            has_dirty = !dirty_users_.empty();
+            enough_changes = dirty_changes_ >= flush_max_changes_;
         }
         
-        if (!data_to_write.empty()) {
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                store_ = data_to_write;
-            }
-            if (saveToFile() != 0) {
-                LOG_WARN("LongTermMemory", "异步写文件失败");
-            }
+        auto now = std::chrono::steady_clock::now();
+        if (has_dirty && (!debounce || enough_changes ||
+                          now - last_flush_ >= std::chrono::milliseconds(flush_interval_ms_))) {
+            flushDirty();
+        }
+        if (fsync_policy_ == FsyncPolicy::Interval && wal_unsynced_ &&
+            now - last_sync_ >= std::chrono::milliseconds(fsync_interval_ms_)) {
+            syncWal();
+        }
+        
+        if (stop) {
+            break;
+        }
+        
+        bool wal_too_large = compact_wal_bytes_ > 0 && wal_bytes_ >= compact_wal_bytes_;
+        bool interval_due = compact_interval_sec_ > 0 && wal_bytes_ > 0 &&
+                            now - last_compact_ >= std::chrono::seconds(compact_interval_sec_);
+        if (wal_too_large || interval_due) {
+            compact();
         }
     }
     
-    // 写入最后一批数据
-    std::lock_guard<std::mutex> lock(mutex_);
-    saveToFile();
+    // 退出前写出完整快照并清空WAL
+    compact();
 }
 
 void LongTermMemory::close() {
     if (initialized_) {
-        should_stop_ = true;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            should_stop_ = true;
+        }
         queue_cv_.notify_all();
         if (write_thread_.joinable()) {
             write_thread_.join();
         }
+        if (wal_fd_ >= 0) {
+            ::close(wal_fd_);
+            wal_fd_ = -1;
+        }
         initialized_ = false;
+        commit_cv_.notify_all();
     }
 }
 
@@ -7,12 +7,27 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
-#include <queue>
 #include <condition_variable>
+#include <unordered_set>
 #include <vector>
+#include "keyword_snapshot.h"
+#include "keyword_table.h"
 
 namespace memory {
 
+/**
+ * @brief 长期记忆：每个用户的偏好关键词
+ *
+ * 持久化由二进制快照（long_term_memory.snap，见SnapshotReader）和预写日志（long_term_memory.wal）组成。
+ * 快照启动时直接mmap，按user_id二分查找；上次压缩以来的更新保存在内存中的overlay_里，
+ * 查找时优先于快照。每个用户的关键词是按驻留id排序的小数组，记录强化次数和最近强化时间，
+ * 合并是有序集合的并；超过max_long_keys时淘汰最久未被强化的关键词。
+ * 更新只把用户标记为脏，后台线程每long_term_flush_interval_ms（或脏更新达到
+ * long_term_flush_max_changes次时）把脏用户的最新值合并为一次write追加到WAL（组提交），
+ * 同一用户在一个周期内的多次更新只写一条；按long_term_fsync策略落盘；WAL超过阈值或到达压缩周期时写出新快照
+ * （快照与overlay_归并，临时文件 + fsync + rename）并清空WAL。启动时先映射快照再重放WAL；
+ * 只有旧版long_term_memory.json时自动迁移。
+ */
 class LongTermMemory {
 public:
     static LongTermMemory& getInstance();
@@ -28,23 +43,79 @@ private:
     LongTermMemory(const LongTermMemory&) = delete;
     LongTermMemory& operator=(const LongTermMemory&) = delete;
     
+    enum class FsyncPolicy { Always, Interval, Never };
+
+    struct UserKeywords {
+        KeywordList keywords;
+        std::string joined;      // 按强化程度排序、用"，"连接的展示文本
+        uint64_t version = 0;    // 每次合并加一，压缩时据此判断写入快照后是否又有更新
+    };
+
     int loadFromFile();
-    int saveToFile();
-    std::vector<std::string> splitKeywords(const std::string& str);
+    int loadLegacyJson();
+    // 把当前快照与updates归并写成新快照（不切换snapshot_）
+    int saveToFile(const std::map<std::string, std::string>& updates);
+    // 以下需持有mutex_
+    // 依次查overlay_和快照，返回展示文本
+    bool lookupLocked(const std::string& user_id, std::string& keywords) const;
+    // 返回可修改的用户记录，只在快照中时解码后放入overlay_；不存在时返回nullptr
+    UserKeywords* findForUpdateLocked(const std::string& user_id);
+    // 快照/WAL中的值与内存记录互转；兼容旧版逗号分隔的纯文本
+    UserKeywords decodeLocked(std::string_view value);
+    std::string encodeLocked(const UserKeywords& user) const;
+    std::string joinLocked(const KeywordList& list) const;
+    // 编码整个overlay_用于写快照，versions按相同顺序返回各条目的版本
+    std::map<std::string, std::string> encodeOverlayLocked(std::vector<uint64_t>* versions) const;
+    
+    static std::vector<std::string_view> splitKeywords(std::string_view str);
+    
+    // WAL：打开（不存在时创建）、重放到overlay_、追加、压缩
+    int openWal();
+    int replayWal();
+    bool writeWal(const std::string& batch);
+    void syncWal();
+    // 取走脏用户集合并生成对应的WAL记录，需持有mutex_
+    std::string takeDirtyLocked(uint64_t& seq);
+    void flushDirty();
+    void compact();
     
     void asyncWriteLoop();
     
     std::mutex mutex_;
-    std::map<std::string, std::string> store_;
-    static constexpr int max_long_keys = 50;
-    static constexpr const char* persist_file = "./data/long_term_memory.json";
+    SnapshotReader snapshot_;                         // 只由写线程（及init）替换
+    std::map<std::string, UserKeywords> overlay_;    // 快照之后的更新，按user_id有序便于归并
+    KeywordTable keyword_table_;
+    static constexpr size_t max_long_keys = 50;
+    static constexpr const char* snapshot_file = "./data/long_term_memory.snap";
+    static constexpr const char* legacy_file = "./data/long_term_memory.json";
+    static constexpr const char* wal_file = "./data/long_term_memory.wal";
+    
+    FsyncPolicy fsync_policy_;
+    int fsync_interval_ms_;
+    int flush_interval_ms_;
+    size_t flush_max_changes_;
+    int compact_interval_sec_;
+    size_t compact_wal_bytes_;
+    
+    // 以下仅由写线程访问（init/close时除外）
+    int wal_fd_;
+    size_t wal_bytes_;
+    bool wal_unsynced_;         // 有已写入但尚未fsync的记录
+    std::chrono::steady_clock::time_point last_sync_;
+    std::chrono::steady_clock::time_point last_flush_;
+    std::chrono::steady_clock::time_point last_compact_;
     
     std::atomic<bool> initialized_;
     std::atomic<bool> should_stop_;
     std::thread write_thread_;
-    std::queue<std::map<std::string, std::string>> write_queue_;
+    // 自上次刷写以来更新过的用户，占用只与脏用户数有关（持有mutex_时加入）
+    std::unordered_set<std::string> dirty_users_;
+    size_t dirty_changes_;      // 自上次刷写以来的更新次数
+    uint64_t pending_seq_;      // 已标记为脏的更新序号
+    uint64_t committed_seq_;    // 已写入WAL（Always策略下已fsync）的更新序号
     std::mutex queue_mutex_;
     std::condition_variable queue_cv_;
+    std::condition_variable commit_cv_;
 };
 
 } // namespace memory
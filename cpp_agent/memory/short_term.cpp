@@ -1,42 +1,338 @@
 #include "short_term.h"
-#include <sstream>
+#include "../utils/config.h"
+#include "../utils/logger.h"
+#include "../utils/trace.h"
+#include <functional>
 #include <algorithm>
+#include <string_view>
 
 namespace memory {
 
+// 每个会话除Session结构体和对话内容外的固定开销估计（哈希表节点、桶指针）
+static constexpr size_t session_node_overhead = 64;
+
+// 分片数：不小于配置值的2的幂
+static size_t shardCount() {
+    int configured = utils::Config::getInstance().getInt("short_term_shards", 16);
+    size_t count = 1;
+    while (count < static_cast<size_t>(configured > 0 ? configured : 1) && count < 1024) {
+        count <<= 1;
+    }
+    return count;
+}
+
+static int64_t steadyNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static size_t roundBytes(const ChatRound& round) {
+    return sizeof(ChatRound) + round.session_id.size() + round.user_id.size() +
+           round.input.size() + round.reply.size();
+}
+
+// 粗略估算token数：中文等多字节字符约1个token，ASCII约4个字符1个token
+static size_t estimateTokens(std::string_view text) {
+    size_t ascii = 0;
+    size_t multibyte = 0;
+    for (unsigned char c : text) {
+        if (c < 0x80) {
+            ascii++;
+        } else if (c >= 0xC0) {
+            multibyte++;
+        }
+    }
+    return multibyte + (ascii + 3) / 4;
+}
+
+// 会话键："<user_id长度>:<user_id><session_id>"。两个ID都来自请求体，可能包含任意字节，
+// 用长度前缀而非分隔符，保证不同的(user_id, session_id)不会映射到同一个键
+static std::string sessionKey(const std::string& user_id, const std::string& session_id) {
+    std::string key = std::to_string(user_id.size());
+    key.reserve(key.size() + user_id.size() + session_id.size() + 1);
+    key += ':';
+    key += user_id;
+    key += session_id;
+    return key;
+}
+
+ShortTermMemory::ShortTermMemory()
+    : shards_(shardCount()), clock_hand_(0), bytes_(0), sessions_(0), expired_(0), evicted_(0),
+      initialized_(false), should_stop_(false) {
+    shard_mask_ = shards_.size() - 1;
+    auto& config = utils::Config::getInstance();
+    int max_bytes = config.getInt("short_term_max_bytes", 67108864);
+    int idle_ttl_sec = config.getInt("short_term_idle_ttl_sec", 1800);
+    max_bytes_ = static_cast<size_t>(std::max(0, max_bytes));
+    idle_ttl_ms_ = static_cast<int64_t>(std::max(0, idle_ttl_sec)) * 1000;
+    int max_rounds = config.getInt("short_term_max_rounds", 20);
+    int max_tokens = config.getInt("short_term_context_max_tokens", 1024);
+    max_rounds_ = static_cast<size_t>(std::min(std::max(1, max_rounds), 1000));
+    max_context_tokens_ = static_cast<size_t>(std::max(0, max_tokens));
+}
+
+ShortTermMemory::~ShortTermMemory() {
+    close();
+}
+
 ShortTermMemory& ShortTermMemory::getInstance() {
     static ShortTermMemory instance;
     return instance;
 }
 
-void ShortTermMemory::saveShortTerm(const ChatRound& round) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto& rounds = store_[round.user_id];
-    rounds.push_back(round);
-    
-    // 只保留最后10轮
-    if (rounds.size() > max_short_rounds) {
-        rounds.erase(rounds.begin(), rounds.end() - max_short_rounds);
+int ShortTermMemory::init() {
+    if (initialized_) {
+        return 0;
+    }
+    should_stop_ = false;
+    sweep_thread_ = std::thread(&ShortTermMemory::sweepLoop, this);
+    initialized_ = true;
+    LOG_INFO("ShortTermMemory", "短期记忆模块初始化完成 (分片: " + std::to_string(shards_.size()) +
+             ", 内存预算: " + std::to_string(max_bytes_ / 1024) + "KB, 空闲超时: " +
+             std::to_string(idle_ttl_ms_ / 1000) + "秒)");
+    return 0;
+}
+
+void ShortTermMemory::close() {
+    if (!initialized_) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sweep_mutex_);
+        should_stop_ = true;
+    }
+    sweep_cv_.notify_all();
+    if (sweep_thread_.joinable()) {
+        sweep_thread_.join();
+    }
+    initialized_ = false;
+}
+
+size_t ShortTermMemory::RoundRing::push(ChatRound round, size_t capacity) {
+    if (count < capacity) {
+        // 未写满时head始终为0，新的一轮追加在末尾
+        slots.emplace_back();
+        slots.back().round = std::move(round);
+        count++;
+        return 0;
+    }
+    // 已满：覆盖最旧的一轮，只保留最后capacity轮
+    size_t replaced = roundBytes(slots[head].round);
+    slots[head] = RoundSlot();
+    slots[head].round = std::move(round);
+    head = (head + 1) % slots.size();
+    return replaced;
+}
+
+void ShortTermMemory::RoundRing::clear() {
+    slots.clear();
+    head = 0;
+    count = 0;
+}
+
+void ShortTermMemory::dropContextHead(Session& session) {
+    const RoundSlot& oldest = session.ring.at(session.ring.count - session.context_rounds);
+    session.context_begin += oldest.segment_bytes;
+    session.context_tokens -= oldest.tokens;
+    session.context_rounds--;
+}
+
+void ShortTermMemory::appendContext(Session& session, const ChatRound& round) {
+    std::string& context = session.context;
+    // 丢弃的头部超过一半时再整体前移，均摊后每轮只拷贝常数倍的数据
+    if (session.context_begin > 0 && session.context_begin * 2 >= context.size()) {
+        context.erase(0, session.context_begin);
+        session.context_begin = 0;
+    }
+
+    size_t start = context.size();
+    context += "第";
+    context += std::to_string(session.total_rounds);
+    context += "轮用户输入：";
+    context += round.input;
+    context += "；";
+
+    RoundSlot& slot = session.ring.at(session.ring.count - 1);
+    slot.segment_bytes = static_cast<uint32_t>(context.size() - start);
+    slot.tokens = static_cast<uint32_t>(estimateTokens(std::string_view(context).substr(start)));
+    session.context_tokens += slot.tokens;
+    session.context_rounds++;
+
+    // 超出token预算时从最旧的一轮开始丢弃，至少保留最新一轮
+    while (max_context_tokens_ > 0 && session.context_tokens > max_context_tokens_ && session.context_rounds > 1) {
+        dropContextHead(session);
+    }
+}
+
+ShortTermMemory::Shard& ShortTermMemory::shardFor(const std::string& key) const {
+    return shards_[std::hash<std::string>{}(key) & shard_mask_];
+}
+
+bool ShortTermMemory::isIdle(const Session& session, int64_t now_ms) const {
+    return idle_ttl_ms_ > 0 && now_ms - session.last_access_ms.load(std::memory_order_relaxed) > idle_ttl_ms_;
+}
+
+void ShortTermMemory::eraseLocked(Shard& shard, std::unordered_map<std::string, Session>::iterator it) {
+    bytes_ -= it->second.bytes;
+    sessions_--;
+    shard.sessions.erase(it);
+}
+
+void ShortTermMemory::saveShortTerm(ChatRound round) {
+    utils::TraceSpan span("saveShortTerm", "memory");
+    std::string key = sessionKey(round.user_id, round.session_id);
+    Shard& shard = shardFor(key);
+    int64_t now_ms = steadyNowMs();
+    size_t added = roundBytes(round);
+    {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto result = shard.sessions.try_emplace(std::move(key));
+        Session& session = result.first->second;
+        if (result.second) {
+            session.bytes = sizeof(Session) + session_node_overhead + result.first->first.size();
+            bytes_ += session.bytes;
+            sessions_++;
+        } else if (isIdle(session, now_ms)) {
+            // 已空闲超时但还没被清理线程回收：视为新会话
+            bytes_ -= session.bytes;
+            session.ring.clear();
+            session.context.clear();
+            session.context_begin = 0;
+            session.context_rounds = 0;
+            session.context_tokens = 0;
+            session.total_rounds = 0;
+            session.bytes = sizeof(Session) + session_node_overhead + result.first->first.size();
+            bytes_ += session.bytes;
+        }
+
+        // 即将被覆盖的最旧一轮如果还在上下文中，先从上下文头部丢弃
+        if (session.ring.count == max_rounds_ && session.context_rounds == session.ring.count) {
+            dropContextHead(session);
+        }
+        size_t context_before = session.context.size();
+        session.total_rounds++;
+        size_t replaced = session.ring.push(std::move(round), max_rounds_);
+        appendContext(session, session.ring.at(session.ring.count - 1).round);
+        size_t context_after = session.context.size();
+
+        session.bytes += added + context_after;
+        session.bytes -= replaced + context_before;
+        bytes_ += added + context_after;
+        bytes_ -= replaced + context_before;
+        session.last_access_ms.store(now_ms, std::memory_order_relaxed);
+        session.referenced.store(true, std::memory_order_relaxed);
+    }
+
+    if (max_bytes_ > 0 && bytes_.load(std::memory_order_relaxed) > max_bytes_) {
+        sweep_cv_.notify_one(); // 超出预算，不等下一个清理周期
+    }
+}
+
+std::string ShortTermMemory::getShortTermContext(const std::string& user_id, const std::string& session_id) const {
+    std::string context;
+    appendShortTermContext(user_id, session_id, context);
+    return context;
+}
+
+void ShortTermMemory::appendShortTermContext(const std::string& user_id, const std::string& session_id,
+                                             std::string& out) const {
+    utils::TraceSpan span("getShortTermContext", "memory");
+    std::string key = sessionKey(user_id, session_id);
+    Shard& shard = shardFor(key);
+    int64_t now_ms = steadyNowMs();
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+    auto it = shard.sessions.find(key);
+    if (it == shard.sessions.end() || it->second.context_rounds == 0 || isIdle(it->second, now_ms)) {
+        out += "无历史对话";
+        return;
+    }
+
+    const Session& session = it->second;
+    session.last_access_ms.store(now_ms, std::memory_order_relaxed);
+    session.referenced.store(true, std::memory_order_relaxed);
+    out.append(session.context, session.context_begin, std::string::npos);
+}
+
+ShortTermStats ShortTermMemory::getStats() const {
+    ShortTermStats stats;
+    stats.sessions = sessions_.load();
+    stats.bytes = bytes_.load();
+    stats.max_bytes = max_bytes_;
+    stats.expired = expired_.load();
+    stats.evicted = evicted_.load();
+    return stats;
+}
+
+void ShortTermMemory::sweepLoop() {
+    // 清理周期取空闲超时的1/4，限制在1~30秒之间
+    int64_t interval_ms = idle_ttl_ms_ > 0 ? std::min<int64_t>(std::max<int64_t>(idle_ttl_ms_ / 4, 1000), 30000)
+                                           : 30000;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(sweep_mutex_);
+            sweep_cv_.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] {
+                return should_stop_.load() || (max_bytes_ > 0 && bytes_.load() > max_bytes_);
+            });
+            if (should_stop_) {
+                break;
+            }
+        }
+
+        uint64_t expired_before = expired_.load();
+        uint64_t evicted_before = evicted_.load();
+        removeIdleSessions();
+        enforceBudget();
+
+        uint64_t expired = expired_.load() - expired_before;
+        uint64_t evicted = evicted_.load() - evicted_before;
+        if (expired > 0 || evicted > 0) {
+            LOG_DEBUG("ShortTermMemory", "清理短期记忆: 过期 " + std::to_string(expired) +
+                      ", 淘汰 " + std::to_string(evicted) + ", 剩余会话 " + std::to_string(sessions_.load()) +
+                      ", 占用 " + std::to_string(bytes_.load() / 1024) + "KB");
+        }
+    }
+}
+
+void ShortTermMemory::removeIdleSessions() {
+    if (idle_ttl_ms_ <= 0) {
+        return;
+    }
+    int64_t now_ms = steadyNowMs();
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+            if (isIdle(it->second, now_ms)) {
+                auto victim = it++;
+                eraseLocked(shard, victim);
+                expired_++;
+            } else {
+                ++it;
+            }
+        }
     }
 }
 
-std::string ShortTermMemory::getShortTermContext(const std::string& user_id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = store_.find(user_id);
-    if (it == store_.end() || it->second.empty()) {
-        return "无历史对话";
+void ShortTermMemory::enforceBudget() {
+    if (max_bytes_ == 0) {
+        return;
     }
-    
-    const auto& rounds = it->second;
-    std::ostringstream context;
-    
-    for (size_t i = 0; i < rounds.size(); ++i) {
-        context << "第" << (i + 1) << "轮用户输入：" << rounds[i].input << "；";
+    // CLOCK：指针在分片间轮转，访问位为1的会话清零后跳过（第二次机会），为0的淘汰；
+    // 最多转两圈，第二圈时所有访问位都已清零
+    for (size_t visited = 0; visited < shards_.size() * 2 && bytes_.load() > max_bytes_; ++visited) {
+        Shard& shard = shards_[clock_hand_];
+        clock_hand_ = (clock_hand_ + 1) & shard_mask_;
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for (auto it = shard.sessions.begin(); it != shard.sessions.end() && bytes_.load() > max_bytes_;) {
+            if (it->second.referenced.exchange(false, std::memory_order_relaxed)) {
+                ++it;
+                continue;
+            }
+            auto victim = it++;
+            eraseLocked(shard, victim);
+            evicted_++;
+        }
     }
-    
-    return context.str();
 }
 
 } // namespace memory
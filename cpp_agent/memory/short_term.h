@@ -3,9 +3,14 @@
 
 #include <string>
 #include <vector>
-#include <map>
+#include <array>
+#include <unordered_map>
+#include <shared_mutex>
 #include <mutex>
+#include <thread>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 
 namespace memory {
 
@@ -17,22 +22,120 @@ struct ChatRound {
     std::chrono::system_clock::time_point timestamp;
 };
 
+/**
+ * @brief 短期记忆统计
+ */
+struct ShortTermStats {
+    size_t sessions = 0;       // 当前保存的会话数
+    size_t bytes = 0;          // 当前占用（估算）
+    size_t max_bytes = 0;      // 内存预算，0表示不限制
+    uint64_t expired = 0;      // 因空闲超时被清理的会话数
+    uint64_t evicted = 0;      // 因超出内存预算被淘汰的会话数
+};
+
+/**
+ * @brief 短期记忆：每个(user_id, session_id)会话最近的对话轮次
+ *
+ * 按会话键哈希分片，每个分片一把读写锁：不同分片互不阻塞，
+ * 同一分片内的读取（getShortTermContext）可以并发进行。
+ * 每个会话缓存一份拼接好的上下文文本，保存时追加新一轮、从头部丢弃旧的轮次，
+ * 读取时只需一次拷贝；上下文按估算的token数裁剪到short_term_context_max_tokens，
+ * 最多保留short_term_max_rounds轮。
+ * 后台清理线程移除空闲超过short_term_idle_ttl_sec的会话；总占用超过
+ * short_term_max_bytes时按CLOCK算法（最近被访问过的会话多保留一轮）淘汰。
+ */
 class ShortTermMemory {
 public:
     static ShortTermMemory& getInstance();
-    
-    void saveShortTerm(const ChatRound& round);
-    std::string getShortTermContext(const std::string& user_id);
+
+    // 启动/停止后台清理线程；未启动时只按空闲时间惰性失效，不回收内存
+    int init();
+    void close();
+
+    void saveShortTerm(ChatRound round);
+    std::string getShortTermContext(const std::string& user_id, const std::string& session_id) const;
+    // 将上下文追加到out末尾（没有历史时追加"无历史对话"），拼接提示词时避免中间拷贝
+    void appendShortTermContext(const std::string& user_id, const std::string& session_id, std::string& out) const;
+
+    ShortTermStats getStats() const;
 
 private:
-    ShortTermMemory() = default;
-    ~ShortTermMemory() = default;
+    ShortTermMemory();
+    ~ShortTermMemory();
     ShortTermMemory(const ShortTermMemory&) = delete;
     ShortTermMemory& operator=(const ShortTermMemory&) = delete;
-    
-    std::mutex mutex_;
-    std::map<std::string, std::vector<ChatRound>> store_;
-    static constexpr int max_short_rounds = 10;
+
+    struct RoundSlot {
+        ChatRound round;
+        uint32_t segment_bytes = 0;   // 该轮在上下文文本中所占的字节数
+        uint32_t tokens = 0;          // 该轮上下文文本的估算token数
+    };
+
+    // 环形缓冲区，按需增长到容量上限，写满后覆盖最旧的一轮
+    struct RoundRing {
+        std::vector<RoundSlot> slots;
+        size_t head = 0;   // 最旧一轮的位置
+        size_t count = 0;
+
+        // 返回被覆盖的一轮的占用字节数（未覆盖时为0）
+        size_t push(ChatRound round, size_t capacity);
+        void clear();
+        RoundSlot& at(size_t i) { return slots[(head + i) % slots.size()]; }
+        const RoundSlot& at(size_t i) const { return slots[(head + i) % slots.size()]; }
+    };
+
+    struct Session {
+        RoundRing ring;
+        // 最近context_rounds轮的上下文文本，从context_begin开始有效；
+        // 头部丢弃的轮次只移动起点，积累到一半以上时才压缩
+        std::string context;
+        size_t context_begin = 0;
+        size_t context_rounds = 0;
+        size_t context_tokens = 0;
+        uint64_t total_rounds = 0;   // 会话累计轮数，用于上下文中的轮次编号
+        size_t bytes = 0;
+        // 读取时在共享锁下更新，因此使用原子变量
+        mutable std::atomic<int64_t> last_access_ms{0};
+        mutable std::atomic<bool> referenced{false};   // CLOCK访问位
+    };
+
+    // 按缓存行对齐，避免相邻分片的锁互相干扰
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Session> sessions;
+    };
+
+    Shard& shardFor(const std::string& key) const;
+    bool isIdle(const Session& session, int64_t now_ms) const;
+    // 从分片中移除会话，需持有分片的写锁
+    void eraseLocked(Shard& shard, std::unordered_map<std::string, Session>::iterator it);
+    // 丢弃上下文中最旧的一轮
+    static void dropContextHead(Session& session);
+    // 将新的一轮追加到上下文并按token预算裁剪
+    void appendContext(Session& session, const ChatRound& round);
+
+    void sweepLoop();
+    void removeIdleSessions();
+    void enforceBudget();
+
+    mutable std::vector<Shard> shards_;
+    size_t shard_mask_;
+    size_t max_bytes_;
+    int64_t idle_ttl_ms_;
+    size_t max_rounds_;
+    size_t max_context_tokens_;         // 0表示只按轮数限制
+    size_t clock_hand_;                 // CLOCK指针：下一个检查的分片，仅清理线程访问
+
+    std::atomic<size_t> bytes_;
+    std::atomic<size_t> sessions_;
+    std::atomic<uint64_t> expired_;
+    std::atomic<uint64_t> evicted_;
+
+    std::atomic<bool> initialized_;
+    std::atomic<bool> should_stop_;
+    std::thread sweep_thread_;
+    std::mutex sweep_mutex_;
+    std::condition_variable sweep_cv_;
 };
 
 } // namespace memory
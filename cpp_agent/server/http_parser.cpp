@@ -0,0 +1,362 @@
+#include "http_parser.h"
+#include <cstring>
+#include <cctype>
+
+namespace server {
+
+static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) !=
+            std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 判断逗号分隔的header值中是否包含某个token（不区分大小写）
+static bool containsToken(std::string_view value, std::string_view token) {
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t comma = value.find(',', start);
+        if (comma == std::string_view::npos) {
+            comma = value.size();
+        }
+        std::string_view item = value.substr(start, comma - start);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (equalsIgnoreCase(item, token)) {
+            return true;
+        }
+        start = comma + 1;
+    }
+    return false;
+}
+
+std::string_view HttpRequest::header(std::string_view name) const {
+    for (const auto& h : headers) {
+        if (equalsIgnoreCase(h.name, name)) {
+            return h.value;
+        }
+    }
+    return std::string_view();
+}
+
+std::string_view HttpRequest::queryParam(std::string_view name) const {
+    size_t start = 0;
+    while (start < query.size()) {
+        size_t amp = query.find('&', start);
+        if (amp == std::string_view::npos) {
+            amp = query.size();
+        }
+        std::string_view pair = query.substr(start, amp - start);
+        size_t eq = pair.find('=');
+        if (pair.substr(0, eq) == name) {
+            return eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+        }
+        start = amp + 1;
+    }
+    return std::string_view();
+}
+
+HttpRequestParser::HttpRequestParser(size_t max_body_bytes)
+    : max_body_bytes_(max_body_bytes) {
+    reset();
+}
+
+void HttpRequestParser::reset() {
+    state_ = State::RequestLine;
+    pos_ = 0;
+    consumed_ = 0;
+    method_ = Span();
+    target_ = Span();
+    version_ = Span();
+    headers_.clear();
+    body_start_ = 0;
+    body_length_ = 0;
+    content_length_ = 0;
+    chunk_remaining_ = 0;
+    keep_alive_ = false;
+    expect_continue_ = false;
+    error_status_ = 0;
+    error_message_.clear();
+}
+
+HttpRequestParser::Status HttpRequestParser::fail(int status, const std::string& message) {
+    state_ = State::Error;
+    error_status_ = status;
+    error_message_ = message;
+    return Status::Error;
+}
+
+bool HttpRequestParser::parseRequestLine(const char* data, size_t line_end) {
+    std::string_view line(data + pos_, line_end - pos_);
+    size_t sp1 = line.find(' ');
+    if (sp1 == std::string_view::npos || sp1 == 0) {
+        return false;
+    }
+    size_t sp2 = line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || sp2 == sp1 + 1) {
+        return false;
+    }
+
+    method_ = {pos_, sp1};
+    target_ = {pos_ + sp1 + 1, sp2 - sp1 - 1};
+    version_ = {pos_ + sp2 + 1, line.size() - sp2 - 1};
+
+    std::string_view version = line.substr(sp2 + 1);
+    if (version.size() != 8 || version.compare(0, 7, "HTTP/1.") != 0) {
+        return false;
+    }
+    // HTTP/1.1默认持久连接，HTTP/1.0需显式声明keep-alive
+    keep_alive_ = version[7] == '1';
+    return true;
+}
+
+bool HttpRequestParser::parseHeaderLine(const char* data, size_t line_end) {
+    std::string_view line(data + pos_, line_end - pos_);
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+        return false;
+    }
+
+    size_t value_start = colon + 1;
+    while (value_start < line.size() && (line[value_start] == ' ' || line[value_start] == '\t')) {
+        ++value_start;
+    }
+    size_t value_end = line.size();
+    while (value_end > value_start && (line[value_end - 1] == ' ' || line[value_end - 1] == '\t')) {
+        --value_end;
+    }
+
+    HeaderSpan header;
+    header.name = {pos_, colon};
+    header.value = {pos_ + value_start, value_end - value_start};
+    headers_.push_back(header);
+    return true;
+}
+
+bool HttpRequestParser::finishHeaders(const char* data) {
+    bool chunked = false;
+    bool has_length = false;
+
+    for (const auto& h : headers_) {
+        std::string_view name(data + h.name.offset, h.name.length);
+        std::string_view value(data + h.value.offset, h.value.length);
+
+        if (equalsIgnoreCase(name, "content-length")) {
+            if (value.empty() || value.size() > 19) {
+                fail(400, "Content-Length格式错误");
+                return false;
+            }
+            size_t length = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') {
+                    fail(400, "Content-Length格式错误");
+                    return false;
+                }
+                length = length * 10 + static_cast<size_t>(c - '0');
+            }
+            // 多个值不同的Content-Length无法确定请求体边界（RFC 9112 §6.3）
+            if (has_length && length != content_length_) {
+                fail(400, "Content-Length重复且不一致");
+                return false;
+            }
+            content_length_ = length;
+            has_length = true;
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            // 只支持单独的chunked；其他编码无法解码，也就无法找到请求体的结尾
+            if (chunked || !equalsIgnoreCase(value, "chunked")) {
+                fail(501, "不支持的Transfer-Encoding");
+                return false;
+            }
+            chunked = true;
+        } else if (equalsIgnoreCase(name, "connection")) {
+            if (containsToken(value, "close")) {
+                keep_alive_ = false;
+            } else if (containsToken(value, "keep-alive")) {
+                keep_alive_ = true;
+            }
+        } else if (equalsIgnoreCase(name, "expect")) {
+            expect_continue_ = equalsIgnoreCase(value, "100-continue");
+        }
+    }
+
+    body_start_ = pos_;
+    if (chunked) {
+        // 同时带Content-Length时以chunked为准，但请求可能经过不一致的中间代理，
+        // 处理完后关闭连接，避免后续请求的边界被错判（RFC 9112 §6.1）
+        if (has_length) {
+            content_length_ = 0;
+            keep_alive_ = false;
+        }
+        state_ = State::ChunkSize;
+    } else if (has_length && content_length_ > 0) {
+        state_ = State::Body;
+    } else {
+        state_ = State::Complete;
+    }
+    return true;
+}
+
+HttpRequestParser::Status HttpRequestParser::parse(char* data, size_t len) {
+    while (true) {
+        switch (state_) {
+        case State::RequestLine:
+        case State::Headers:
+        case State::ChunkSize:
+        case State::ChunkDataEnd:
+        case State::Trailers: {
+            const void* nl = pos_ < len ? std::memchr(data + pos_, '\n', len - pos_) : nullptr;
+            if (!nl) {
+                if (state_ <= State::Headers && len > max_header_bytes) {
+                    return fail(431, "请求头过大");
+                }
+                return Status::NeedMore;
+            }
+            size_t newline = static_cast<const char*>(nl) - data;
+            size_t line_end = newline;
+            if (line_end > pos_ && data[line_end - 1] == '\r') {
+                --line_end;
+            }
+
+            if (state_ == State::RequestLine) {
+                if (line_end == pos_) {
+                    // 容忍请求之间多余的空行
+                    pos_ = newline + 1;
+                    continue;
+                }
+                if (!parseRequestLine(data, line_end)) {
+                    return fail(400, "请求行格式错误");
+                }
+                state_ = State::Headers;
+            } else if (state_ == State::Headers) {
+                if (line_end == pos_) {
+                    pos_ = newline + 1;
+                    if (!finishHeaders(data)) {
+                        return Status::Error;
+                    }
+                    if (content_length_ > max_body_bytes_) {
+                        return fail(413, "请求体过大");
+                    }
+                    continue;
+                }
+                if (headers_.size() >= max_headers || !parseHeaderLine(data, line_end)) {
+                    return fail(400, "请求头格式错误");
+                }
+            } else if (state_ == State::ChunkSize) {
+                size_t size = 0;
+                size_t digits = 0;
+                for (size_t i = pos_; i < line_end && data[i] != ';'; ++i) {
+                    int c = std::tolower(static_cast<unsigned char>(data[i]));
+                    int value;
+                    if (c >= '0' && c <= '9') {
+                        value = c - '0';
+                    } else if (c >= 'a' && c <= 'f') {
+                        value = c - 'a' + 10;
+                    } else if (c == ' ' || c == '\t') {
+                        continue;
+                    } else {
+                        return fail(400, "chunk长度格式错误");
+                    }
+                    if (++digits > 15) {
+                        return fail(413, "请求体过大");
+                    }
+                    size = size * 16 + static_cast<size_t>(value);
+                }
+                if (digits == 0) {
+                    return fail(400, "chunk长度格式错误");
+                }
+                if (body_length_ + size > max_body_bytes_) {
+                    return fail(413, "请求体过大");
+                }
+                chunk_remaining_ = size;
+                state_ = size == 0 ? State::Trailers : State::ChunkData;
+            } else if (state_ == State::ChunkDataEnd) {
+                if (line_end != pos_) {
+                    return fail(400, "chunk数据格式错误");
+                }
+                state_ = State::ChunkSize;
+            } else {
+                // Trailers：忽略trailer header，空行表示请求结束
+                if (line_end == pos_) {
+                    pos_ = newline + 1;
+                    consumed_ = pos_;
+                    state_ = State::Complete;
+                    return Status::Complete;
+                }
+            }
+            pos_ = newline + 1;
+            break;
+        }
+
+        case State::Body:
+            if (len - body_start_ < content_length_) {
+                return Status::NeedMore;
+            }
+            body_length_ = content_length_;
+            pos_ = body_start_ + content_length_;
+            consumed_ = pos_;
+            state_ = State::Complete;
+            return Status::Complete;
+
+        case State::ChunkData: {
+            size_t available = len - pos_;
+            if (available > chunk_remaining_) {
+                available = chunk_remaining_;
+            }
+            // 原地解码：把chunk数据前移，紧接在已解码的body之后
+            if (available > 0) {
+                std::memmove(data + body_start_ + body_length_, data + pos_, available);
+                body_length_ += available;
+                pos_ += available;
+                chunk_remaining_ -= available;
+            }
+            if (chunk_remaining_ > 0) {
+                return Status::NeedMore;
+            }
+            state_ = State::ChunkDataEnd;
+            break;
+        }
+
+        case State::Complete:
+            if (consumed_ == 0) {
+                consumed_ = pos_;
+            }
+            return Status::Complete;
+
+        case State::Error:
+            return Status::Error;
+        }
+    }
+}
+
+void HttpRequestParser::fill(const char* data, HttpRequest& request) const {
+    request.method = std::string_view(data + method_.offset, method_.length);
+    request.target = std::string_view(data + target_.offset, target_.length);
+    request.version = std::string_view(data + version_.offset, version_.length);
+
+    size_t question = request.target.find('?');
+    if (question == std::string_view::npos) {
+        request.path = request.target;
+        request.query = std::string_view();
+    } else {
+        request.path = request.target.substr(0, question);
+        request.query = request.target.substr(question + 1);
+    }
+
+    request.headers.clear();
+    request.headers.reserve(headers_.size());
+    for (const auto& h : headers_) {
+        request.headers.push_back({std::string_view(data + h.name.offset, h.name.length),
+                                   std::string_view(data + h.value.offset, h.value.length)});
+    }
+
+    request.body = std::string_view(data + body_start_, body_length_);
+    request.keep_alive = keep_alive_;
+}
+
+} // namespace server
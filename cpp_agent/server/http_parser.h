@@ -0,0 +1,151 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace server {
+
+struct HttpHeader {
+    std::string_view name;
+    std::string_view value;
+};
+
+/**
+ * @brief 解析完成的HTTP请求
+ *
+ * 所有字段都是指向连接读缓冲区的string_view，缓冲区被修改或释放后失效。
+ */
+struct HttpRequest {
+    std::string_view method;
+    std::string_view target;   // 原始请求目标，如 /debug/trace?seconds=10
+    std::string_view path;     // 不含查询参数的路径
+    std::string_view query;    // ?之后的部分，不含?
+    std::string_view version;
+    std::vector<HttpHeader> headers;
+    std::string_view body;
+    bool keep_alive = false;
+
+    /**
+     * @brief 查找header（名称不区分大小写）
+     * @return header值，不存在时返回空
+     */
+    std::string_view header(std::string_view name) const;
+
+    /**
+     * @brief 查找查询参数（不做URL解码）
+     * @return 参数值，不存在时返回空
+     */
+    std::string_view queryParam(std::string_view name) const;
+};
+
+/**
+ * @brief 增量式HTTP/1.x请求解析器（状态机）
+ *
+ * 每次收到新数据后，用缓冲区起始地址和当前长度调用parse()；解析器记住已扫描
+ * 的位置，不会重复扫描。支持Content-Length和Transfer-Encoding: chunked，
+ * chunked请求体在缓冲区内原地解码成连续的body，不额外分配内存。
+ *
+ * 内部只记录偏移量，请求完成后通过fill()基于任意缓冲区地址生成string_view，
+ * 因此缓冲区在两次parse()之间可以扩容。
+ */
+class HttpRequestParser {
+public:
+    enum class Status {
+        NeedMore,   // 数据不完整，等待更多数据
+        Complete,   // 一个完整请求已解析完毕
+        Error       // 请求格式错误或超出限制，见errorStatus()
+    };
+
+    explicit HttpRequestParser(size_t max_body_bytes = 8 * 1024 * 1024);
+
+    /**
+     * @brief 继续解析缓冲区
+     * @param data 缓冲区起始地址（当前请求从data[0]开始；chunked请求体会被原地改写）
+     * @param len 缓冲区中有效数据长度
+     */
+    Status parse(char* data, size_t len);
+
+    /**
+     * @brief 用解析结果填充请求（仅在parse()返回Complete后调用）
+     * @param data 与parse()相同内容的缓冲区起始地址
+     */
+    void fill(const char* data, HttpRequest& request) const;
+
+    /**
+     * @brief 已完成请求在缓冲区中占用的字节数，其后是流水线中的下一个请求
+     */
+    size_t consumed() const { return consumed_; }
+
+    bool headersComplete() const { return state_ > State::Headers; }
+    bool expectContinue() const { return expect_continue_; }
+
+    /**
+     * @brief 出错时应返回给客户端的HTTP状态码（400/413/431/501）
+     */
+    int errorStatus() const { return error_status_; }
+    const std::string& errorMessage() const { return error_message_; }
+
+    /**
+     * @brief 重置状态，准备解析下一个请求（保留内部容器的容量）
+     */
+    void reset();
+
+private:
+    enum class State {
+        RequestLine,
+        Headers,
+        Body,
+        ChunkSize,
+        ChunkData,
+        ChunkDataEnd,
+        Trailers,
+        Complete,
+        Error
+    };
+
+    struct Span {
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    struct HeaderSpan {
+        Span name;
+        Span value;
+    };
+
+    Status fail(int status, const std::string& message);
+    bool parseRequestLine(const char* data, size_t line_end);
+    bool parseHeaderLine(const char* data, size_t line_end);
+    // 根据header确定请求体的分帧方式，出错时已通过fail()记录状态码
+    bool finishHeaders(const char* data);
+
+    size_t max_body_bytes_;
+    State state_;
+    size_t pos_;              // 下一个待扫描字节的位置
+    size_t consumed_;
+
+    Span method_;
+    Span target_;
+    Span version_;
+    std::vector<HeaderSpan> headers_;
+
+    size_t body_start_;
+    size_t body_length_;      // 已解码的body长度
+    size_t content_length_;   // Content-Length模式下的body长度
+    size_t chunk_remaining_;  // 当前chunk剩余字节数
+
+    bool keep_alive_;
+    bool expect_continue_;
+    int error_status_;
+    std::string error_message_;
+
+    static constexpr size_t max_header_bytes = 64 * 1024;
+    static constexpr size_t max_headers = 100;
+};
+
+} // namespace server
+
+#endif // HTTP_PARSER_H
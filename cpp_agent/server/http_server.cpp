@@ -0,0 +1,1108 @@
+#include "http_server.h"
+#include "../memory/long_term.h"
+#include "../memory/short_term.h"
+#include "../llm/llm.h"
+#include "../llm/memory_enrichment.h"
+#include "../tts/tts.h"
+#include "../tts/tts_jobs.h"
+#include "../utils/logger.h"
+#include "../utils/config.h"
+#include "../utils/http_utils.h"
+#include "../utils/http_client.h"
+#include "../utils/json.h"
+#include "../utils/json_writer.h"
+#include "../utils/metrics.h"
+#include "../utils/trace.h"
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace server {
+
+// 服务端指标：首次使用时注册，之后记录无需加锁
+static utils::Gauge& activeConnections() {
+    static utils::Gauge& gauge = utils::MetricsRegistry::getInstance().gauge(
+        "agent_http_active_connections", "当前打开的客户端连接数");
+    return gauge;
+}
+
+static utils::Histogram& requestParseSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_http_request_parse_seconds", "解析一个完整HTTP请求（请求行、头部和请求体）的耗时");
+    return histogram;
+}
+
+static utils::Histogram& requestSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_http_request_seconds", "从请求解析完成到响应交回IO线程的耗时");
+    return histogram;
+}
+
+static utils::Counter& requestErrors() {
+    static utils::Counter& counter = utils::MetricsRegistry::getInstance().counter(
+        "agent_http_request_errors_total", "以4xx/5xx状态码结束的请求数");
+    return counter;
+}
+
+static constexpr int max_epoll_events = 256;
+static constexpr int idle_sweep_interval_ms = 1000;
+
+SimpleHTTPServer::SimpleHTTPServer(int port)
+    : port_(port), running_(false), server_fd_(-1) {
+    auto& config = utils::Config::getInstance();
+    int io_threads = config.getInt("server_io_threads", 1);
+    int worker_threads = config.getInt("server_worker_threads", 8);
+    io_thread_count_ = io_threads > 0 ? static_cast<size_t>(io_threads) : 1;
+    worker_thread_count_ = worker_threads > 0 ? static_cast<size_t>(worker_threads) : 1;
+    keepalive_timeout_ = std::chrono::seconds(config.getInt("server_keepalive_timeout_sec", 15));
+    max_keepalive_requests_ = config.getInt("server_max_keepalive_requests", 100);
+
+    LOG_INFO("HTTP", "HTTP服务器初始化，端口: " + std::to_string(port) +
+             "，IO线程: " + std::to_string(io_thread_count_) +
+             "，工作线程: " + std::to_string(worker_thread_count_));
+}
+
+SimpleHTTPServer::~SimpleHTTPServer() {
+    stop();
+}
+
+void SimpleHTTPServer::stop() {
+    if (running_.exchange(false)) {
+        if (server_fd_ >= 0) {
+            shutdown(server_fd_, SHUT_RDWR);
+        }
+        // 唤醒所有IO线程，使其退出事件循环
+        for (auto& loop : loops_) {
+            uint64_t one = 1;
+            ssize_t n = write(loop->wake_fd, &one, sizeof(one));
+            (void)n;
+        }
+        LOG_INFO("HTTP", "HTTP服务器已停止");
+    }
+}
+
+void SimpleHTTPServer::start() {
+    server_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server_fd_ < 0) {
+        LOG_ERROR("HTTP", "创建socket失败");
+        return;
+    }
+
+    int opt = 1;
+    setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port_);
+
+    if (bind(server_fd_, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        LOG_ERROR("HTTP", "绑定端口失败，端口: " + std::to_string(port_) + " (可能已被占用)");
+        close(server_fd_);
+        server_fd_ = -1;
+        return;
+    }
+
+    if (listen(server_fd_, SOMAXCONN) < 0) {
+        LOG_ERROR("HTTP", "监听失败，端口: " + std::to_string(port_));
+        close(server_fd_);
+        server_fd_ = -1;
+        return;
+    }
+
+    workers_.reset(new utils::ThreadPool(worker_thread_count_, "HTTPWorker"));
+
+    // 每个IO线程一个epoll实例；监听socket以EPOLLEXCLUSIVE加入所有实例，
+    // 新连接只会唤醒其中一个线程，由该线程负责连接的整个生命周期
+    for (size_t i = 0; i < io_thread_count_; ++i) {
+        std::unique_ptr<IoLoop> loop(new IoLoop());
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->epoll_fd < 0 || loop->wake_fd < 0) {
+            LOG_ERROR("HTTP", "创建epoll实例失败: " + std::string(strerror(errno)));
+            if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+            if (loop->wake_fd >= 0) close(loop->wake_fd);
+            break;
+        }
+
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = loop->wake_fd;
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wake_fd, &ev);
+
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.fd = server_fd_;
+        epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, server_fd_, &ev);
+
+        loops_.push_back(std::move(loop));
+    }
+
+    if (loops_.empty()) {
+        workers_->stop();
+        close(server_fd_);
+        server_fd_ = -1;
+        return;
+    }
+
+    running_ = true;
+
+    LOG_INFO("HTTP", "C++ AI Agent服务启动成功");
+    LOG_INFO("HTTP", "Web页面访问地址：http://localhost:" + std::to_string(port_));
+    LOG_INFO("HTTP", "按 Ctrl+C 停止服务");
+
+    for (auto& loop : loops_) {
+        IoLoop* raw = loop.get();
+        loop->thread = std::thread(&SimpleHTTPServer::runLoop, this, raw);
+    }
+    for (auto& loop : loops_) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+    }
+
+    // 先停止工作线程，之后再也不会有新的响应投递到IO循环
+    workers_->stop();
+    // 结束进行中的trace采集并等待其回调完成，回调投递的响应随后随IO循环一起丢弃
+    utils::Tracer::getInstance().close();
+
+    // IoLoop对象保留到析构：异步生产者（上游回调、记忆增强、追踪采集）在此之后
+    // 仍可能调用post()，先标记stopped再关闭wake_fd，post()据此丢弃任务
+    for (auto& loop : loops_) {
+        std::vector<std::function<void()>> dropped;
+        {
+            std::lock_guard<std::mutex> lock(loop->task_mutex);
+            loop->stopped = true;
+            dropped.swap(loop->tasks);
+        }
+        for (auto& item : loop->connections) {
+            item.second->closed = true;
+            close(item.first);
+        }
+        loop->connections.clear();
+        close(loop->epoll_fd);
+        close(loop->wake_fd);
+        loop->epoll_fd = -1;
+        loop->wake_fd = -1;
+    }
+
+    if (server_fd_ >= 0) {
+        close(server_fd_);
+        server_fd_ = -1;
+    }
+}
+
+void SimpleHTTPServer::runLoop(IoLoop* loop) {
+    struct epoll_event events[max_epoll_events];
+    auto last_sweep = std::chrono::steady_clock::now();
+
+    while (running_) {
+        int n = epoll_wait(loop->epoll_fd, events, max_epoll_events, idle_sweep_interval_ms);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("HTTP", "epoll_wait失败: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            uint32_t ev = events[i].events;
+
+            if (fd == loop->wake_fd) {
+                uint64_t value;
+                while (read(loop->wake_fd, &value, sizeof(value)) > 0) {
+                }
+                runPostedTasks(loop);
+                continue;
+            }
+
+            if (fd == server_fd_) {
+                handleAccept(loop);
+                continue;
+            }
+
+            auto it = loop->connections.find(fd);
+            if (it == loop->connections.end()) {
+                continue;
+            }
+            std::shared_ptr<Connection> conn = it->second;
+
+            if (ev & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(conn);
+                continue;
+            }
+            if (ev & (EPOLLIN | EPOLLRDHUP)) {
+                handleReadable(conn);
+            }
+            if (!conn->closed && (ev & EPOLLOUT)) {
+                flushOutput(conn);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sweep >= std::chrono::milliseconds(idle_sweep_interval_ms)) {
+            last_sweep = now;
+            closeIdleConnections(loop);
+        }
+    }
+}
+
+void SimpleHTTPServer::closeIdleConnections(IoLoop* loop) {
+    auto deadline = std::chrono::steady_clock::now() - keepalive_timeout_;
+    std::vector<std::shared_ptr<Connection>> idle;
+    for (const auto& item : loop->connections) {
+        const auto& conn = item.second;
+        if (!conn->busy && conn->out_offset >= conn->out_buf.size() &&
+            conn->last_active < deadline) {
+            idle.push_back(conn);
+        }
+    }
+    for (const auto& conn : idle) {
+        closeConnection(conn);
+    }
+}
+
+void SimpleHTTPServer::post(IoLoop* loop, std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(loop->task_mutex);
+    if (loop->stopped) {
+        return; // 服务器已停止，连接均已关闭，丢弃迟到的响应
+    }
+    loop->tasks.push_back(std::move(task));
+    // 在锁内写入，保证拆除流程关闭wake_fd之前完成
+    uint64_t one = 1;
+    ssize_t n = write(loop->wake_fd, &one, sizeof(one));
+    (void)n;
+}
+
+void SimpleHTTPServer::runPostedTasks(IoLoop* loop) {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(loop->task_mutex);
+        tasks.swap(loop->tasks);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void SimpleHTTPServer::handleAccept(IoLoop* loop) {
+    while (running_) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int client_fd = accept4(server_fd_, (struct sockaddr*)&client_addr, &client_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_WARN("HTTP", "accept失败: " + std::string(strerror(errno)));
+            }
+            return;
+        }
+
+        int nodelay = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        auto conn = std::make_shared<Connection>();
+        conn->fd = client_fd;
+        conn->loop = loop;
+        conn->last_active = std::chrono::steady_clock::now();
+
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.fd = client_fd;
+        if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            LOG_WARN("HTTP", "注册客户端socket失败: " + std::string(strerror(errno)));
+            close(client_fd);
+            continue;
+        }
+        loop->connections[client_fd] = conn;
+        activeConnections().add(1);
+    }
+}
+
+void SimpleHTTPServer::handleReadable(const std::shared_ptr<Connection>& conn) {
+    // 边缘触发：必须一次读到EAGAIN为止
+    char buffer[16384];
+    conn->last_active = std::chrono::steady_clock::now();
+    while (true) {
+        ssize_t n = read(conn->fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            conn->in_buf.append(buffer, static_cast<size_t>(n));
+            if (conn->in_buf.size() > max_buffered_bytes) {
+                LOG_WARN("HTTP", "请求过大，关闭连接");
+                closeConnection(conn);
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            conn->peer_closed = true;
+            break;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        closeConnection(conn);
+        return;
+    }
+
+    dispatchRequest(conn);
+
+    // 对端已关闭且没有待处理/待发送的数据
+    if (!conn->closed && conn->peer_closed && !conn->busy &&
+        conn->out_offset >= conn->out_buf.size()) {
+        closeConnection(conn);
+    }
+}
+
+void SimpleHTTPServer::dispatchRequest(const std::shared_ptr<Connection>& conn) {
+    if (conn->busy || conn->closed || conn->close_after_write || conn->in_buf.empty()) {
+        return;
+    }
+
+    auto parse_start = std::chrono::steady_clock::now();
+    HttpRequestParser::Status status = conn->parser.parse(&conn->in_buf[0], conn->in_buf.size());
+    if (status == HttpRequestParser::Status::NeedMore) {
+        // 客户端在发送请求体前等待100 Continue
+        if (conn->parser.headersComplete() && conn->parser.expectContinue() && !conn->continue_sent) {
+            conn->continue_sent = true;
+            conn->out_buf.append("HTTP/1.1 100 Continue\r\n\r\n");
+            flushOutput(conn);
+        }
+        return;
+    }
+
+    if (status == HttpRequestParser::Status::Error) {
+        LOG_WARN("HTTP", "请求解析失败: " + conn->parser.errorMessage());
+        conn->keep_alive = false;
+        queueResponse(conn, utils::HttpUtils::createErrorResponse(conn->parser.errorStatus(),
+                                                                  conn->parser.errorMessage()));
+        return;
+    }
+
+    requestParseSeconds().observeSince(parse_start);
+
+    // 把读缓冲区整体交给请求（不拷贝），流水线中剩余的数据留在连接上
+    auto pending = std::make_shared<PendingRequest>();
+    size_t consumed = conn->parser.consumed();
+    pending->buffer.swap(conn->in_buf);
+    if (pending->buffer.size() > consumed) {
+        conn->in_buf.assign(pending->buffer, consumed, std::string::npos);
+    }
+    conn->parser.fill(pending->buffer.data(), pending->request);
+    conn->parser.reset();
+    auto log_context = std::make_shared<utils::LogContext>();
+    log_context->request_id = utils::LogContext::newRequestId();
+    pending->log_context = std::move(log_context);
+    pending->started_at = std::chrono::steady_clock::now();
+    conn->continue_sent = false;
+
+    conn->busy = true;
+    conn->requests_served++;
+    conn->keep_alive = pending->request.keep_alive && running_ &&
+                       (max_keepalive_requests_ <= 0 ||
+                        conn->requests_served < max_keepalive_requests_);
+
+    // 响应可能在工作线程或HTTP客户端回调线程中产生，统一投递回所属IO线程
+    auto stream = std::make_shared<ResponseStream>(this, conn, pending);
+    workers_->submit([this, pending, stream]() {
+        // 本请求在工作线程及其后的异步回调中输出的日志都带有同一个request_id
+        utils::ScopedLogContext log_scope(pending->log_context);
+        try {
+            route(pending->request, stream);
+        } catch (const std::exception& e) {
+            LOG_ERROR("HTTP", "处理请求异常: " + std::string(e.what()));
+            stream->respond(utils::HttpUtils::createErrorResponse(500, "服务器内部错误"));
+        }
+    });
+}
+
+void SimpleHTTPServer::onResponse(const std::shared_ptr<Connection>& conn,
+                                  const std::shared_ptr<PendingRequest>& pending,
+                                  std::string response) {
+    if (!conn->closed) {
+        queueResponse(conn, std::move(response));
+    }
+    finishRequest(conn, pending);
+}
+
+void SimpleHTTPServer::onStreamData(const std::shared_ptr<Connection>& conn, std::string data) {
+    if (conn->closed) {
+        return;
+    }
+    conn->last_active = std::chrono::steady_clock::now();
+    conn->out_buf.append(data);
+    flushOutput(conn);
+}
+
+void SimpleHTTPServer::finishRequest(const std::shared_ptr<Connection>& conn,
+                                     const std::shared_ptr<PendingRequest>& pending) {
+    conn->busy = false;
+    if (conn->closed) {
+        return;
+    }
+
+    // 归还读缓冲区，下一个请求复用其容量
+    if (conn->in_buf.empty() && pending->buffer.capacity() > conn->in_buf.capacity()) {
+        pending->buffer.clear();
+        conn->in_buf.swap(pending->buffer);
+    }
+
+    bool drained = conn->out_offset >= conn->out_buf.size();
+    if (conn->close_after_write) {
+        if (drained) {
+            closeConnection(conn);
+        }
+        return; // 否则在flushOutput写完后关闭
+    }
+
+    // 继续处理流水线中已缓冲的下一个请求
+    dispatchRequest(conn);
+    if (!conn->closed && conn->peer_closed && !conn->busy &&
+        conn->out_offset >= conn->out_buf.size()) {
+        closeConnection(conn);
+    }
+}
+
+SimpleHTTPServer::ResponseStream::ResponseStream(SimpleHTTPServer* server,
+                                                 std::shared_ptr<Connection> conn,
+                                                 std::shared_ptr<PendingRequest> pending)
+    : server_(server), conn_(std::move(conn)), pending_(std::move(pending)) {
+}
+
+void SimpleHTTPServer::ResponseStream::logCompletion(int status) const {
+    auto elapsed = std::chrono::steady_clock::now() - pending_->started_at;
+    requestSeconds().observeMicros(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    if (status >= 400) {
+        requestErrors().inc();
+    }
+    double latency_ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    const HttpRequest& request = pending_->request;
+    LOG_INFO_FIELDS("HTTP", "请求完成",
+                    utils::LogFields()
+                        .add("method", request.method)
+                        .add("path", request.path)
+                        .add("status", status)
+                        .add("latency_ms", latency_ms));
+
+    utils::Tracer& tracer = utils::Tracer::getInstance();
+    if (tracer.enabled()) {
+        utils::ScopedLogContext log_scope(pending_->log_context);
+        std::string args;
+        utils::Tracer::appendArg(args, "method", request.method);
+        utils::Tracer::appendArg(args, "path", request.path);
+        utils::Tracer::appendArg(args, "status", static_cast<long long>(status));
+        tracer.record("http_request", "http", pending_->started_at, std::chrono::steady_clock::now(),
+                      std::move(args));
+    }
+}
+
+void SimpleHTTPServer::ResponseStream::respond(std::string response) {
+    // 状态行形如 "HTTP/1.1 200 OK"
+    int status = 0;
+    if (response.size() > 12) {
+        status = std::atoi(response.c_str() + 9);
+    }
+    logCompletion(status);
+    utils::HttpUtils::insertHeader(response, "X-Request-Id: " + pending_->log_context->request_id);
+
+    SimpleHTTPServer* server = server_;
+    auto conn = conn_;
+    auto pending = pending_;
+    server_->post(conn_->loop, [server, conn, pending, response]() mutable {
+        server->onResponse(conn, pending, std::move(response));
+    });
+}
+
+void SimpleHTTPServer::ResponseStream::begin(const std::string& content_type) {
+    std::string head = "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: " + content_type + "\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Transfer-Encoding: chunked\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "X-Accel-Buffering: no\r\n"
+                       "X-Request-Id: " + pending_->log_context->request_id + "\r\n"
+                       "\r\n";
+    SimpleHTTPServer* server = server_;
+    auto conn = conn_;
+    server_->post(conn_->loop, [server, conn, head]() mutable {
+        if (!conn->closed) {
+            server->queueResponse(conn, std::move(head));
+        }
+    });
+}
+
+void SimpleHTTPServer::ResponseStream::write(const std::string& data) {
+    if (data.empty()) {
+        return; // 空chunk表示响应结束，不能发送
+    }
+    char size_line[24];
+    int n = snprintf(size_line, sizeof(size_line), "%zx\r\n", data.size());
+    std::string chunk;
+    chunk.reserve(static_cast<size_t>(n) + data.size() + 2);
+    chunk.append(size_line, static_cast<size_t>(n));
+    chunk.append(data);
+    chunk.append("\r\n");
+
+    SimpleHTTPServer* server = server_;
+    auto conn = conn_;
+    std::lock_guard<std::mutex> lock(end_mutex_);
+    if (ended_) {
+        return;
+    }
+    server_->post(conn_->loop, [server, conn, chunk]() mutable {
+        server->onStreamData(conn, std::move(chunk));
+    });
+}
+
+void SimpleHTTPServer::ResponseStream::end() {
+    {
+        std::lock_guard<std::mutex> lock(end_mutex_);
+        if (ended_) {
+            return;
+        }
+        ended_ = true;
+        SimpleHTTPServer* server = server_;
+        auto conn = conn_;
+        auto pending = pending_;
+        server_->post(conn_->loop, [server, conn, pending]() {
+            server->onStreamData(conn, "0\r\n\r\n");
+            server->finishRequest(conn, pending);
+        });
+    }
+    logCompletion(200);
+}
+
+void SimpleHTTPServer::queueResponse(const std::shared_ptr<Connection>& conn, std::string response) {
+    if (conn->keep_alive) {
+        utils::HttpUtils::insertHeader(response, "Connection: keep-alive\r\nKeep-Alive: timeout=" +
+                                       std::to_string(keepalive_timeout_.count() / 1000) +
+                                       ", max=" + std::to_string(max_keepalive_requests_));
+    } else {
+        utils::HttpUtils::insertHeader(response, "Connection: close");
+        conn->close_after_write = true;
+    }
+
+    conn->last_active = std::chrono::steady_clock::now();
+    conn->out_buf.append(response);
+    flushOutput(conn);
+}
+
+void SimpleHTTPServer::flushOutput(const std::shared_ptr<Connection>& conn) {
+    while (conn->out_offset < conn->out_buf.size()) {
+        ssize_t n = send(conn->fd, conn->out_buf.data() + conn->out_offset,
+                         conn->out_buf.size() - conn->out_offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            conn->out_offset += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return; // 等待下一次EPOLLOUT
+        }
+        closeConnection(conn);
+        return;
+    }
+
+    conn->out_buf.clear();
+    conn->out_offset = 0;
+    if (conn->close_after_write && !conn->busy) {
+        closeConnection(conn);
+    }
+}
+
+void SimpleHTTPServer::closeConnection(const std::shared_ptr<Connection>& conn) {
+    if (conn->closed) {
+        return;
+    }
+    conn->closed = true;
+    activeConnections().add(-1);
+    epoll_ctl(conn->loop->epoll_fd, EPOLL_CTL_DEL, conn->fd, nullptr);
+    close(conn->fd);
+    conn->loop->connections.erase(conn->fd);
+}
+
+void SimpleHTTPServer::route(const HttpRequest& request, const std::shared_ptr<ResponseStream>& stream) {
+    Responder respond = [stream](std::string response) {
+        stream->respond(std::move(response));
+    };
+    if (request.method == "GET" && (request.path == "/" || request.path == "/index.html")) {
+        // 返回静态HTML页面
+        respond(serveStaticFile("index.html"));
+        return;
+    }
+    if (request.method == "POST" && request.path == "/agent/chat") {
+        // 处理聊天请求（异步响应）
+        handleChatRequest(request, respond);
+        return;
+    }
+    if (request.method == "POST" && request.path == "/agent/chat/stream") {
+        // 流式聊天（text/event-stream）
+        handleChatStreamRequest(request, stream);
+        return;
+    }
+    if (request.method == "GET" && request.path == "/agent/tts") {
+        // 查询语音任务进度
+        respond(handleTtsJobRequest(request));
+        return;
+    }
+    if (request.method == "GET" && request.path == "/metrics") {
+        // Prometheus文本格式的指标
+        respond(handleMetricsRequest());
+        return;
+    }
+    if (request.method == "POST" && request.path == "/debug/trace") {
+        // 采集一段时间的trace（采集结束后才响应）
+        handleTraceRequest(request, respond);
+        return;
+    }
+    if (request.method == "POST" && request.path == "/agent/save-prefer") {
+        // 处理保存偏好请求
+        respond(handleSavePreferRequest(request));
+        return;
+    }
+    respond("HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 9\r\n\r\nNot Found");
+}
+
+std::string SimpleHTTPServer::serveStaticFile(const std::string& filepath) {
+    // 尝试多个路径
+    std::vector<std::string> paths = {
+        filepath,
+        "static/" + filepath,
+        "./static/" + filepath
+    };
+
+    // 如果filepath是index.html，尝试从可执行文件目录查找
+    if (filepath == "index.html" || filepath == "/index.html" || filepath == "/") {
+        char exe_path[1024];
+        ssize_t len = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
+        if (len != -1) {
+            exe_path[len] = '\0';
+            std::string exe_dir = std::string(exe_path);
+            size_t last_slash = exe_dir.find_last_of("/");
+            if (last_slash != std::string::npos) {
+                exe_dir = exe_dir.substr(0, last_slash + 1);
+                paths.insert(paths.begin(), exe_dir + "static/index.html");
+            }
+        }
+    }
+
+    std::string actual_path;
+    std::ifstream file;
+    bool found = false;
+
+    for (const auto& path : paths) {
+        file.open(path, std::ios::binary);
+        if (file.is_open()) {
+            actual_path = path;
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        return "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 14\r\n\r\nFile Not Found";
+    }
+
+    std::ostringstream content;
+    content << file.rdbuf();
+    file.close();
+
+    std::string content_type = utils::HttpUtils::getContentType(actual_path);
+
+    std::ostringstream response;
+    response << "HTTP/1.1 200 OK\r\n"
+             << "Content-Type: " << content_type << "\r\n"
+             << "Content-Length: " << content.str().length() << "\r\n"
+             << "Access-Control-Allow-Origin: *\r\n"
+             << "\r\n"
+             << content.str();
+
+    return response.str();
+}
+
+// 取出异常描述
+static std::string exceptionMessage(std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        return e.what();
+    } catch (...) {
+        return "未知错误";
+    }
+}
+
+// 解析聊天请求参数，失败时返回false并给出错误信息
+static bool parseChatParams(const HttpRequest& request, std::string& session_id,
+                            std::string& user_id, std::string& user_input, std::string& error) {
+    if (request.body.empty()) {
+        error = "参数错误：缺少请求体";
+        return false;
+    }
+
+    utils::JsonDocument doc;
+    if (!doc.parse(request.body) || !doc.root().isObject()) {
+        error = "参数错误：请求体不是有效的JSON对象";
+        return false;
+    }
+    session_id = doc.getString("session_id");
+    user_id = doc.getString("user_id");
+    user_input = doc.getString("input");
+
+    if (session_id.empty()) {
+        error = "参数错误：缺少session_id";
+        return false;
+    }
+    if (user_id.empty()) {
+        error = "参数错误：缺少user_id";
+        return false;
+    }
+    if (user_input.empty()) {
+        error = "参数错误：缺少input";
+        return false;
+    }
+    return true;
+}
+
+// 保存本轮对话到短期记忆，并提交后台关键词提取（不等待结果）
+static void rememberChatRound(const std::string& session_id, const std::string& user_id,
+                              const std::string& user_input, const std::string& reply_text) {
+    auto& short_mem = memory::ShortTermMemory::getInstance();
+    memory::ChatRound round;
+    round.session_id = session_id;
+    round.user_id = user_id;
+    round.input = user_input;
+    round.reply = reply_text;
+    round.timestamp = std::chrono::system_clock::now();
+    short_mem.saveShortTerm(std::move(round));
+
+    llm::MemoryEnrichment::getInstance().submit(user_id, session_id,
+                                                short_mem.getShortTermContext(user_id, session_id));
+}
+
+// 构造一个SSE事件
+static std::string sseEvent(const std::string& event, const std::string& json_data) {
+    return "event: " + event + "\ndata: " + json_data + "\n\n";
+}
+
+// 写入语音分段的JSON表示；status为pending/ok/failed
+static void writeSegment(utils::JsonWriter& json, size_t index, const tts::TtsSegment& segment) {
+    const char* status = "pending";
+    if (segment.status == tts::TtsSegment::Status::Ok) {
+        status = "ok";
+    } else if (segment.status == tts::TtsSegment::Status::Failed) {
+        status = "failed";
+    }
+    json.beginObject()
+        .key("index").value(index)
+        .key("status").value(status)
+        .key("text").value(segment.text)
+        .key("audio_url").value(segment.audio_url)
+        .key("tts_err").value(segment.error)
+        .endObject();
+}
+
+void SimpleHTTPServer::handleChatRequest(const HttpRequest& request, Responder respond) {
+    utils::TraceSpan span("handleChatRequest", "http");
+    std::string session_id;
+    std::string user_id;
+    std::string user_input;
+    std::string param_error;
+    if (!parseChatParams(request, session_id, user_id, user_input, param_error)) {
+        respond(utils::HttpUtils::createErrorResponse(400, param_error));
+        return;
+    }
+
+    utils::ScopedLogContext log_scope(user_id, session_id);
+    LOG_INFO("HTTP", "收到聊天请求 (会话: " + session_id + ", 用户: " + user_id + ")");
+
+    // 以下步骤均为异步调用，等待上游响应期间不占用工作线程
+    // 1. 调用大模型生成文本回复
+    llm::callLLMAsync(session_id, user_id, user_input,
+                      [respond, session_id, user_id, user_input](const std::string& reply_text,
+                                                                 std::exception_ptr error) {
+        if (error) {
+            respond(utils::HttpUtils::createErrorResponse(500, "生成回复失败：" + exceptionMessage(error)));
+            return;
+        }
+
+        // 2. 提交异步语音任务（分句并发合成），客户端凭tts_job_id轮询结果
+        auto job = tts::TtsJobManager::getInstance().createJob();
+        job->appendText(reply_text);
+        job->finish();
+
+        // 3. 保存短期记忆，后台提取习惯关键词并更新长期记忆
+        rememberChatRound(session_id, user_id, user_input, reply_text);
+
+        // 4. 构造返回数据
+        utils::TraceSpan json_span("build_response", "json");
+        utils::JsonWriter json;
+        json.beginObject()
+            .key("code").value(200)
+            .key("msg").value("success")
+            .key("data").beginObject()
+                .key("text").value(reply_text)
+                .key("tts_job_id").value(job->id())
+            .endObject()
+            .endObject();
+
+        respond(utils::HttpUtils::createJsonResponse(json.str()));
+    });
+}
+
+void SimpleHTTPServer::handleChatStreamRequest(const HttpRequest& request,
+                                               const std::shared_ptr<ResponseStream>& stream) {
+    utils::TraceSpan span("handleChatStreamRequest", "http");
+    std::string session_id;
+    std::string user_id;
+    std::string user_input;
+    std::string param_error;
+    if (!parseChatParams(request, session_id, user_id, user_input, param_error)) {
+        stream->respond(utils::HttpUtils::createErrorResponse(400, param_error));
+        return;
+    }
+
+    utils::ScopedLogContext log_scope(user_id, session_id);
+    LOG_INFO("HTTP", "收到流式聊天请求 (会话: " + session_id + ", 用户: " + user_id + ")");
+
+    // 事件：token（增量文本，多次）、done（完整文本）、audio（语音分段，按顺序，多次）；
+    // 文本生成过程中每凑齐一句就开始合成，audio事件可能早于done到达。
+    // 出错时发送error；所有语音分段结束（或出错）后关闭流
+    stream->begin("text/event-stream; charset=utf-8");
+
+    auto job = tts::TtsJobManager::getInstance().createJob(
+        [stream](size_t index, const tts::TtsSegment& segment) {
+            utils::JsonWriter json;
+            writeSegment(json, index, segment);
+            stream->write(sseEvent("audio", json.str()));
+        },
+        [stream]() {
+            stream->end();
+        });
+
+    llm::callLLMStreamAsync(session_id, user_id, user_input,
+                            [stream, job](const std::string& delta) {
+        if (stream->clientGone()) {
+            return false; // 浏览器已断开，取消上游生成
+        }
+        utils::JsonWriter json;
+        json.beginObject().key("delta").value(delta).endObject();
+        stream->write(sseEvent("token", json.str()));
+        job->appendText(delta);
+        return true;
+    },
+                            [stream, job, session_id, user_id, user_input](const std::string& reply_text,
+                                                                           std::exception_ptr error) {
+        if (error) {
+            utils::JsonWriter json;
+            json.beginObject().key("msg").value("生成回复失败：" + exceptionMessage(error)).endObject();
+            stream->write(sseEvent("error", json.str()));
+            job->cancel();
+            return;
+        }
+
+        rememberChatRound(session_id, user_id, user_input, reply_text);
+        utils::JsonWriter json;
+        json.beginObject().key("text").value(reply_text).key("tts_job_id").value(job->id()).endObject();
+        stream->write(sseEvent("done", json.str()));
+        job->finish();
+    });
+}
+
+std::string SimpleHTTPServer::handleTtsJobRequest(const HttpRequest& request) {
+    std::string job_id(request.queryParam("job_id"));
+    if (job_id.empty()) {
+        return utils::HttpUtils::createErrorResponse(400, "参数错误：缺少job_id");
+    }
+
+    auto job = tts::TtsJobManager::getInstance().findJob(job_id);
+    if (!job) {
+        return utils::HttpUtils::createErrorResponse(404, "语音任务不存在或已过期");
+    }
+
+    tts::TtsJobSnapshot snap = job->snapshot();
+    utils::JsonWriter json;
+    json.beginObject()
+        .key("code").value(200)
+        .key("msg").value("success")
+        .key("data").beginObject()
+            .key("job_id").value(snap.id)
+            .key("done").value(snap.done)
+            .key("segments").beginArray();
+    for (size_t i = 0; i < snap.segments.size(); ++i) {
+        writeSegment(json, i, snap.segments[i]);
+    }
+    json.endArray().endObject().endObject();
+    return utils::HttpUtils::createJsonResponse(json.str());
+}
+
+// 各模块已有的统计接口在输出时读取，转换为Prometheus样本
+static void appendModuleStats(std::string& out) {
+    using utils::MetricsRegistry;
+
+    llm::EnrichmentStats enrichment = llm::MemoryEnrichment::getInstance().getStats();
+    MetricsRegistry::appendSample(out, "agent_enrichment_queue_depth", "gauge", "记忆增强队列中等待处理的任务数",
+                                  static_cast<double>(enrichment.queue_depth));
+    MetricsRegistry::appendSample(out, "agent_enrichment_submitted_total", "counter", "记忆增强任务提交次数",
+                                  static_cast<double>(enrichment.submitted));
+    MetricsRegistry::appendSample(out, "agent_enrichment_deduplicated_total", "counter",
+                                  "与同一用户待处理任务合并的提交次数", static_cast<double>(enrichment.deduplicated));
+    MetricsRegistry::appendSample(out, "agent_enrichment_dropped_total", "counter", "队列已满或关闭超时被丢弃的记忆增强任务数",
+                                  static_cast<double>(enrichment.dropped));
+    MetricsRegistry::appendSample(out, "agent_enrichment_processed_total", "counter", "已完成的记忆增强任务数",
+                                  static_cast<double>(enrichment.processed));
+    MetricsRegistry::appendSample(out, "agent_enrichment_lag_seconds", "gauge", "最近一个任务从提交到开始处理的延迟",
+                                  static_cast<double>(enrichment.last_lag_ms) / 1000);
+    MetricsRegistry::appendSample(out, "agent_enrichment_max_lag_seconds", "gauge", "任务从提交到开始处理的最大延迟",
+                                  static_cast<double>(enrichment.max_lag_ms) / 1000);
+
+    auto& http_client = utils::AsyncHttpClient::getInstance();
+    utils::HttpClientStats client = http_client.getStats();
+    MetricsRegistry::appendSample(out, "agent_http_client_in_flight", "gauge", "进行中的上游HTTP请求数",
+                                  static_cast<double>(http_client.inFlight()));
+    MetricsRegistry::appendSample(out, "agent_http_client_pool_idle", "gauge", "池中空闲的curl句柄数",
+                                  static_cast<double>(client.pool_idle));
+    MetricsRegistry::appendSample(out, "agent_http_client_handles_created_total", "counter", "新建的curl句柄数",
+                                  static_cast<double>(client.handles_created));
+    MetricsRegistry::appendSample(out, "agent_http_client_handles_reused_total", "counter", "从池中复用的curl句柄数",
+                                  static_cast<double>(client.handles_reused));
+    MetricsRegistry::appendSample(out, "agent_http_client_connections_new_total", "counter", "新建连接的成功上游传输数",
+                                  static_cast<double>(client.connections_new));
+    MetricsRegistry::appendSample(out, "agent_http_client_connections_reused_total", "counter",
+                                  "复用连接的成功上游传输数", static_cast<double>(client.connections_reused));
+    MetricsRegistry::appendSample(out, "agent_http_client_connect_seconds_total", "counter",
+                                  "上游传输建连（含TLS）耗时总和", static_cast<double>(client.connect_time_us) / 1e6);
+
+    llm::ResponseCacheStats llm_cache = llm::getResponseCacheStats();
+    MetricsRegistry::appendSample(out, "agent_llm_cache_entries", "gauge", "大模型响应缓存条目数",
+                                  static_cast<double>(llm_cache.cache.entries));
+    MetricsRegistry::appendSample(out, "agent_llm_cache_bytes", "gauge", "大模型响应缓存占用字节数",
+                                  static_cast<double>(llm_cache.cache.bytes));
+    MetricsRegistry::appendSample(out, "agent_llm_cache_hits_total", "counter", "大模型响应缓存命中次数",
+                                  static_cast<double>(llm_cache.cache.hits));
+    MetricsRegistry::appendSample(out, "agent_llm_cache_misses_total", "counter", "大模型响应缓存未命中次数",
+                                  static_cast<double>(llm_cache.cache.misses));
+    MetricsRegistry::appendSample(out, "agent_llm_coalesced_total", "counter", "与进行中的相同请求合并的大模型调用数",
+                                  static_cast<double>(llm_cache.coalesced));
+    MetricsRegistry::appendSample(out, "agent_llm_upstream_calls_total", "counter", "实际发起的大模型上游请求数",
+                                  static_cast<double>(llm_cache.upstream_calls));
+
+    tts::SpeechCacheStats tts_cache = tts::getSpeechCacheStats();
+    MetricsRegistry::appendSample(out, "agent_tts_cache_entries", "gauge", "语音缓存条目数",
+                                  static_cast<double>(tts_cache.cache.entries));
+    MetricsRegistry::appendSample(out, "agent_tts_cache_bytes", "gauge", "语音缓存占用字节数",
+                                  static_cast<double>(tts_cache.cache.bytes));
+    MetricsRegistry::appendSample(out, "agent_tts_cache_hits_total", "counter", "语音缓存命中次数",
+                                  static_cast<double>(tts_cache.cache.hits));
+    MetricsRegistry::appendSample(out, "agent_tts_cache_misses_total", "counter", "语音缓存未命中次数",
+                                  static_cast<double>(tts_cache.cache.misses));
+    MetricsRegistry::appendSample(out, "agent_tts_coalesced_total", "counter", "与进行中的相同文本合并的合成请求数",
+                                  static_cast<double>(tts_cache.coalesced));
+    MetricsRegistry::appendSample(out, "agent_tts_upstream_calls_total", "counter", "实际发起的语音合成上游请求数",
+                                  static_cast<double>(tts_cache.upstream_calls));
+
+    memory::ShortTermStats short_term = memory::ShortTermMemory::getInstance().getStats();
+    MetricsRegistry::appendSample(out, "agent_short_term_sessions", "gauge", "短期记忆中保存的会话数",
+                                  static_cast<double>(short_term.sessions));
+    MetricsRegistry::appendSample(out, "agent_short_term_bytes", "gauge", "短期记忆占用字节数（估算）",
+                                  static_cast<double>(short_term.bytes));
+    MetricsRegistry::appendSample(out, "agent_short_term_expired_total", "counter", "因空闲超时被清理的会话数",
+                                  static_cast<double>(short_term.expired));
+    MetricsRegistry::appendSample(out, "agent_short_term_evicted_total", "counter", "因超出内存预算被淘汰的会话数",
+                                  static_cast<double>(short_term.evicted));
+
+    MetricsRegistry::appendSample(out, "agent_log_dropped_total", "counter", "日志队列已满被丢弃的日志条数",
+                                  static_cast<double>(utils::Logger::getInstance().droppedCount()));
+}
+
+std::string SimpleHTTPServer::handleMetricsRequest() {
+    std::string body;
+    body.reserve(16384);
+    utils::MetricsRegistry::getInstance().render(body);
+    appendModuleStats(body);
+
+    std::string response = "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "\r\n";
+    response += body;
+    return response;
+}
+
+void SimpleHTTPServer::handleTraceRequest(const HttpRequest& request, Responder respond) {
+    int seconds = 10;
+    std::string_view seconds_param = request.queryParam("seconds");
+    if (!seconds_param.empty()) {
+        seconds = std::atoi(std::string(seconds_param).c_str());
+        if (seconds <= 0) {
+            respond(utils::HttpUtils::createErrorResponse(400, "参数错误：seconds必须是正整数"));
+            return;
+        }
+    }
+
+    // 响应体即trace JSON，可直接保存后在chrome://tracing或Perfetto中打开
+    bool started = utils::Tracer::getInstance().startCapture(
+        seconds, [respond](bool ok, const std::string& path, const std::string& json) {
+        if (!ok) {
+            respond(utils::HttpUtils::createErrorResponse(500, "写入trace文件失败"));
+            return;
+        }
+        std::string response = utils::HttpUtils::createJsonResponse(json);
+        utils::HttpUtils::insertHeader(response, "X-Trace-File: " + path);
+        respond(std::move(response));
+    });
+    if (!started) {
+        respond(utils::HttpUtils::createErrorResponse(409, "已有trace采集在进行中"));
+    }
+}
+
+std::string SimpleHTTPServer::handleSavePreferRequest(const HttpRequest& request) {
+    if (request.body.empty()) {
+        return utils::HttpUtils::createErrorResponse(400, "参数错误：缺少请求体");
+    }
+
+    utils::JsonDocument doc;
+    if (!doc.parse(request.body) || !doc.root().isObject()) {
+        return utils::HttpUtils::createErrorResponse(400, "参数错误：请求体不是有效的JSON对象");
+    }
+    std::string user_id = doc.getString("user_id");
+    std::string key = doc.getString("key");
+    std::string value = doc.getString("value");
+
+    if (user_id.empty() || key.empty() || value.empty()) {
+        return utils::HttpUtils::createErrorResponse(400, "参数错误：缺少必要字段");
+    }
+    utils::ScopedLogContext log_scope(user_id, "");
+
+    if (key == "keywords") {
+        auto& long_mem = memory::LongTermMemory::getInstance();
+        long_mem.mergeAndSaveLongTerm(user_id, value);
+    }
+
+    return utils::HttpUtils::createJsonResponse("{\"code\":200,\"msg\":\"偏好保存成功\"}");
+}
+
+} // namespace server
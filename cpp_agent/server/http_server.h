@@ -0,0 +1,170 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <chrono>
+#include <unordered_map>
+#include "http_parser.h"
+#include "../utils/thread_pool.h"
+#include "../utils/logger.h"
+
+namespace server {
+
+/**
+ * @brief 基于epoll的HTTP服务器
+ *
+ * - IO线程（server_io_threads）：每个线程持有一个epoll实例，以边缘触发方式
+ *   管理自己接受的客户端socket，负责读请求、写响应
+ * - 工作线程（server_worker_threads）：执行路由和业务处理；调用大模型、TTS等上游
+ *   接口时通过utils::AsyncHttpClient异步发起，等待期间不占用工作线程
+ *
+ * 线程数量固定，不随连接数增长；每个连接只占用一个Connection对象和读写缓冲区。
+ *
+ * 支持HTTP/1.1持久连接：同一连接上的多个请求（包括流水线请求）按到达顺序
+ * 逐个处理，空闲超过server_keepalive_timeout_sec或处理请求数达到
+ * server_max_keepalive_requests后关闭连接。
+ */
+class SimpleHTTPServer {
+public:
+    explicit SimpleHTTPServer(int port);
+    ~SimpleHTTPServer();
+
+    /**
+     * @brief 启动服务器（阻塞直到stop()被调用）
+     *
+     * 返回后IO循环已停止，但其对象保留到析构：上游回调、记忆增强、追踪采集等
+     * 异步生产者可能仍在投递响应，此时post()为空操作。因此服务器对象必须在
+     * 这些生产者关闭之后再析构。
+     */
+    void start();
+
+    /**
+     * @brief 停止服务器（可在信号处理函数中调用）
+     */
+    void stop();
+
+private:
+    struct IoLoop;
+
+    // 单个客户端连接，只允许在所属IO线程中访问
+    struct Connection {
+        int fd = -1;
+        IoLoop* loop = nullptr;
+        std::string in_buf;             // 读缓冲区，请求解析器直接在其上工作
+        HttpRequestParser parser{max_body_bytes};
+        bool continue_sent = false;
+        std::string out_buf;
+        size_t out_offset = 0;
+        bool busy = false;              // 请求正在工作线程中处理
+        std::atomic<bool> closed{false};  // 流式响应会在其他线程读取
+        bool peer_closed = false;       // 对端已关闭写方向
+        bool close_after_write = false;
+        bool keep_alive = false;        // 当前请求处理完后是否保持连接
+        int requests_served = 0;
+        std::chrono::steady_clock::time_point last_active;
+    };
+
+    // 已解析、正在工作线程中处理的请求；request中的string_view指向buffer
+    struct PendingRequest {
+        std::string buffer;
+        HttpRequest request;
+        utils::LogContextPtr log_context;   // 携带本请求的request_id
+        std::chrono::steady_clock::time_point started_at;
+    };
+
+    /**
+     * 单个请求的响应通道，可在任意线程调用，数据统一投递回所属IO线程发送。
+     * 两种用法二选一：
+     * - respond()：一次性发送完整的HTTP响应
+     * - begin() + write()... + end()：以chunked编码流式发送（如text/event-stream）
+     * write()可在多个线程中并发调用（每次调用发送一个完整的chunk）；最终必须调用
+     * respond()或end()之一，end()之后的write()会被忽略。
+     */
+    class ResponseStream {
+    public:
+        ResponseStream(SimpleHTTPServer* server, std::shared_ptr<Connection> conn,
+                       std::shared_ptr<PendingRequest> pending);
+
+        void respond(std::string response);
+        void begin(const std::string& content_type);
+        void write(const std::string& data);
+        void end();
+
+        // 客户端连接已关闭，继续写入没有意义
+        bool clientGone() const { return conn_->closed; }
+
+    private:
+        // 输出请求完成日志（状态码、耗时），在调用respond()/end()的线程中执行
+        void logCompletion(int status) const;
+
+        SimpleHTTPServer* server_;
+        std::shared_ptr<Connection> conn_;
+        std::shared_ptr<PendingRequest> pending_;
+        // write()与end()的检查和投递在此锁内完成，保证结束chunk之后不会再投递数据
+        std::mutex end_mutex_;
+        bool ended_ = false;
+    };
+
+    struct IoLoop {
+        int epoll_fd = -1;
+        int wake_fd = -1;
+        std::thread thread;
+        std::mutex task_mutex;
+        std::vector<std::function<void()>> tasks;
+        bool stopped = false;           // 已拆除，post()直接丢弃任务（受task_mutex保护）
+        std::unordered_map<int, std::shared_ptr<Connection>> connections;
+    };
+
+    // IO线程
+    void runLoop(IoLoop* loop);
+    void post(IoLoop* loop, std::function<void()> task);
+    void runPostedTasks(IoLoop* loop);
+    void handleAccept(IoLoop* loop);
+    void handleReadable(const std::shared_ptr<Connection>& conn);
+    void flushOutput(const std::shared_ptr<Connection>& conn);
+    void dispatchRequest(const std::shared_ptr<Connection>& conn);
+    void onResponse(const std::shared_ptr<Connection>& conn,
+                    const std::shared_ptr<PendingRequest>& pending,
+                    std::string response);
+    void onStreamData(const std::shared_ptr<Connection>& conn, std::string data);
+    void finishRequest(const std::shared_ptr<Connection>& conn,
+                       const std::shared_ptr<PendingRequest>& pending);
+    void queueResponse(const std::shared_ptr<Connection>& conn, std::string response);
+    void closeConnection(const std::shared_ptr<Connection>& conn);
+    void closeIdleConnections(IoLoop* loop);
+
+    // 工作线程；Responder可在任意线程调用一次，把响应交回IO线程发送
+    using Responder = std::function<void(std::string response)>;
+    void route(const HttpRequest& request, const std::shared_ptr<ResponseStream>& stream);
+    std::string serveStaticFile(const std::string& filepath);
+    void handleChatRequest(const HttpRequest& request, Responder respond);
+    void handleChatStreamRequest(const HttpRequest& request, const std::shared_ptr<ResponseStream>& stream);
+    std::string handleTtsJobRequest(const HttpRequest& request);
+    std::string handleSavePreferRequest(const HttpRequest& request);
+    std::string handleMetricsRequest();
+    void handleTraceRequest(const HttpRequest& request, Responder respond);
+
+    int port_;
+    std::atomic<bool> running_;
+    int server_fd_;
+    size_t io_thread_count_;
+    size_t worker_thread_count_;
+    std::chrono::milliseconds keepalive_timeout_;
+    int max_keepalive_requests_;
+    std::vector<std::unique_ptr<IoLoop>> loops_;
+    std::unique_ptr<utils::ThreadPool> workers_;
+
+    static constexpr size_t max_body_bytes = 8 * 1024 * 1024;
+    // 单个连接读缓冲区上限（含流水线中尚未处理的请求）
+    static constexpr size_t max_buffered_bytes = 2 * max_body_bytes;
+};
+
+} // namespace server
+
+#endif // HTTP_SERVER_H
@@ -0,0 +1,571 @@
+// JSON解析器的随机/性质测试
+//
+// 用法：json_fuzz_test [迭代次数] [随机种子]
+// - 随机文档经JsonWriter序列化（另一份把非ASCII字符全部写成\uXXXX）后，DOM和SAX的解析结果
+//   必须与原文档一致
+// - 字符串中的任意字节序列解析后必须是合法UTF-8：合法输入原样保留，非法字节逐个替换为U+FFFD
+// - 任意\uXXXX序列（含孤立的高/低代理和代理对）按UTF-16解码，孤立代理替换为U+FFFD
+// - 截断或篡改的文档不能导致崩溃，解析成功时其中的字符串仍是合法UTF-8
+// 失败时输出用例和种子，返回非零。
+
+#include "utils/json.h"
+#include "utils/json_parser.h"
+#include "utils/json_scan.h"
+#include "utils/json_writer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using utils::JsonDocument;
+using utils::JsonReader;
+using utils::JsonType;
+using utils::JsonValue;
+using utils::JsonWriter;
+
+namespace {
+
+int failures = 0;
+
+void reportFailure(const char* what, const std::string& input) {
+    if (++failures <= 10) {
+        std::string shown = input.size() > 300 ? input.substr(0, 300) + "..." : input;
+        std::fprintf(stderr, "FAIL: %s\n  输入(%zu字节): ", what, input.size());
+        for (unsigned char c : shown) {
+            if (c >= 0x20 && c < 0x7f) {
+                std::fputc(c, stderr);
+            } else {
+                std::fprintf(stderr, "\\x%02x", c);
+            }
+        }
+        std::fputc('\n', stderr);
+    }
+}
+
+#define CHECK(cond, what, input) \
+    do { \
+        if (!(cond)) reportFailure(what, input); \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+// 参考实现：逐字节的UTF-8校验与解码，不依赖json_scan.h中的快速路径
+
+// 返回从p[i]开始的合法UTF-8序列长度，不合法时返回0
+size_t utf8SequenceLength(const std::string& s, size_t i) {
+    unsigned char c = static_cast<unsigned char>(s[i]);
+    if (c < 0x80) {
+        return 1;
+    }
+    size_t len;
+    uint32_t cp;
+    if (c >= 0xC2 && c <= 0xDF) {
+        len = 2;
+        cp = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        len = 3;
+        cp = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        len = 4;
+        cp = c & 0x07;
+    } else {
+        return 0;
+    }
+    if (s.size() - i < len) {
+        return 0;
+    }
+    for (size_t k = 1; k < len; ++k) {
+        unsigned char cc = static_cast<unsigned char>(s[i + k]);
+        if ((cc & 0xC0) != 0x80) {
+            return 0;
+        }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    if ((len == 3 && cp < 0x800) || (len == 4 && (cp < 0x10000 || cp > 0x10FFFF)) ||
+        (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return 0;
+    }
+    return len;
+}
+
+bool isValidUtf8(const std::string& s) {
+    for (size_t i = 0; i < s.size();) {
+        size_t len = utf8SequenceLength(s, i);
+        if (len == 0) {
+            return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+// 非法字节逐个替换为U+FFFD
+std::string sanitizeUtf8(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size();) {
+        size_t len = utf8SequenceLength(s, i);
+        if (len == 0) {
+            out += "\xEF\xBF\xBD";
+            ++i;
+        } else {
+            out.append(s, i, len);
+            i += len;
+        }
+    }
+    return out;
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+void appendUnicodeEscape(std::string& out, uint32_t unit) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "\\u%04X", unit);
+    out += buf;
+}
+
+// 把合法UTF-8文本中的每个非ASCII码点写成\uXXXX（必要时为代理对），其余按JsonWriter转义
+std::string escapeAllNonAscii(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80) {
+            JsonWriter::appendEscaped(out, std::string_view(&text[i], 1));
+            ++i;
+            continue;
+        }
+        size_t len = utf8SequenceLength(text, i);
+        uint32_t cp = c & (len == 2 ? 0x1F : len == 3 ? 0x0F : 0x07);
+        for (size_t k = 1; k < len; ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        }
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            appendUnicodeEscape(out, 0xD800 + (cp >> 10));
+            appendUnicodeEscape(out, 0xDC00 + (cp & 0x3FF));
+        } else {
+            appendUnicodeEscape(out, cp);
+        }
+        i += len;
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// 随机文档模型
+
+struct Node {
+    JsonType type = JsonType::Null;
+    bool flag = false;
+    double number = 0;
+    std::string text;
+    std::vector<Node> items;
+    std::vector<std::pair<std::string, Node>> members;
+};
+
+class Generator {
+public:
+    explicit Generator(uint32_t seed) : rng_(seed) {}
+
+    int range(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng_); }
+
+    // 合法UTF-8字符串：ASCII（含引号、反斜杠、控制字符）、2/3/4字节码点混合
+    std::string text(int max_len) {
+        std::string out;
+        int len = range(0, max_len);
+        for (int i = 0; i < len; ++i) {
+            switch (range(0, 9)) {
+                case 0: out += static_cast<char>(range(0, 0x1f)); break;
+                case 1: out += range(0, 1) ? '"' : '\\'; break;
+                case 2: appendUtf8(out, static_cast<uint32_t>(range(0x80, 0x7FF))); break;
+                case 3: appendUtf8(out, static_cast<uint32_t>(range(0x4E00, 0x9FFF))); break;
+                case 4: {
+                    uint32_t cp = static_cast<uint32_t>(range(0x800, 0xFFFD));
+                    appendUtf8(out, cp >= 0xD800 && cp <= 0xDFFF ? 0xFF0C : cp);
+                    break;
+                }
+                case 5: appendUtf8(out, static_cast<uint32_t>(range(0x10000, 0x10FFFF))); break;
+                default: out += static_cast<char>(range(0x20, 0x7e)); break;
+            }
+        }
+        return out;
+    }
+
+    // 任意字节，偏向容易出错的UTF-8前导/后续字节
+    std::string bytes(int max_len) {
+        std::string out;
+        int len = range(0, max_len);
+        for (int i = 0; i < len; ++i) {
+            switch (range(0, 5)) {
+                case 0: out += static_cast<char>(range(0x80, 0xBF)); break;
+                case 1: out += static_cast<char>(range(0xC0, 0xF7)); break;
+                case 2: out += static_cast<char>(range(0xF8, 0xFF)); break;
+                case 3: appendUtf8(out, static_cast<uint32_t>(range(0x4E00, 0x9FFF))); break;
+                default: out += static_cast<char>(range(0, 0xFF)); break;
+            }
+        }
+        return out;
+    }
+
+    double number() {
+        switch (range(0, 3)) {
+            case 0: return range(-1000, 1000);
+            case 1: return static_cast<double>(std::uniform_int_distribution<long long>(
+                                -(1LL << 53), 1LL << 53)(rng_));
+            case 2: return std::uniform_real_distribution<double>(-1e6, 1e6)(rng_);
+            default: return std::uniform_real_distribution<double>(-1, 1)(rng_) * 1e-30;
+        }
+    }
+
+    Node node(int depth) {
+        Node n;
+        int kind = depth >= 6 ? range(0, 3) : range(0, 5);
+        switch (kind) {
+            case 0: n.type = JsonType::Null; break;
+            case 1: n.type = JsonType::Bool; n.flag = range(0, 1) == 1; break;
+            case 2: n.type = JsonType::Number; n.number = number(); break;
+            case 3: n.type = JsonType::String; n.text = text(24); break;
+            case 4: {
+                n.type = JsonType::Array;
+                int count = range(0, 6);
+                for (int i = 0; i < count; ++i) n.items.push_back(node(depth + 1));
+                break;
+            }
+            default: {
+                n.type = JsonType::Object;
+                int count = range(0, 6);
+                for (int i = 0; i < count; ++i) n.members.emplace_back(text(12), node(depth + 1));
+                break;
+            }
+        }
+        return n;
+    }
+
+    std::mt19937& rng() { return rng_; }
+
+private:
+    std::mt19937 rng_;
+};
+
+void writeNode(JsonWriter& json, const Node& n) {
+    switch (n.type) {
+        case JsonType::Null: json.null(); break;
+        case JsonType::Bool: json.value(n.flag); break;
+        case JsonType::Number: json.value(n.number); break;
+        case JsonType::String: json.value(n.text); break;
+        case JsonType::Array:
+            json.beginArray();
+            for (const auto& item : n.items) writeNode(json, item);
+            json.endArray();
+            break;
+        case JsonType::Object:
+            json.beginObject();
+            for (const auto& member : n.members) {
+                json.key(member.first);
+                writeNode(json, member.second);
+            }
+            json.endObject();
+            break;
+    }
+}
+
+// 与JsonWriter结构相同，但字符串中的非ASCII字符全部写成\uXXXX
+void writeNodeEscaped(std::string& out, const Node& n) {
+    char buf[32];
+    switch (n.type) {
+        case JsonType::Null: out += "null"; break;
+        case JsonType::Bool: out += n.flag ? "true" : "false"; break;
+        case JsonType::Number:
+            std::snprintf(buf, sizeof(buf), "%.17g", n.number);
+            out += buf;
+            break;
+        case JsonType::String: out += '"'; out += escapeAllNonAscii(n.text); out += '"'; break;
+        case JsonType::Array:
+            out += '[';
+            for (size_t i = 0; i < n.items.size(); ++i) {
+                if (i) out += ',';
+                writeNodeEscaped(out, n.items[i]);
+            }
+            out += ']';
+            break;
+        case JsonType::Object:
+            out += '{';
+            for (size_t i = 0; i < n.members.size(); ++i) {
+                if (i) out += ',';
+                out += '"';
+                out += escapeAllNonAscii(n.members[i].first);
+                out += "\":";
+                writeNodeEscaped(out, n.members[i].second);
+            }
+            out += '}';
+            break;
+    }
+}
+
+bool sameValue(const Node& n, const JsonValue& v) {
+    if (n.type != v.type()) {
+        return false;
+    }
+    switch (n.type) {
+        case JsonType::Null: return true;
+        case JsonType::Bool: return n.flag == v.asBool();
+        case JsonType::Number: return n.number == v.asNumber();
+        case JsonType::String: return v.asString() == n.text;
+        case JsonType::Array:
+            if (v.size() != n.items.size()) return false;
+            for (size_t i = 0; i < n.items.size(); ++i) {
+                if (!sameValue(n.items[i], v[i])) return false;
+            }
+            return true;
+        case JsonType::Object:
+            if (v.size() != n.members.size()) return false;
+            for (size_t i = 0; i < n.members.size(); ++i) {
+                if (v.member(i).key != n.members[i].first || !sameValue(n.members[i].second, v.member(i).value)) {
+                    return false;
+                }
+            }
+            return true;
+    }
+    return false;
+}
+
+bool allStringsValid(const JsonValue& v) {
+    switch (v.type()) {
+        case JsonType::String: return isValidUtf8(std::string(v.asString()));
+        case JsonType::Array:
+            for (size_t i = 0; i < v.size(); ++i) {
+                if (!allStringsValid(v[i])) return false;
+            }
+            return true;
+        case JsonType::Object:
+            for (size_t i = 0; i < v.size(); ++i) {
+                if (!isValidUtf8(std::string(v.member(i).key)) || !allStringsValid(v.member(i).value)) return false;
+            }
+            return true;
+        default: return true;
+    }
+}
+
+// SAX事件序列，与expectedEvents()生成的序列逐项比较
+class EventRecorder : public utils::JsonHandler {
+public:
+    std::vector<std::string> events;
+
+    bool onNull() override { events.push_back("null"); return true; }
+    bool onBool(bool value) override { events.push_back(value ? "true" : "false"); return true; }
+    bool onNumber(std::string_view, double value) override {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "n%.17g", value);
+        events.push_back(buf);
+        return true;
+    }
+    bool onString(std::string_view value) override { events.push_back("s" + std::string(value)); return true; }
+    bool onKey(std::string_view key) override { events.push_back("k" + std::string(key)); return true; }
+    bool onStartObject() override { events.push_back("{"); return true; }
+    bool onEndObject(size_t count) override { events.push_back("}" + std::to_string(count)); return true; }
+    bool onStartArray() override { events.push_back("["); return true; }
+    bool onEndArray(size_t count) override { events.push_back("]" + std::to_string(count)); return true; }
+};
+
+void expectedEvents(const Node& n, std::vector<std::string>& events) {
+    char buf[32];
+    switch (n.type) {
+        case JsonType::Null: events.push_back("null"); break;
+        case JsonType::Bool: events.push_back(n.flag ? "true" : "false"); break;
+        case JsonType::Number:
+            std::snprintf(buf, sizeof(buf), "n%.17g", n.number);
+            events.push_back(buf);
+            break;
+        case JsonType::String: events.push_back("s" + n.text); break;
+        case JsonType::Array:
+            events.push_back("[");
+            for (const auto& item : n.items) expectedEvents(item, events);
+            events.push_back("]" + std::to_string(n.items.size()));
+            break;
+        case JsonType::Object:
+            events.push_back("{");
+            for (const auto& member : n.members) {
+                events.push_back("k" + member.first);
+                expectedEvents(member.second, events);
+            }
+            events.push_back("}" + std::to_string(n.members.size()));
+            break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+void testRoundTrip(Generator& gen) {
+    Node root = gen.node(0);
+    std::string plain;
+    {
+        JsonWriter json(plain);
+        writeNode(json, root);
+    }
+    std::string escaped;
+    writeNodeEscaped(escaped, root);
+
+    for (const std::string* input : {&plain, &escaped}) {
+        JsonDocument doc;
+        bool ok = doc.parse(*input);
+        CHECK(ok, "随机文档解析失败", *input);
+        CHECK(!ok || sameValue(root, doc.root()), "DOM与原文档不一致", *input);
+
+        EventRecorder recorder;
+        std::vector<std::string> expected;
+        expectedEvents(root, expected);
+        CHECK(JsonReader::parse(*input, recorder) && recorder.events == expected, "SAX事件与原文档不一致",
+              *input);
+    }
+
+    // 截断和单字节篡改：不能崩溃，成功时字符串必须合法
+    for (int i = 0; i < 4 && !plain.empty(); ++i) {
+        std::string mutated = plain;
+        size_t pos = static_cast<size_t>(gen.range(0, static_cast<int>(mutated.size()) - 1));
+        if (i == 0) {
+            mutated.resize(pos);
+        } else {
+            mutated[pos] = static_cast<char>(gen.range(0, 0xFF));
+        }
+        JsonDocument doc;
+        if (doc.parse(mutated)) {
+            CHECK(allStringsValid(doc.root()), "篡改后的文档解析出非法UTF-8", mutated);
+        }
+    }
+}
+
+void testArbitraryBytes(Generator& gen) {
+    std::string raw = gen.bytes(40);
+    std::string literal = "\"";
+    JsonWriter::appendEscaped(literal, raw);
+    literal += '"';
+
+    std::string expected = sanitizeUtf8(raw);
+    JsonDocument doc;
+    bool ok = doc.parse(literal);
+    CHECK(ok, "含任意字节的字符串解析失败", literal);
+    if (ok) {
+        std::string value(doc.root().asString());
+        CHECK(isValidUtf8(value), "解析结果不是合法UTF-8", literal);
+        CHECK(value == expected, "非法字节未按字节替换为U+FFFD", literal);
+    }
+
+    // 快速校验与逐字节参考实现一致
+    CHECK((utils::validUtf8Prefix(raw.data(), raw.size()) == raw.size()) == isValidUtf8(raw),
+          "validUtf8Prefix与参考实现不一致", raw);
+
+    std::string unescaped;
+    JsonReader::unescape(literal.substr(1, literal.size() - 2), unescaped);
+    CHECK(unescaped == expected, "JsonReader::unescape结果与参考实现不一致", literal);
+    CHECK(utils::JsonParser::unescapeJsonString(literal.substr(1, literal.size() - 2)) == expected,
+          "JsonParser::unescapeJsonString结果与参考实现不一致", literal);
+}
+
+void testSurrogates(Generator& gen) {
+    std::string escaped;
+    std::string expected;
+    int tokens = gen.range(1, 12);
+    for (int i = 0; i < tokens; ++i) {
+        switch (gen.range(0, 5)) {
+            case 0: {   // 代理对
+                uint32_t cp = static_cast<uint32_t>(gen.range(0x10000, 0x10FFFF));
+                appendUnicodeEscape(escaped, 0xD800 + ((cp - 0x10000) >> 10));
+                appendUnicodeEscape(escaped, 0xDC00 + ((cp - 0x10000) & 0x3FF));
+                appendUtf8(expected, cp);
+                break;
+            }
+            case 1:     // 孤立的高代理（后面不是低代理）
+                appendUnicodeEscape(escaped, static_cast<uint32_t>(gen.range(0xD800, 0xDBFF)));
+                expected += "\xEF\xBF\xBD";
+                escaped += 'x';
+                expected += 'x';
+                break;
+            case 2:     // 孤立的低代理
+                appendUnicodeEscape(escaped, static_cast<uint32_t>(gen.range(0xDC00, 0xDFFF)));
+                expected += "\xEF\xBF\xBD";
+                break;
+            case 3: {   // 高代理后跟非代理的\u转义：高代理替换，后者照常解码
+                appendUnicodeEscape(escaped, static_cast<uint32_t>(gen.range(0xD800, 0xDBFF)));
+                uint32_t cp = static_cast<uint32_t>(gen.range(0x4E00, 0x9FFF));
+                appendUnicodeEscape(escaped, cp);
+                expected += "\xEF\xBF\xBD";
+                appendUtf8(expected, cp);
+                break;
+            }
+            case 4: {   // 普通BMP码点（含\u0000）
+                uint32_t cp = static_cast<uint32_t>(gen.range(0, 0xD7FF));
+                appendUnicodeEscape(escaped, cp);
+                appendUtf8(expected, cp);
+                break;
+            }
+            default: {
+                std::string text = gen.text(4);
+                JsonWriter::appendEscaped(escaped, text);
+                expected += text;
+                break;
+            }
+        }
+    }
+    // 末尾的孤立高代理
+    if (gen.range(0, 3) == 0) {
+        appendUnicodeEscape(escaped, static_cast<uint32_t>(gen.range(0xD800, 0xDBFF)));
+        expected += "\xEF\xBF\xBD";
+    }
+
+    std::string out;
+    CHECK(JsonReader::unescape(escaped, out) && out == expected, "\\u转义解码结果错误", escaped);
+    JsonDocument doc;
+    std::string literal = "\"" + escaped + "\"";
+    CHECK(doc.parse(literal) && doc.root().asString() == expected, "DOM中\\u转义解码结果错误", literal);
+}
+
+void testEdgeCases() {
+    JsonDocument doc;
+    // 超过嵌套深度上限时返回错误而不是栈溢出
+    std::string deep(100000, '[');
+    CHECK(!doc.parse(deep), "过深的嵌套未被拒绝", std::string("[[[..."));
+    // 无效转义、未结束的字符串和\u序列
+    const char* invalid[] = {"\"\\x\"", "\"abc", "\"\\u12\"", "\"\\uZZZZ\"", "\"\\", "[1,]", "{\"a\" 1}",
+                             "\"\x01\"", "01", "1.", "-", "tru", "nul"};
+    for (const char* input : invalid) {
+        CHECK(!doc.parse(input), "非法文档未被拒绝", std::string(input));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 20261016u;
+    Generator gen(seed);
+
+    testEdgeCases();
+    for (int i = 0; i < iterations; ++i) {
+        testRoundTrip(gen);
+        testArbitraryBytes(gen);
+        testSurrogates(gen);
+    }
+
+    if (failures > 0) {
+        std::fprintf(stderr, "json_fuzz_test: %d 项失败 (迭代 %d, 种子 %u)\n", failures, iterations, seed);
+        return 1;
+    }
+    std::printf("json_fuzz_test: 通过 (迭代 %d, 种子 %u)\n", iterations, seed);
+    return 0;
+}
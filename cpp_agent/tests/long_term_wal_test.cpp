@@ -0,0 +1,305 @@
+// LongTermMemory持久化与故障恢复测试
+//
+// 用法：long_term_wal_test
+// LongTermMemory是单例，数据文件路径相对于当前目录，因此每个场景在临时目录下的独立子目录中
+// 运行，每次"启动"都在单独的子进程中完成。写入时使用long_term_fsync=always（更新返回时
+// 已写入WAL）并关闭后台压缩，子进程不调用close()直接退出即模拟进程崩溃。覆盖：
+// - 正常关闭后从快照恢复；崩溃后从WAL重放
+// - WAL尾部记录写了一半：截掉不完整的尾部，之后的追加从有效位置开始
+// - WAL记录CRC不匹配：丢弃该记录及之后的内容
+// - 快照损坏：重命名为.corrupt，WAL中的更新仍然恢复
+// - 压缩时快照rename之后、清空WAL之前崩溃：重放已写入快照的记录结果不变
+// - 旧版JSON迁移：合法JSON、旧版未转义写出的文件、完全无法读取的文件
+// 强化次数和时间都相同的关键词按文本字节序展示，期望值按此给出。
+// 失败时输出场景和检查项，返回非零。
+
+#include "memory/long_term.h"
+#include "utils/config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const snapshot_path = "./data/long_term_memory.snap";
+const char* const wal_path = "./data/long_term_memory.wal";
+const char* const legacy_path = "./data/long_term_memory.json";
+
+int failures = 0;
+
+#define CHECK(cond, what) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "FAIL: %s (%s:%d)\n", what, __FILE__, __LINE__); \
+            failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected, what) \
+    do { \
+        std::string actual_value = (actual); \
+        if (actual_value != (expected)) { \
+            std::fprintf(stderr, "FAIL: %s (%s:%d)\n  实际: %s\n  期望: %s\n", what, __FILE__, __LINE__, \
+                         actual_value.c_str(), std::string(expected).c_str()); \
+            failures++; \
+        } \
+    } while (0)
+
+bool exists(const char* path) {
+    struct stat st;
+    return ::stat(path, &st) == 0;
+}
+
+size_t fileSize(const char* path) {
+    struct stat st;
+    return ::stat(path, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+std::string readFile(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void writeFile(const char* path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+void appendFile(const char* path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file << content;
+}
+
+// 在子进程中以一次"启动"运行fn；close为false时直接退出，模拟崩溃
+template <typename Fn>
+void boot(const char* step, bool close, Fn fn) {
+    std::fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::perror("fork");
+        std::exit(1);
+    }
+    if (pid == 0) {
+        failures = 0;
+        auto& config = utils::Config::getInstance();
+        config.setString("long_term_fsync", "always");
+        config.setString("long_term_compact_interval_sec", "0");
+        config.setString("long_term_compact_wal_bytes", "0");
+        auto& memory = memory::LongTermMemory::getInstance();
+        if (memory.init() != 0) {
+            std::fprintf(stderr, "FAIL: %s: init()失败\n", step);
+            std::_Exit(1);
+        }
+        fn(memory);
+        if (close) {
+            memory.close();
+        }
+        std::fflush(stdout);
+        std::_Exit(failures > 0 ? 1 : 0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::fprintf(stderr, "FAIL: 步骤\"%s\"失败\n", step);
+        failures++;
+    }
+}
+
+// 在临时目录下为场景创建独立的工作目录
+void enterScenario(const std::string& root, const char* name) {
+    std::string dir = root + "/" + name;
+    if (::mkdir(dir.c_str(), 0755) != 0 || ::chdir(dir.c_str()) != 0 || ::mkdir("data", 0755) != 0) {
+        std::perror(dir.c_str());
+        std::exit(1);
+    }
+    std::printf("- %s\n", name);
+}
+
+void testSnapshotRoundTrip(const std::string& root) {
+    enterScenario(root, "snapshot");
+    boot("写入后正常关闭", true, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u1", "钓鱼，跑步");
+        m.mergeAndSaveLongTerm("u1", "钓鱼");
+        m.mergeAndSaveLongTerm("u2", "电影");
+    });
+    CHECK(exists(snapshot_path), "close()后应写出快照");
+    CHECK(fileSize(wal_path) == 0, "close()后WAL应被清空");
+    boot("从快照恢复", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "钓鱼，跑步", "u1按强化次数排序");
+        CHECK_EQ(m.getLongTerm("u2"), "电影", "u2");
+        CHECK_EQ(m.getLongTerm("u3"), "无", "不存在的用户");
+    });
+}
+
+void testWalReplay(const std::string& root) {
+    enterScenario(root, "wal_replay");
+    boot("写入后崩溃", false, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u1", "钓鱼，跑步");
+        m.mergeAndSaveLongTerm("u2", "电影");
+    });
+    CHECK(!exists(snapshot_path), "未压缩时不应有快照");
+    CHECK(fileSize(wal_path) > 0, "更新应已写入WAL");
+    boot("从WAL重放", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "跑步，钓鱼", "u1");
+        CHECK_EQ(m.getLongTerm("u2"), "电影", "u2");
+    });
+}
+
+void testTornTail(const std::string& root) {
+    enterScenario(root, "torn_tail");
+    boot("写入后崩溃", false, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u1", "钓鱼");
+    });
+    size_t valid = fileSize(wal_path);
+    // 负载长度声明为64字节，实际只写了一部分
+    std::string torn("\x40\x00\x00\x00\x12\x34\x56\x78\x02\x00\x00\x00u2", 14);
+    appendFile(wal_path, torn);
+    boot("截断尾部后继续写入", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "钓鱼", "尾部之前的记录");
+        CHECK_EQ(m.getLongTerm("u2"), "无", "不完整的记录");
+        m.mergeAndSaveLongTerm("u3", "跑步");
+    });
+    CHECK(fileSize(wal_path) > valid, "新记录应追加在有效位置之后");
+    boot("再次重放", false, [valid](memory::LongTermMemory& m) {
+        CHECK(fileSize(wal_path) > valid, "截断后的WAL不应再被截断");
+        CHECK_EQ(m.getLongTerm("u1"), "钓鱼", "u1");
+        CHECK_EQ(m.getLongTerm("u3"), "跑步", "截断后追加的记录");
+    });
+}
+
+void testCrcMismatch(const std::string& root) {
+    enterScenario(root, "crc_mismatch");
+    boot("写入第一条", false, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u1", "钓鱼");
+    });
+    size_t first = fileSize(wal_path);
+    boot("写入第二条", false, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u2", "电影");
+    });
+    std::string wal = readFile(wal_path);
+    CHECK(wal.size() > first, "第二条记录应追加到WAL");
+    wal.back() ^= 0x5a;   // 改写第二条记录负载的最后一个字节
+    writeFile(wal_path, wal);
+    boot("重放", false, [first](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "钓鱼", "CRC正确的记录");
+        CHECK_EQ(m.getLongTerm("u2"), "无", "CRC不匹配的记录应丢弃");
+        CHECK(fileSize(wal_path) == first, "WAL应截断到最后一条有效记录之后");
+    });
+}
+
+void testCorruptSnapshot(const std::string& root) {
+    enterScenario(root, "corrupt_snapshot");
+    boot("写入快照", true, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u1", "钓鱼");
+    });
+    boot("写入WAL后崩溃", false, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u2", "电影");
+    });
+    std::string garbage = "LTMSNAP1";
+    garbage.append(64, '\xff');
+    writeFile(snapshot_path, garbage);
+    boot("快照损坏时启动", false, [](memory::LongTermMemory& m) {
+        CHECK(exists("./data/long_term_memory.snap.corrupt"), "损坏的快照应重命名为.corrupt");
+        CHECK(!exists(snapshot_path), "损坏的快照不应留在原位");
+        CHECK_EQ(m.getLongTerm("u1"), "无", "损坏快照中的数据无法恢复");
+        CHECK_EQ(m.getLongTerm("u2"), "电影", "WAL中的更新仍应恢复");
+    });
+}
+
+void testCrashBeforeWalTruncate(const std::string& root) {
+    enterScenario(root, "crash_after_rename");
+    boot("写入后崩溃", false, [](memory::LongTermMemory& m) {
+        m.mergeAndSaveLongTerm("u1", "钓鱼");
+        m.mergeAndSaveLongTerm("u1", "跑步，钓鱼");
+    });
+    std::string wal = readFile(wal_path);
+    boot("压缩为快照", true, [](memory::LongTermMemory&) {});
+    CHECK(exists(snapshot_path) && fileSize(wal_path) == 0, "close()应压缩并清空WAL");
+    // 模拟快照已rename、WAL尚未清空时崩溃：快照和WAL中都有同样的更新
+    writeFile(wal_path, wal);
+    boot("重放已压缩的记录", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "钓鱼，跑步", "重放不应重复强化");
+        m.mergeAndSaveLongTerm("u1", "跑步");
+        m.mergeAndSaveLongTerm("u1", "跑步");
+        CHECK_EQ(m.getLongTerm("u1"), "跑步，钓鱼", "强化次数3比2");
+    });
+}
+
+void testLegacyJson(const std::string& root) {
+    enterScenario(root, "legacy_json");
+    writeFile(legacy_path, "{\n  \"u1\": \"钓鱼，跑步\",\n  \"u2\": \"电影\"\n}\n");
+    boot("迁移", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "跑步，钓鱼", "u1");
+        CHECK_EQ(m.getLongTerm("u2"), "电影", "u2");
+    });
+    CHECK(exists(snapshot_path), "迁移后应写出快照");
+    CHECK(!exists(legacy_path) && exists("./data/long_term_memory.json.migrated"),
+          "原文件应重命名为.migrated");
+    boot("迁移后从快照启动", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "跑步，钓鱼", "u1");
+    });
+}
+
+void testLegacyUnescapedJson(const std::string& root) {
+    enterScenario(root, "legacy_unescaped");
+    // 旧版saveToFile不转义：反斜杠和制表符原样写入，严格的JSON解析会失败
+    writeFile(legacy_path, "{\n  \"u1\": \"钓鱼，C:\\tools\\q\",\n  \"u2\": \"跑步\t夜跑\"\n}\n");
+    boot("宽松迁移", false, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "C:\\tools\\q，钓鱼", "含反斜杠的值原样保留");
+        CHECK_EQ(m.getLongTerm("u2"), "跑步\t夜跑", "含控制字符的值原样保留");
+    });
+    CHECK(exists(snapshot_path) && exists("./data/long_term_memory.json.migrated"), "应完成迁移");
+}
+
+void testLegacyUnreadableJson(const std::string& root) {
+    enterScenario(root, "legacy_unreadable");
+    writeFile(legacy_path, "this is not json at all");
+    boot("无法迁移时启动", true, [](memory::LongTermMemory& m) {
+        CHECK_EQ(m.getLongTerm("u1"), "无", "空存储");
+        m.mergeAndSaveLongTerm("u1", "钓鱼");
+    });
+    CHECK(!exists(legacy_path), "无法迁移的文件不应留在原位被快照遮住");
+    CHECK_EQ(readFile("./data/long_term_memory.json.corrupt"), "this is not json at all",
+             "无法迁移的文件应原样保留为.corrupt");
+}
+
+} // namespace
+
+int main() {
+    char dir[] = "/tmp/long_term_wal_test.XXXXXX";
+    if (!mkdtemp(dir)) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    std::string root = dir;
+
+    testSnapshotRoundTrip(root);
+    testWalReplay(root);
+    testTornTail(root);
+    testCrcMismatch(root);
+    testCorruptSnapshot(root);
+    testCrashBeforeWalTruncate(root);
+    testLegacyJson(root);
+    testLegacyUnescapedJson(root);
+    testLegacyUnreadableJson(root);
+
+    if (::chdir("/") == 0) {
+        std::string command = "rm -rf '" + root + "'";
+        if (std::system(command.c_str()) != 0) {
+            std::fprintf(stderr, "清理临时目录失败: %s\n", root.c_str());
+        }
+    }
+    if (failures > 0) {
+        std::fprintf(stderr, "long_term_wal_test: %d 项失败\n", failures);
+        return 1;
+    }
+    std::printf("long_term_wal_test: 通过\n");
+    return 0;
+}
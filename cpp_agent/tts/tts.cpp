@@ -1,110 +1,239 @@
 #include "tts.h"
 #include "../utils/config.h"
 #include "../utils/logger.h"
-#include "../utils/json_parser.h"
-#include <curl/curl.h>
+#include "../utils/json.h"
+#include "../utils/json_writer.h"
+#include "../utils/http_client.h"
+#include "../utils/single_flight.h"
+#include "../utils/metrics.h"
 #include <iostream>
+#include <future>
+#include <memory>
 #include <cstdlib>
 #include <cstring>
-#include <sstream>
-#include <regex>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
 
 namespace tts {
 
-struct WriteData {
-    std::string data;
+// 请求参数，同时参与缓存键的计算
+static const char* const tts_model = "qwen3-tts-flash";
+static const char* const tts_voice = "Cherry";
+static const char* const tts_language = "Chinese";
+static const char* const tts_format = "wav";
+
+// 音频URL距过期不足该时间时不再从缓存返回，留出客户端下载的时间
+static constexpr std::chrono::seconds url_expiry_margin(60);
+
+// 一次generateSpeech的耗时（含缓存命中和合并等待）
+static utils::Histogram& speechSeconds() {
+    static utils::Histogram& histogram = utils::MetricsRegistry::getInstance().histogram(
+        "agent_tts_speech_seconds", "generateSpeech从调用到得到音频URL的耗时（含缓存命中）");
+    return histogram;
+}
+
+/**
+ * 语音合成结果缓存：以(文本, 模型, 音色, 语言, 格式)的哈希为键缓存音频URL，
+ * 同一文本的并发请求合并为一次上游调用
+ */
+struct SpeechCache {
+    SpeechCache()
+        : results(static_cast<size_t>(std::max(0, utils::Config::getInstance().getInt("tts_cache_max_bytes", 4194304)))),
+          ttl(std::max(1, utils::Config::getInstance().getInt("tts_cache_ttl_sec", 3600))),
+          lookups(0), upstream_calls(0) {
+    }
+
+    utils::LruCache<std::string> results;
+    utils::SingleFlight<std::string> flights;
+    std::chrono::seconds ttl;
+    std::atomic<uint64_t> lookups;
+    std::atomic<uint64_t> upstream_calls;
 };
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t realsize = size * nmemb;
-    WriteData* wd = static_cast<WriteData*>(userp);
-    wd->data.append(static_cast<char*>(contents), realsize);
-    return realsize;
+static SpeechCache& speechCache() {
+    static SpeechCache cache;
+    return cache;
 }
 
-std::string generateSpeech(const std::string& text) {
-    if (text.empty()) {
-        throw std::runtime_error("文本内容为空");
+// 解析TTS响应，失败时抛出异常；expires_at为音频URL的过期时间（Unix秒，未返回时为0）
+static std::string parseSpeechResponse(const utils::HttpClientResponse& response, long long& expires_at) {
+    if (!response.transferOk()) {
+        LOG_ERROR("TTS", "调用TTS接口失败: " + response.error);
+        throw std::runtime_error("调用TTS接口失败");
     }
     
-    auto& config = utils::Config::getInstance();
-    std::string api_key = config.getString("aliyun_tts_key", "sk-21c5679fdf204dc9928a322e2738a75f");
-    if (api_key.empty()) {
-        throw std::runtime_error("aliyun_tts_key未配置");
+    if (response.status != 200) {
+        LOG_ERROR("TTS", "TTS接口返回错误，状态码: " + std::to_string(response.status));
+        LOG_ERROR("TTS", "响应内容: " + response.body.substr(0, 800));
+        throw std::runtime_error("TTS接口返回错误，状态码: " + std::to_string(response.status) +
+                                 "，响应内容: " + response.body.substr(0, 300));
     }
     
+    // 响应格式: {"output":{"audio":{"url":"...","expires_at":1700000000,...}}}
+    utils::JsonDocument doc;
+    if (!doc.parse(response.body)) {
+        throw std::runtime_error("响应格式错误，不是有效的JSON: " + doc.error());
+    }
+    const utils::JsonValue* audio = doc.find("output.audio");
+    if (!audio || !audio->isObject()) {
+        throw std::runtime_error("响应格式错误，无法提取音频URL");
+    }
+    const utils::JsonValue* url = audio->get("url");
+    std::string audio_url = url ? std::string(url->asString()) : "";
+    if (audio_url.empty()) {
+        throw std::runtime_error("TTS接口未返回音频URL");
+    }
+    const utils::JsonValue* expires = audio->get("expires_at");
+    expires_at = expires ? expires->asInt(0) : 0;
+    return audio_url;
+}
+
+// 计算缓存条目的过期时间：取配置的TTL与URL自身过期时间（减去余量）中较早者
+static bool cacheDeadline(const SpeechCache& cache, long long expires_at,
+                          std::chrono::steady_clock::time_point& deadline) {
+    auto now = std::chrono::steady_clock::now();
+    deadline = now + cache.ttl;
+    if (expires_at > 0) {
+        long long remaining = expires_at - static_cast<long long>(std::time(nullptr)) - url_expiry_margin.count();
+        if (remaining <= 0) {
+            return false;
+        }
+        if (std::chrono::seconds(remaining) < cache.ttl) {
+            deadline = now + std::chrono::seconds(remaining);
+        }
+    }
+    return true;
+}
+
+static void logCacheStats(const SpeechCache& cache) {
+    SpeechCacheStats stats = getSpeechCacheStats();
+    LOG_INFO("TTS", "语音缓存统计: 命中率 " + std::to_string(static_cast<int>(stats.cache.hitRatio() * 100)) +
+             "%, 节省上游调用 " + std::to_string(stats.savedCalls()) +
+             ", 上游调用 " + std::to_string(cache.upstream_calls.load()) +
+             ", 条目 " + std::to_string(stats.cache.entries) +
+             ", 占用 " + std::to_string(stats.cache.bytes / 1024) + "KB");
+}
+
+// 发起一次上游合成请求
+static void requestSpeech(const std::string& text, const std::string& api_key, uint64_t key, SpeechCallback done) {
     std::string api_url = "https://dashscope.aliyuncs.com/api/v1/services/aigc/multimodal-generation/generation";
 
-    std::string json_escaped_text = utils::JsonParser::escapeJsonString(text);
-    
-    std::ostringstream json_body;
-    json_body << "{"
-              << "\"model\":\"qwen3-tts-flash\","
-              << "\"input\":{"
-              << "\"text\":\"" << json_escaped_text << "\","
-              << "\"voice\":\"Cherry\","
-              << "\"language_type\":\"Chinese\""
-              << "},"
-              << "\"output\":{"
-              << "\"format\":\"wav\","
-              << "\"type\":\"audio\""
-              << "}"
-              << "}";
-
-    // 重要：json_body.str() 是临时对象，必须先落到string里再把c_str()给curl
-    std::string request_body = json_body.str();
+    utils::JsonWriter json;
+    json.beginObject()
+        .key("model").value(tts_model)
+        .key("input").beginObject()
+            .key("text").value(text)
+            .key("voice").value(tts_voice)
+            .key("language_type").value(tts_language)
+        .endObject()
+        .key("output").beginObject()
+            .key("format").value(tts_format)
+            .key("type").value("audio")
+        .endObject()
+    .endObject();
+    std::string request_body = json.str();
     LOG_DEBUG("TTS", "请求体: " + request_body.substr(0, 500));
     
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error("创建请求失败");
+    utils::HttpClientRequest request;
+    request.url = api_url;
+    request.headers.push_back("Content-Type: application/json");
+    request.headers.push_back("Authorization: Bearer " + api_key);
+    request.body = std::move(request_body);
+    request.timeout_ms = 10000;
+
+    auto& cache = speechCache();
+    cache.upstream_calls++;
+    utils::AsyncHttpClient::getInstance().send(std::move(request),
+                                               [done, key](utils::HttpClientResponse& response) {
+        std::string audio_url;
+        long long expires_at = 0;
+        try {
+            audio_url = parseSpeechResponse(response, expires_at);
+        } catch (...) {
+            done("", std::current_exception());
+            return;
+        }
+
+        auto& cache = speechCache();
+        std::chrono::steady_clock::time_point deadline;
+        if (cache.results.enabled() && cacheDeadline(cache, expires_at, deadline)) {
+            // 条目大小估计：URL + 链表/哈希表节点开销
+            size_t bytes = audio_url.size() + 128;
+            cache.results.put(key, audio_url, bytes, deadline);
+        }
+        done(audio_url, nullptr);
+    });
+}
+
+void generateSpeechAsync(const std::string& text, SpeechCallback done) {
+    if (text.empty()) {
+        done("", std::make_exception_ptr(std::runtime_error("文本内容为空")));
+        return;
     }
     
-    WriteData response_data;
-    
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    std::string auth_header = "Authorization: Bearer " + api_key;
-    headers = curl_slist_append(headers, auth_header.c_str());
-
-    curl_easy_setopt(curl, CURLOPT_URL, api_url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request_body.length()));
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-    
-    long response_code = 0;
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
-    
-    if (res != CURLE_OK) {
-        LOG_ERROR("TTS", "调用TTS接口失败: " + std::string(curl_easy_strerror(res)));
-        throw std::runtime_error("调用TTS接口失败");
+    auto& config = utils::Config::getInstance();
+    std::string api_key = config.getString("aliyun_tts_key", "sk-21c5679fdf204dc9928a322e2738a75f");
+    if (api_key.empty()) {
+        done("", std::make_exception_ptr(std::runtime_error("aliyun_tts_key未配置")));
+        return;
     }
-    
-    if (response_code != 200) {
-        LOG_ERROR("TTS", "TTS接口返回错误，状态码: " + std::to_string(response_code));
-        LOG_ERROR("TTS", "响应内容: " + response_data.data.substr(0, 800));
-        throw std::runtime_error("TTS接口返回错误，状态码: " + std::to_string(response_code) +
-                                 "，响应内容: " + response_data.data.substr(0, 300));
+
+    auto start = std::chrono::steady_clock::now();
+    done = [start, done = std::move(done)](const std::string& audio_url, std::exception_ptr error) {
+        speechSeconds().observeSince(start);
+        done(audio_url, error);
+    };
+
+    auto& cache = speechCache();
+    if (!cache.results.enabled()) {
+        requestSpeech(text, api_key, 0, std::move(done));
+        return;
     }
-    
-    // 解析响应，提取URL字段
-    std::regex url_regex(R"xxx("url"\s*:\s*"([^"]*)")xxx");
-    std::smatch match;
-    if (std::regex_search(response_data.data, match, url_regex)) {
-        std::string audio_url = utils::JsonParser::unescapeJsonString(match[1].str());
-        if (audio_url.empty()) {
-            throw std::runtime_error("TTS接口未返回音频URL");
-        }
-        return audio_url;
+
+    uint64_t key = utils::cacheKey({text, tts_model, tts_voice, tts_language, tts_format});
+    if (++cache.lookups % 100 == 0) {
+        logCacheStats(cache);
     }
-    
-    throw std::runtime_error("响应格式错误，无法提取音频URL");
+
+    std::string audio_url;
+    if (cache.results.get(key, audio_url)) {
+        LOG_DEBUG("TTS", "语音缓存命中 (文本长度: " + std::to_string(text.length()) + ")");
+        done(audio_url, nullptr);
+        return;
+    }
+
+    // 相同文本已有请求在进行时，等待其结果即可
+    if (!cache.flights.join(key, std::move(done))) {
+        LOG_DEBUG("TTS", "合并相同文本的语音请求 (文本长度: " + std::to_string(text.length()) + ")");
+        return;
+    }
+    requestSpeech(text, api_key, key, [key](const std::string& url, std::exception_ptr error) {
+        speechCache().flights.complete(key, url, error);
+    });
+}
+
+SpeechCacheStats getSpeechCacheStats() {
+    auto& cache = speechCache();
+    SpeechCacheStats stats;
+    stats.cache = cache.results.stats();
+    stats.coalesced = cache.flights.coalesced();
+    stats.upstream_calls = cache.upstream_calls;
+    return stats;
+}
+
+std::string generateSpeech(const std::string& text) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    generateSpeechAsync(text, [promise](const std::string& audio_url, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(audio_url);
+        }
+    });
+    return future.get();
 }
 
 } // namespace tts
@@ -2,11 +2,39 @@
 #define TTS_H
 
 #include <string>
+#include <functional>
+#include <exception>
+#include "../utils/lru_cache.h"
 
 namespace tts {
 
+// 异步回调：成功时error为空；失败时audio_url为空，error携带异常
+using SpeechCallback = std::function<void(const std::string& audio_url, std::exception_ptr error)>;
+
 std::string generateSpeech(const std::string& text);
 
+// 异步版本：不阻塞调用线程，回调在HTTP客户端回调线程中执行（缓存命中时在调用线程中执行）。
+// 相同(文本, 模型, 音色, 语言, 格式)的结果会被缓存（tts_cache_max_bytes、tts_cache_ttl_sec），
+// 并发的相同请求只发起一次上游调用
+void generateSpeechAsync(const std::string& text, SpeechCallback done);
+
+/**
+ * @brief 语音合成缓存统计
+ */
+struct SpeechCacheStats {
+    utils::LruCacheStats cache;
+    uint64_t coalesced = 0;        // 与进行中的相同请求合并的次数
+    uint64_t upstream_calls = 0;   // 实际发起的上游合成请求数
+
+    // 节省的上游调用 = 缓存命中 + 请求合并
+    uint64_t savedCalls() const { return cache.hits + coalesced; }
+};
+
+/**
+ * @brief 获取语音合成缓存统计（线程安全）
+ */
+SpeechCacheStats getSpeechCacheStats();
+
 } // namespace tts
 
 #endif // TTS_H
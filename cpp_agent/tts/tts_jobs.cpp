@@ -0,0 +1,272 @@
+#include "tts_jobs.h"
+#include "tts.h"
+#include "../utils/config.h"
+#include "../utils/logger.h"
+#include <cstring>
+#include <cstdio>
+#include <random>
+
+namespace tts {
+
+// 太短的句子与下一句合并，避免产生大量零碎的合成请求
+static constexpr size_t min_segment_bytes = 15;
+// 单个任务的分段上限，超出部分并入最后一段
+static constexpr size_t max_segments = 16;
+
+// 句末标点（UTF-8）
+static const char* const sentence_ends[] = {"。", "！", "？", "；", "…", "!", "?", ";", "\n"};
+// 紧跟在句末标点后、应归入本句的右引号/括号
+static const char* const closing_marks[] = {"”", "’", "」", "』", "）", "\"", "'", ")"};
+
+// 若pos处是给定符号之一，返回其字节长度，否则返回0
+static size_t matchAny(const std::string& text, size_t pos, const char* const* marks, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        size_t len = std::strlen(marks[i]);
+        if (text.compare(pos, len, marks[i]) == 0) {
+            return len;
+        }
+    }
+    return 0;
+}
+
+// 从from开始查找下一个句子的结束位置（句末标点及其后的引号之后），找不到返回npos
+static size_t findSentenceEnd(const std::string& text, size_t from) {
+    const size_t end_count = sizeof(sentence_ends) / sizeof(sentence_ends[0]);
+    const size_t close_count = sizeof(closing_marks) / sizeof(closing_marks[0]);
+    for (size_t pos = from; pos < text.size(); ++pos) {
+        size_t len = matchAny(text, pos, sentence_ends, end_count);
+        if (len == 0) {
+            continue;
+        }
+        pos += len;
+        // 连续的标点（如"！？"、"……"）和右引号都归入本句
+        while (pos < text.size()) {
+            size_t more = matchAny(text, pos, sentence_ends, end_count);
+            if (more == 0) {
+                more = matchAny(text, pos, closing_marks, close_count);
+            }
+            if (more == 0) {
+                break;
+            }
+            pos += more;
+        }
+        return pos;
+    }
+    return std::string::npos;
+}
+
+static std::string trimText(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+TtsJob::TtsJob(std::string id, SegmentCallback on_segment, JobDoneCallback on_done)
+    : id_(std::move(id)), created_at_(std::chrono::steady_clock::now()),
+      completed_(0), delivered_(0), finished_(false), done_notified_(false),
+      on_segment_(std::move(on_segment)), on_done_(std::move(on_done)) {
+}
+
+void TtsJob::appendText(const std::string& text) {
+    std::vector<size_t> indices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_ || done_notified_) {
+            return;
+        }
+        pending_text_ += text;
+        indices = cutSegments(false);
+    }
+    launch(indices);
+}
+
+void TtsJob::finish() {
+    std::vector<size_t> indices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_) {
+            return;
+        }
+        finished_ = true;
+        if (!done_notified_) {
+            indices = cutSegments(true);
+        }
+        // 没有任何分段（或都已完成）时直接结束
+        deliverLocked();
+    }
+    launch(indices);
+}
+
+void TtsJob::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+    pending_text_.clear();
+    on_segment_ = nullptr;
+    if (!done_notified_) {
+        done_notified_ = true;
+        if (on_done_) {
+            on_done_();
+        }
+    }
+    on_done_ = nullptr;
+}
+
+TtsJobSnapshot TtsJob::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TtsJobSnapshot snap;
+    snap.id = id_;
+    snap.done = finished_ && completed_ == segments_.size();
+    snap.segments = segments_;
+    return snap;
+}
+
+std::vector<size_t> TtsJob::cutSegments(bool flush) {
+    std::vector<size_t> indices;
+    size_t start = 0;
+    size_t search = 0;
+    while (segments_.size() + 1 < max_segments) {
+        size_t end = findSentenceEnd(pending_text_, search);
+        if (end == std::string::npos) {
+            break;
+        }
+        if (end - start < min_segment_bytes) {
+            search = end; // 太短，与下一句合并
+            continue;
+        }
+        std::string sentence = trimText(pending_text_.substr(start, end - start));
+        start = search = end;
+        if (sentence.empty()) {
+            continue;
+        }
+        TtsSegment segment;
+        segment.text = std::move(sentence);
+        segments_.push_back(std::move(segment));
+        indices.push_back(segments_.size() - 1);
+    }
+    pending_text_.erase(0, start);
+
+    if (flush) {
+        std::string rest = trimText(pending_text_);
+        pending_text_.clear();
+        if (!rest.empty()) {
+            TtsSegment segment;
+            segment.text = std::move(rest);
+            segments_.push_back(std::move(segment));
+            indices.push_back(segments_.size() - 1);
+        }
+    }
+    return indices;
+}
+
+void TtsJob::launch(const std::vector<size_t>& indices) {
+    // 在锁外发起合成：generateSpeechAsync出错时可能同步回调
+    for (size_t index : indices) {
+        std::string text;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            text = segments_[index].text;
+        }
+        LOG_DEBUG("TTS", "提交语音分段 (任务: " + id_ + ", 分段: " + std::to_string(index) +
+                  ", 长度: " + std::to_string(text.length()) + ")");
+        auto self = shared_from_this();
+        generateSpeechAsync(text, [self, index](const std::string& audio_url, std::exception_ptr error) {
+            self->onSegmentDone(index, audio_url, error);
+        });
+    }
+}
+
+void TtsJob::onSegmentDone(size_t index, const std::string& audio_url, std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TtsSegment& segment = segments_[index];
+    if (error) {
+        segment.status = TtsSegment::Status::Failed;
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            segment.error = e.what();
+        } catch (...) {
+            segment.error = "未知错误";
+        }
+        LOG_WARN("TTS", "语音分段生成失败 (任务: " + id_ + ", 分段: " + std::to_string(index) +
+                 "): " + segment.error);
+    } else {
+        segment.status = TtsSegment::Status::Ok;
+        segment.audio_url = audio_url;
+    }
+    completed_++;
+    deliverLocked();
+}
+
+void TtsJob::deliverLocked() {
+    while (delivered_ < segments_.size() &&
+           segments_[delivered_].status != TtsSegment::Status::Pending) {
+        if (on_segment_) {
+            on_segment_(delivered_, segments_[delivered_]);
+        }
+        delivered_++;
+    }
+
+    if (finished_ && !done_notified_ && delivered_ == segments_.size()) {
+        done_notified_ = true;
+        LOG_INFO("TTS", "语音任务完成 (任务: " + id_ + ", 分段数: " + std::to_string(segments_.size()) + ")");
+        if (on_done_) {
+            on_done_();
+        }
+        on_segment_ = nullptr;
+        on_done_ = nullptr;
+    }
+}
+
+TtsJobManager::TtsJobManager() : next_id_(0) {
+    auto& config = utils::Config::getInstance();
+    int ttl_sec = config.getInt("tts_job_ttl_sec", 600);
+    ttl_ = std::chrono::seconds(ttl_sec > 0 ? ttl_sec : 600);
+    std::random_device rd;
+    id_salt_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+    rng_.seed((static_cast<uint64_t>(rd()) << 32) | rd());
+}
+
+TtsJobManager& TtsJobManager::getInstance() {
+    static TtsJobManager instance;
+    return instance;
+}
+
+std::shared_ptr<TtsJob> TtsJobManager::createJob(SegmentCallback on_segment, JobDoneCallback on_done) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    removeExpiredLocked(now);
+
+    // 任务ID：自增序号与随机数混合，不可被轻易猜到
+    uint64_t seq = ++next_id_;
+    uint64_t mixed = (seq * 0x9E3779B97F4A7C15ULL) ^ id_salt_;
+    char id[40];
+    snprintf(id, sizeof(id), "%016llx%016llx", static_cast<unsigned long long>(mixed),
+             static_cast<unsigned long long>(rng_()));
+
+    auto job = std::make_shared<TtsJob>(id, std::move(on_segment), std::move(on_done));
+    jobs_[job->id()] = job;
+    expiry_order_.emplace_back(job->createdAt(), job->id());
+    return job;
+}
+
+std::shared_ptr<TtsJob> TtsJobManager::findJob(const std::string& job_id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(job_id);
+    if (it == jobs_.end() || std::chrono::steady_clock::now() - it->second->createdAt() > ttl_) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+void TtsJobManager::removeExpiredLocked(std::chrono::steady_clock::time_point now) {
+    // 任务按创建顺序入队，TTL固定，只需从队头清理
+    while (!expiry_order_.empty() && now - expiry_order_.front().first > ttl_) {
+        jobs_.erase(expiry_order_.front().second);
+        expiry_order_.pop_front();
+    }
+}
+
+} // namespace tts
@@ -0,0 +1,131 @@
+#ifndef TTS_JOBS_H
+#define TTS_JOBS_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <random>
+
+namespace tts {
+
+/**
+ * @brief 一段语音（对应回复中的一句或几句话）
+ */
+struct TtsSegment {
+    enum class Status { Pending, Ok, Failed };
+
+    std::string text;
+    Status status = Status::Pending;
+    std::string audio_url;
+    std::string error;
+};
+
+/**
+ * @brief 语音任务当前状态的快照
+ */
+struct TtsJobSnapshot {
+    std::string id;
+    bool done = false;                 // 文本已全部提交且所有分段均已完成
+    std::vector<TtsSegment> segments;
+};
+
+// 分段完成回调：按分段顺序依次调用
+using SegmentCallback = std::function<void(size_t index, const TtsSegment& segment)>;
+// 任务结束回调：所有分段都已回调（或任务被取消）后调用一次
+using JobDoneCallback = std::function<void()>;
+
+/**
+ * @brief 异步语音合成任务
+ *
+ * 回复文本可以一次性或边生成边追加：每凑齐一个完整句子就立即提交合成，
+ * 各分段并发合成，第一段语音不必等待整段回复生成完毕。
+ * 回调在持有任务锁时调用，需快速返回，且不能再调用本任务的方法。
+ */
+class TtsJob : public std::enable_shared_from_this<TtsJob> {
+public:
+    TtsJob(std::string id, SegmentCallback on_segment, JobDoneCallback on_done);
+
+    const std::string& id() const { return id_; }
+
+    /**
+     * @brief 追加回复文本，其中已完整的句子会立即提交合成
+     */
+    void appendText(const std::string& text);
+
+    /**
+     * @brief 文本已全部追加，剩余不完整的部分作为最后一段提交
+     */
+    void finish();
+
+    /**
+     * @brief 取消任务：不再回调on_segment，立即调用on_done；已提交的合成仍会完成
+     */
+    void cancel();
+
+    TtsJobSnapshot snapshot() const;
+
+    std::chrono::steady_clock::time_point createdAt() const { return created_at_; }
+
+private:
+    // 从pending_text_中切出完整句子，返回新分段的下标；需持有mutex_
+    std::vector<size_t> cutSegments(bool flush);
+    void launch(const std::vector<size_t>& indices);
+    void onSegmentDone(size_t index, const std::string& audio_url, std::exception_ptr error);
+    // 按顺序回调已完成的分段，全部完成时调用on_done；需持有mutex_
+    void deliverLocked();
+
+    const std::string id_;
+    const std::chrono::steady_clock::time_point created_at_;
+
+    mutable std::mutex mutex_;
+    std::string pending_text_;          // 尚未切分的文本
+    std::vector<TtsSegment> segments_;
+    size_t completed_;
+    size_t delivered_;
+    bool finished_;
+    bool done_notified_;
+    SegmentCallback on_segment_;
+    JobDoneCallback on_done_;
+};
+
+/**
+ * @brief 语音任务管理：生成任务ID，供轮询接口按ID查询
+ *
+ * 任务在创建tts_job_ttl_sec秒后过期，过期任务在创建新任务时清理。
+ */
+class TtsJobManager {
+public:
+    static TtsJobManager& getInstance();
+
+    std::shared_ptr<TtsJob> createJob(SegmentCallback on_segment = nullptr,
+                                      JobDoneCallback on_done = nullptr);
+
+    /**
+     * @brief 按ID查找任务，不存在或已过期返回nullptr
+     */
+    std::shared_ptr<TtsJob> findJob(const std::string& job_id) const;
+
+private:
+    TtsJobManager();
+    TtsJobManager(const TtsJobManager&) = delete;
+    TtsJobManager& operator=(const TtsJobManager&) = delete;
+
+    void removeExpiredLocked(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<TtsJob>> jobs_;
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>> expiry_order_;
+    std::chrono::seconds ttl_;
+    uint64_t next_id_;
+    uint64_t id_salt_;
+    std::mt19937_64 rng_;
+};
+
+} // namespace tts
+
+#endif // TTS_JOBS_H
@@ -1,10 +1,11 @@
 #include "config.h"
 #include "logger.h"
+#include "json.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
-#include <regex>
+#include <iostream>
 
 namespace utils {
 
@@ -25,83 +26,34 @@ std::string Config::trim(const std::string& str) const {
     return str.substr(first, last - first + 1);
 }
 
-std::string Config::unescapeJsonString(const std::string& str) const {
-    std::string result;
-    result.reserve(str.length());
-    
-    for (size_t i = 0; i < str.length(); ++i) {
-        if (str[i] == '\\' && i + 1 < str.length()) {
-            switch (str[i + 1]) {
-                case '"': result += '"'; ++i; break;
-                case '\\': result += '\\'; ++i; break;
-                case '/': result += '/'; ++i; break;
-                case 'b': result += '\b'; ++i; break;
-                case 'f': result += '\f'; ++i; break;
-                case 'n': result += '\n'; ++i; break;
-                case 'r': result += '\r'; ++i; break;
-                case 't': result += '\t'; ++i; break;
-                default: result += str[i]; break;
-            }
-        } else {
-            result += str[i];
+// 把JSON对象的叶子节点按键名展开到map中（嵌套对象的键与顶层同名时后者覆盖前者），
+// 数字保留原始文本，布尔值转为"true"/"false"，数组和null忽略
+static void flattenObject(const JsonValue& object, std::map<std::string, std::string>& out) {
+    for (size_t i = 0; i < object.size(); ++i) {
+        const JsonMember& member = object.member(i);
+        const JsonValue& value = member.value;
+        std::string key(member.key);
+        switch (value.type()) {
+            case JsonType::String: out[key] = std::string(value.asString()); break;
+            case JsonType::Number: out[key] = std::string(value.numberText()); break;
+            case JsonType::Bool: out[key] = value.asBool() ? "true" : "false"; break;
+            case JsonType::Object: flattenObject(value, out); break;
+            default: break;
         }
     }
-    
-    return result;
 }
 
-void Config::parseSimpleJSON(const std::string& content) {
+bool Config::parseJSON(const std::string& content) {
     config_map_.clear();
-    
-    // 移除所有空白字符（简化处理）
-    std::string cleaned;
-    for (char c : content) {
-        if (!std::isspace(c) || c == ' ') {
-            cleaned += c;
-        }
-    }
-    
-    // 移除外层大括号
-    size_t start = cleaned.find('{');
-    if (start != std::string::npos) {
-        cleaned = cleaned.substr(start + 1);
-    }
-    size_t end = cleaned.rfind('}');
-    if (end != std::string::npos) {
-        cleaned = cleaned.substr(0, end);
-    }
-    
-    // 解析键值对，支持嵌套对象（简化版）
-    // 格式: "key": "value" 或 "key": { "nested": "value" }
-    std::regex pair_regex(R"xxx("([^"]+)"\s*:\s*"([^"]*)")xxx");
-    std::sregex_iterator iter(cleaned.begin(), cleaned.end(), pair_regex);
-    std::sregex_iterator end_iter;
-    
-    for (; iter != end_iter; ++iter) {
-        std::smatch match = *iter;
-        std::string key = match[1].str();
-        std::string value = match[2].str();
-        config_map_[key] = unescapeJsonString(value);
-    }
-    
-    // 也支持数字和布尔值
-    std::regex num_pair_regex(R"xxx("([^"]+)"\s*:\s*([0-9]+))xxx");
-    iter = std::sregex_iterator(cleaned.begin(), cleaned.end(), num_pair_regex);
-    for (; iter != end_iter; ++iter) {
-        std::smatch match = *iter;
-        std::string key = match[1].str();
-        std::string value = match[2].str();
-        config_map_[key] = value;
-    }
-    
-    std::regex bool_pair_regex(R"xxx("([^"]+)"\s*:\s*(true|false))xxx");
-    iter = std::sregex_iterator(cleaned.begin(), cleaned.end(), bool_pair_regex);
-    for (; iter != end_iter; ++iter) {
-        std::smatch match = *iter;
-        std::string key = match[1].str();
-        std::string value = match[2].str();
-        config_map_[key] = value;
+
+    JsonDocument doc;
+    if (!doc.parse(content) || !doc.root().isObject()) {
+        // 注意：这里不能使用LOG_ERROR，logger尚未初始化
+        std::cerr << "配置文件格式错误: " << (doc.error().empty() ? "顶层不是JSON对象" : doc.error()) << std::endl;
+        return false;
     }
+    flattenObject(doc.root(), config_map_);
+    return true;
 }
 
 int Config::loadFromFile(const std::string& filepath) {
@@ -122,7 +74,9 @@ int Config::loadFromFile(const std::string& filepath) {
         return -1;
     }
     
-    parseSimpleJSON(content);
+    if (!parseJSON(content)) {
+        return -1;
+    }
     
     // 如果logger已经初始化，可以记录日志
     // 但这里不记录，因为logger.init()在main中调用，此时config已加载
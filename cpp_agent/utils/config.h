@@ -36,10 +36,9 @@ private:
     std::map<std::string, std::string> config_map_;
     std::string config_filepath_;
     
-    // 简单的JSON解析（仅支持简单的key-value对）
-    void parseSimpleJSON(const std::string& content);
+    // 解析JSON配置，嵌套对象的叶子节点按键名展开；格式错误时返回false
+    bool parseJSON(const std::string& content);
     std::string trim(const std::string& str) const;
-    std::string unescapeJsonString(const std::string& str) const;
 };
 
 } // namespace utils
@@ -0,0 +1,530 @@
+#include "http_client.h"
+#include "config.h"
+#include "logger.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace utils {
+
+static constexpr int max_epoll_events = 64;
+// 每完成多少次传输输出一次连接复用统计
+static constexpr uint64_t stats_log_interval = 100;
+
+struct AsyncHttpClient::Transfer {
+    CURL* easy = nullptr;
+    struct curl_slist* headers = nullptr;
+    HttpClientRequest request;
+    HttpClientResponse response;
+    HttpClientCallback callback;
+    LogContextPtr log_context;     // 发起请求时的日志上下文，回调执行时恢复
+    std::chrono::steady_clock::time_point queued_at;  // 提交时间，用于trace中的排队阶段
+};
+
+// 把一次传输按curl自身的阶段耗时拆成trace span（各阶段时间均为从传输开始起的累计值）
+static void traceTransfer(const HttpClientRequest& request, const HttpClientResponse& response,
+                          std::chrono::steady_clock::time_point queued_at) {
+    const HttpClientTiming& timing = response.timing;
+    auto end = std::chrono::steady_clock::now();
+    auto start = end - std::chrono::microseconds(timing.total_us);
+    auto at = [start](long long us) { return start + std::chrono::microseconds(us); };
+
+    Tracer& tracer = Tracer::getInstance();
+    if (queued_at < start) {
+        tracer.record("queue", "http_client", queued_at, start);
+    }
+
+    std::string args;
+    Tracer::appendArg(args, "url", std::string_view(request.url).substr(0, request.url.find('?')));
+    Tracer::appendArg(args, "status", static_cast<long long>(response.status));
+    Tracer::appendArg(args, "curl_code", static_cast<long long>(response.curl_code));
+    Tracer::appendArg(args, "reused_connection", static_cast<long long>(timing.reused_connection));
+    tracer.record("http_client", "http_client", start, end, std::move(args));
+
+    // 复用连接时DNS/建连/TLS均为0，不单独记录
+    if (timing.namelookup_us > 0) {
+        tracer.record("dns", "http_client", start, at(timing.namelookup_us));
+    }
+    if (timing.connect_us > timing.namelookup_us) {
+        tracer.record("connect", "http_client", at(timing.namelookup_us), at(timing.connect_us));
+    }
+    if (timing.appconnect_us > timing.connect_us) {
+        tracer.record("tls", "http_client", at(timing.connect_us), at(timing.appconnect_us));
+    }
+    long long sent_us = std::max(timing.connect_us, timing.appconnect_us);
+    if (timing.starttransfer_us > 0) {
+        tracer.record("ttfb", "http_client", at(sent_us), at(timing.starttransfer_us));
+        tracer.record("body", "http_client", at(timing.starttransfer_us), end);
+    }
+}
+
+AsyncHttpClient::AsyncHttpClient()
+    : multi_(nullptr), share_(nullptr), pool_capacity_(0), http2_supported_(false),
+      handles_created_(0), handles_reused_(0), connections_new_(0),
+      connections_reused_(0), connect_time_us_(0),
+      epoll_fd_(-1), wake_fd_(-1), timer_active_(false),
+      initialized_(false), should_stop_(false), in_flight_(0) {
+}
+
+AsyncHttpClient::~AsyncHttpClient() {
+    close();
+}
+
+AsyncHttpClient& AsyncHttpClient::getInstance() {
+    static AsyncHttpClient instance;
+    return instance;
+}
+
+int AsyncHttpClient::init() {
+    if (initialized_) {
+        return 0;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    multi_ = curl_multi_init();
+    if (epoll_fd_ < 0 || wake_fd_ < 0 || !multi_) {
+        LOG_ERROR("HttpClient", "初始化失败: " + std::string(strerror(errno)));
+        if (epoll_fd_ >= 0) ::close(epoll_fd_);
+        if (wake_fd_ >= 0) ::close(wake_fd_);
+        if (multi_) curl_multi_cleanup(multi_);
+        epoll_fd_ = wake_fd_ = -1;
+        multi_ = nullptr;
+        return -1;
+    }
+
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETFUNCTION, socketCallback);
+    curl_multi_setopt(multi_, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERFUNCTION, timerCallback);
+    curl_multi_setopt(multi_, CURLMOPT_TIMERDATA, this);
+
+    // 共享DNS、TLS会话和连接缓存
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, shareLock);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, shareUnlock);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    curl_version_info_data* version = curl_version_info(CURLVERSION_NOW);
+    http2_supported_ = version && (version->features & CURL_VERSION_HTTP2);
+    if (http2_supported_) {
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+
+    int pool_size = Config::getInstance().getInt("http_client_pool_size", 16);
+    pool_capacity_ = pool_size > 0 ? static_cast<size_t>(pool_size) : 0;
+
+    int callback_threads = Config::getInstance().getInt("http_client_callback_threads", 4);
+    callback_pool_.reset(new ThreadPool(callback_threads > 0 ? callback_threads : 1, "HttpClientCallback"));
+
+    should_stop_ = false;
+    loop_thread_ = std::thread(&AsyncHttpClient::eventLoop, this);
+
+    initialized_ = true;
+    LOG_INFO("HttpClient", "异步HTTP客户端初始化完成 (句柄池: " + std::to_string(pool_capacity_) +
+             ", HTTP/2: " + std::string(http2_supported_ ? "启用" : "不支持") + ")");
+    return 0;
+}
+
+void AsyncHttpClient::close() {
+    if (!initialized_) {
+        return;
+    }
+
+    should_stop_ = true;
+    wakeup();
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+
+    // 事件线程已退出，剩余请求在这里以错误结束
+    std::deque<Transfer*> pending;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending.swap(pending_);
+    }
+    for (Transfer* transfer : pending) {
+        finishTransfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    std::unordered_set<Transfer*> active;
+    active.swap(active_);
+    for (Transfer* transfer : active) {
+        curl_multi_remove_handle(multi_, transfer->easy);
+        finishTransfer(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+
+    callback_pool_->stop();
+
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        for (CURL* easy : idle_handles_) {
+            curl_easy_cleanup(easy);
+        }
+        idle_handles_.clear();
+    }
+    curl_multi_cleanup(multi_);
+    if (share_) {
+        curl_share_cleanup(share_);
+        share_ = nullptr;
+    }
+    ::close(epoll_fd_);
+    ::close(wake_fd_);
+    multi_ = nullptr;
+    epoll_fd_ = wake_fd_ = -1;
+    initialized_ = false;
+}
+
+void AsyncHttpClient::send(HttpClientRequest request, HttpClientCallback callback) {
+    Transfer* transfer = new Transfer();
+    transfer->request = std::move(request);
+    transfer->callback = std::move(callback);
+    transfer->log_context = LogContext::current();
+    transfer->queued_at = std::chrono::steady_clock::now();
+
+    {
+        // 停止检查与入队在同一把锁内完成：close()置should_stop_后在此锁下取走pending_，
+        // 之后到达的请求一定能看到停止标志，不会在清空后再入队
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (initialized_ && !should_stop_) {
+            in_flight_++;
+            pending_.push_back(transfer);
+            // 锁内唤醒，保证close()关闭wake_fd_之前完成
+            wakeup();
+            return;
+        }
+    }
+
+    transfer->response.curl_code = CURLE_FAILED_INIT;
+    transfer->response.error = "HTTP客户端未初始化";
+    transfer->callback(transfer->response);
+    delete transfer;
+}
+
+std::future<HttpClientResponse> AsyncHttpClient::send(HttpClientRequest request) {
+    auto promise = std::make_shared<std::promise<HttpClientResponse>>();
+    std::future<HttpClientResponse> future = promise->get_future();
+    send(std::move(request), [promise](HttpClientResponse& response) {
+        promise->set_value(std::move(response));
+    });
+    return future;
+}
+
+HttpClientStats AsyncHttpClient::getStats() const {
+    HttpClientStats stats;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        stats.pool_idle = idle_handles_.size();
+    }
+    stats.pool_capacity = pool_capacity_;
+    stats.handles_created = handles_created_;
+    stats.handles_reused = handles_reused_;
+    stats.connections_new = connections_new_;
+    stats.connections_reused = connections_reused_;
+    stats.connect_time_us = connect_time_us_;
+    stats.http2 = http2_supported_;
+    return stats;
+}
+
+void AsyncHttpClient::shareLock(CURL* /* handle */, curl_lock_data data,
+                                curl_lock_access /* access */, void* userp) {
+    AsyncHttpClient* self = static_cast<AsyncHttpClient*>(userp);
+    self->share_mutexes_[data].lock();
+}
+
+void AsyncHttpClient::shareUnlock(CURL* /* handle */, curl_lock_data data, void* userp) {
+    AsyncHttpClient* self = static_cast<AsyncHttpClient*>(userp);
+    self->share_mutexes_[data].unlock();
+}
+
+CURL* AsyncHttpClient::acquireHandle() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!idle_handles_.empty()) {
+            CURL* easy = idle_handles_.back();
+            idle_handles_.pop_back();
+            handles_reused_++;
+            return easy;
+        }
+    }
+    CURL* easy = curl_easy_init();
+    if (easy) {
+        handles_created_++;
+    }
+    return easy;
+}
+
+void AsyncHttpClient::releaseHandle(CURL* easy) {
+    // reset清除本次请求的选项，但保留句柄内部的缓冲区等资源
+    curl_easy_reset(easy);
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (idle_handles_.size() < pool_capacity_) {
+            idle_handles_.push_back(easy);
+            return;
+        }
+    }
+    curl_easy_cleanup(easy);
+}
+
+void AsyncHttpClient::recordTiming(CURL* easy, CURLcode code, HttpClientTiming& timing) {
+    curl_off_t value = 0;
+    if (curl_easy_getinfo(easy, CURLINFO_NAMELOOKUP_TIME_T, &value) == CURLE_OK) timing.namelookup_us = value;
+    if (curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME_T, &value) == CURLE_OK) timing.connect_us = value;
+    if (curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME_T, &value) == CURLE_OK) timing.appconnect_us = value;
+    if (curl_easy_getinfo(easy, CURLINFO_STARTTRANSFER_TIME_T, &value) == CURLE_OK) timing.starttransfer_us = value;
+    if (curl_easy_getinfo(easy, CURLINFO_TOTAL_TIME_T, &value) == CURLE_OK) timing.total_us = value;
+
+    // NUM_CONNECTS为0表示本次传输复用了已有连接
+    long num_connects = 0;
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &num_connects);
+    timing.reused_connection = code == CURLE_OK && num_connects == 0;
+
+    // 失败的传输（DNS失败、超时、中止等）可能根本没有建连，NUM_CONNECTS同样为0，
+    // 不计入复用率的分子和分母
+    if (code != CURLE_OK) {
+        return;
+    }
+
+    uint64_t completed;
+    if (timing.reused_connection) {
+        completed = ++connections_reused_ + connections_new_;
+    } else {
+        completed = ++connections_new_ + connections_reused_;
+    }
+    long long connect_us = timing.appconnect_us > 0 ? timing.appconnect_us : timing.connect_us;
+    connect_time_us_ += static_cast<uint64_t>(connect_us);
+
+    LOG_DEBUG("HttpClient", std::string("传输完成 (复用连接: ") + (timing.reused_connection ? "是" : "否") +
+              ", 建连耗时: " + std::to_string(connect_us / 1000) + "ms" +
+              ", 首字节: " + std::to_string(timing.starttransfer_us / 1000) + "ms)");
+
+    if (completed % stats_log_interval == 0) {
+        HttpClientStats stats = getStats();
+        LOG_INFO("HttpClient", "连接复用统计: 句柄命中率 " +
+                 std::to_string(static_cast<int>(stats.handleHitRate() * 100)) + "%, 连接复用率 " +
+                 std::to_string(static_cast<int>(stats.connectionReuseRate() * 100)) + "%, 空闲句柄 " +
+                 std::to_string(stats.pool_idle) + "/" + std::to_string(stats.pool_capacity));
+    }
+}
+
+void AsyncHttpClient::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+int AsyncHttpClient::socketCallback(CURL* /* easy */, curl_socket_t sock, int what,
+                                    void* userp, void* socketp) {
+    AsyncHttpClient* self = static_cast<AsyncHttpClient*>(userp);
+
+    if (what == CURL_POLL_REMOVE) {
+        // socket可能已被curl关闭，忽略错误
+        epoll_ctl(self->epoll_fd_, EPOLL_CTL_DEL, sock, nullptr);
+        curl_multi_assign(self->multi_, sock, nullptr);
+        return 0;
+    }
+
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    if (what & CURL_POLL_IN) ev.events |= EPOLLIN;
+    if (what & CURL_POLL_OUT) ev.events |= EPOLLOUT;
+    ev.data.fd = sock;
+
+    if (socketp) {
+        epoll_ctl(self->epoll_fd_, EPOLL_CTL_MOD, sock, &ev);
+    } else {
+        epoll_ctl(self->epoll_fd_, EPOLL_CTL_ADD, sock, &ev);
+        // 非空标记表示该socket已加入epoll
+        curl_multi_assign(self->multi_, sock, self);
+    }
+    return 0;
+}
+
+int AsyncHttpClient::timerCallback(CURLM* /* multi */, long timeout_ms, void* userp) {
+    AsyncHttpClient* self = static_cast<AsyncHttpClient*>(userp);
+    if (timeout_ms < 0) {
+        self->timer_active_ = false;
+    } else {
+        self->timer_active_ = true;
+        self->timer_deadline_ = std::chrono::steady_clock::now() +
+                                std::chrono::milliseconds(timeout_ms);
+    }
+    return 0;
+}
+
+size_t AsyncHttpClient::writeCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    size_t realsize = size * nmemb;
+    Transfer* transfer = static_cast<Transfer*>(userp);
+    if (transfer->request.on_data) {
+        // 错误响应（非2xx）仍然写入body，便于调用方读取错误信息
+        long status = 0;
+        curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status);
+        if (status >= 200 && status < 300) {
+            ScopedLogContext log_scope(transfer->log_context);
+            return transfer->request.on_data(static_cast<const char*>(contents), realsize) ? realsize : 0;
+        }
+    }
+    transfer->response.body.append(static_cast<char*>(contents), realsize);
+    return realsize;
+}
+
+void AsyncHttpClient::eventLoop() {
+    Tracer::setThreadName("http_client");
+    struct epoll_event events[max_epoll_events];
+    int running = 0;
+
+    while (!should_stop_) {
+        int wait_ms = -1;
+        if (timer_active_) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                timer_deadline_ - std::chrono::steady_clock::now()).count();
+            wait_ms = remaining > 0 ? static_cast<int>(remaining) : 0;
+        }
+
+        int n = epoll_wait(epoll_fd_, events, max_epoll_events, wait_ms);
+        if (n < 0 && errno != EINTR) {
+            LOG_ERROR("HttpClient", "epoll_wait失败: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == wake_fd_) {
+                uint64_t value;
+                while (read(wake_fd_, &value, sizeof(value)) > 0) {
+                }
+                startPendingTransfers();
+                continue;
+            }
+
+            int flags = 0;
+            if (events[i].events & EPOLLIN) flags |= CURL_CSELECT_IN;
+            if (events[i].events & EPOLLOUT) flags |= CURL_CSELECT_OUT;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) flags |= CURL_CSELECT_ERR;
+            curl_multi_socket_action(multi_, events[i].data.fd, flags, &running);
+        }
+
+        if (timer_active_ && std::chrono::steady_clock::now() >= timer_deadline_) {
+            timer_active_ = false;
+            curl_multi_socket_action(multi_, CURL_SOCKET_TIMEOUT, 0, &running);
+        }
+
+        checkCompletedTransfers();
+    }
+}
+
+void AsyncHttpClient::startPendingTransfers() {
+    std::deque<Transfer*> pending;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending.swap(pending_);
+    }
+
+    for (Transfer* transfer : pending) {
+        CURL* easy = acquireHandle();
+        if (!easy) {
+            finishTransfer(transfer, CURLE_FAILED_INIT);
+            continue;
+        }
+        transfer->easy = easy;
+
+        // 设置请求头（必须在设置POSTFIELDS之前）
+        for (const auto& header : transfer->request.headers) {
+            transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+        }
+
+        const HttpClientRequest& request = transfer->request;
+        curl_easy_setopt(easy, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer->headers);
+        if (!request.body.empty()) {
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request.body.c_str());
+            curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.body.length()));
+        }
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer);
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (share_) {
+            curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+        }
+        if (http2_supported_) {
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        }
+        if (request.timeout_ms > 0) {
+            curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, request.timeout_ms);
+        }
+
+        CURLMcode mc = curl_multi_add_handle(multi_, easy);
+        if (mc != CURLM_OK) {
+            LOG_ERROR("HttpClient", "添加请求失败: " + std::string(curl_multi_strerror(mc)));
+            finishTransfer(transfer, CURLE_FAILED_INIT);
+            continue;
+        }
+        active_.insert(transfer);
+    }
+}
+
+void AsyncHttpClient::checkCompletedTransfers() {
+    int msgs_left = 0;
+    CURLMsg* msg = nullptr;
+    while ((msg = curl_multi_info_read(multi_, &msgs_left)) != nullptr) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        CURL* easy = msg->easy_handle;
+        CURLcode code = msg->data.result;
+        Transfer* transfer = nullptr;
+        curl_easy_getinfo(easy, CURLINFO_PRIVATE, &transfer);
+        curl_multi_remove_handle(multi_, easy);
+        if (transfer) {
+            active_.erase(transfer);
+            finishTransfer(transfer, code);
+        }
+    }
+}
+
+void AsyncHttpClient::finishTransfer(Transfer* transfer, CURLcode code) {
+    transfer->response.curl_code = code;
+    if (code != CURLE_OK) {
+        transfer->response.error = curl_easy_strerror(code);
+    }
+    if (transfer->easy) {
+        curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &transfer->response.status);
+        recordTiming(transfer->easy, code, transfer->response.timing);
+        if (Tracer::getInstance().enabled()) {
+            ScopedLogContext log_scope(transfer->log_context);
+            traceTransfer(transfer->request, transfer->response, transfer->queued_at);
+        }
+        releaseHandle(transfer->easy);
+        transfer->easy = nullptr;
+    }
+    curl_slist_free_all(transfer->headers);
+    transfer->headers = nullptr;
+    in_flight_--;
+
+    std::shared_ptr<Transfer> owned(transfer);
+    auto run = [owned]() {
+        ScopedLogContext log_scope(owned->log_context);
+        owned->callback(owned->response);
+    };
+    if (!callback_pool_->submit(run)) {
+        run();
+    }
+}
+
+} // namespace utils
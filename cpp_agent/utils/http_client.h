@@ -0,0 +1,184 @@
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <chrono>
+#include <functional>
+#include <curl/curl.h>
+#include "thread_pool.h"
+
+namespace utils {
+
+/**
+ * @brief 上游HTTP请求
+ */
+struct HttpClientRequest {
+    std::string url;
+    std::vector<std::string> headers;  // 形如 "Content-Type: application/json"
+    std::string body;                  // 非空时以POST发送
+    long timeout_ms = 0;               // 0表示不限制
+    // 流式接收：设置后2xx响应体不再写入response.body，而是每收到一块数据就在
+    // 事件线程中调用一次（需快速返回）；返回false中止传输（curl_code为CURLE_WRITE_ERROR）
+    std::function<bool(const char* data, size_t len)> on_data;
+};
+
+/**
+ * @brief 单次传输各阶段耗时（微秒，均从传输开始计时，取自curl_easy_getinfo）
+ */
+struct HttpClientTiming {
+    long long namelookup_us = 0;     // DNS解析完成
+    long long connect_us = 0;        // TCP连接建立
+    long long appconnect_us = 0;     // TLS握手完成
+    long long starttransfer_us = 0;  // 收到首字节
+    long long total_us = 0;
+    bool reused_connection = false;  // 是否复用了已有连接
+};
+
+/**
+ * @brief 上游HTTP响应
+ */
+struct HttpClientResponse {
+    int curl_code = 0;      // CURLcode，0表示传输成功
+    long status = 0;        // HTTP状态码
+    std::string body;
+    std::string error;      // 传输失败时的错误描述
+    HttpClientTiming timing;
+
+    bool transferOk() const { return curl_code == 0; }
+};
+
+/**
+ * @brief 连接复用统计
+ */
+struct HttpClientStats {
+    size_t pool_idle = 0;            // 池中空闲的easy句柄数
+    size_t pool_capacity = 0;        // 池容量（http_client_pool_size）
+    uint64_t handles_created = 0;    // 新建的easy句柄数
+    uint64_t handles_reused = 0;     // 从池中复用的easy句柄数
+    uint64_t connections_new = 0;    // 新建连接的传输数（仅统计成功的传输）
+    uint64_t connections_reused = 0; // 复用连接的传输数（仅统计成功的传输）
+    uint64_t connect_time_us = 0;    // 所有传输的建连（含TLS）耗时总和
+    bool http2 = false;              // libcurl是否支持HTTP/2
+
+    double handleHitRate() const {
+        uint64_t total = handles_created + handles_reused;
+        return total ? static_cast<double>(handles_reused) / total : 0.0;
+    }
+    double connectionReuseRate() const {
+        uint64_t total = connections_new + connections_reused;
+        return total ? static_cast<double>(connections_reused) / total : 0.0;
+    }
+};
+
+using HttpClientCallback = std::function<void(HttpClientResponse& response)>;
+
+/**
+ * @brief 基于curl_multi的异步HTTP客户端
+ *
+ * 内部一个事件线程以socket-action模式驱动curl_multi（epoll等待socket事件和
+ * curl定时器），所有上游请求都在这一个线程中并发进行；请求完成后，回调被投递到
+ * 回调线程池（http_client_callback_threads）执行，不会阻塞事件线程。
+ *
+ * 连接复用：easy句柄用完后reset放回池中（http_client_pool_size）；所有句柄通过
+ * CURLSH共享DNS缓存、TLS会话缓存和连接缓存，libcurl支持时启用HTTP/2多路复用，
+ * 预热后对同一上游的请求不再重复DNS解析、TCP握手和TLS握手。
+ */
+class AsyncHttpClient {
+public:
+    static AsyncHttpClient& getInstance();
+
+    /**
+     * @brief 启动事件线程（需在curl_global_init之后调用）
+     * @return 0表示成功
+     */
+    int init();
+
+    /**
+     * @brief 停止事件线程，未完成的请求以错误结束
+     */
+    void close();
+
+    /**
+     * @brief 异步发送请求，完成后在回调线程池中调用callback
+     */
+    void send(HttpClientRequest request, HttpClientCallback callback);
+
+    /**
+     * @brief 异步发送请求，返回future
+     */
+    std::future<HttpClientResponse> send(HttpClientRequest request);
+
+    size_t inFlight() const { return in_flight_; }
+
+    /**
+     * @brief 获取连接复用统计（线程安全）
+     */
+    HttpClientStats getStats() const;
+
+private:
+    AsyncHttpClient();
+    ~AsyncHttpClient();
+    AsyncHttpClient(const AsyncHttpClient&) = delete;
+    AsyncHttpClient& operator=(const AsyncHttpClient&) = delete;
+
+    struct Transfer;
+
+    static int socketCallback(CURL* easy, curl_socket_t sock, int what, void* userp, void* socketp);
+    static int timerCallback(CURLM* multi, long timeout_ms, void* userp);
+    static size_t writeCallback(void* contents, size_t size, size_t nmemb, void* userp);
+    static void shareLock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userp);
+    static void shareUnlock(CURL* handle, curl_lock_data data, void* userp);
+
+    CURL* acquireHandle();
+    void releaseHandle(CURL* easy);
+    void recordTiming(CURL* easy, CURLcode code, HttpClientTiming& timing);
+
+    void eventLoop();
+    void startPendingTransfers();
+    void checkCompletedTransfers();
+    void finishTransfer(Transfer* transfer, CURLcode code);
+    void wakeup();
+
+    CURLM* multi_;
+    CURLSH* share_;
+    std::mutex share_mutexes_[CURL_LOCK_DATA_LAST];
+
+    // easy句柄池
+    mutable std::mutex pool_mutex_;
+    std::vector<CURL*> idle_handles_;
+    size_t pool_capacity_;
+    bool http2_supported_;
+
+    std::atomic<uint64_t> handles_created_;
+    std::atomic<uint64_t> handles_reused_;
+    std::atomic<uint64_t> connections_new_;
+    std::atomic<uint64_t> connections_reused_;
+    std::atomic<uint64_t> connect_time_us_;
+    int epoll_fd_;
+    int wake_fd_;
+    std::thread loop_thread_;
+    std::unique_ptr<ThreadPool> callback_pool_;
+
+    std::mutex pending_mutex_;
+    std::deque<Transfer*> pending_;
+    std::unordered_set<Transfer*> active_;  // 已加入curl_multi的请求，仅事件线程访问
+
+    bool timer_active_;
+    std::chrono::steady_clock::time_point timer_deadline_;
+
+    std::atomic<bool> initialized_;
+    std::atomic<bool> should_stop_;
+    std::atomic<size_t> in_flight_;
+};
+
+} // namespace utils
+
+#endif // HTTP_CLIENT_H
@@ -1,6 +1,7 @@
 #include "http_utils.h"
 #include "json_parser.h"
-#include <sstream>
+#include "json.h"
+#include "json_writer.h"
 
 namespace utils {
 
@@ -12,39 +13,43 @@ static const char* reasonPhrase(int code) {
         case 200: return "OK";
         case 400: return "Bad Request";
         case 404: return "Not Found";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
         case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
         default: return "Error";
     }
 }
-std::string HttpUtils::createErrorResponse(int code, const std::string& message) {
-    std::ostringstream json;
-    json << "{\"code\":" << code
-         << ",\"msg\":\"" << escapeJsonForResponse(message)
-         << "\",\"data\":null}";
-    std::ostringstream resp;
-    resp << "HTTP/1.1 " << code << " " << reasonPhrase(code) << "\r\n"
-         << "Content-Type: application/json; charset=utf-8\r\n"
-         << "Access-Control-Allow-Origin: *\r\n"
-         << "Access-Control-Allow-Methods: GET, POST\r\n"
-         << "Access-Control-Allow-Headers: Content-Type\r\n"
-         << "Content-Length: " << json.str().length() << "\r\n"
-         << "\r\n"
-         << json.str();
+// 拼接JSON响应：状态行 + 固定头部 + 响应体，一次分配
+static std::string buildJsonResponse(int code, const std::string& json_body) {
+    static const char headers[] =
+        "Content-Type: application/json; charset=utf-8\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "Access-Control-Allow-Methods: GET, POST\r\n"
+        "Access-Control-Allow-Headers: Content-Type\r\n"
+        "Content-Length: ";
+    std::string status = std::to_string(code);
+    std::string length = std::to_string(json_body.length());
+    const char* reason = reasonPhrase(code);
 
-    return resp.str();
+    std::string resp;
+    resp.reserve(64 + sizeof(headers) + length.size() + json_body.size());
+    resp.append("HTTP/1.1 ").append(status).append(" ").append(reason).append("\r\n");
+    resp.append(headers, sizeof(headers) - 1);
+    resp.append(length).append("\r\n\r\n");
+    resp.append(json_body);
+    return resp;
+}
+
+std::string HttpUtils::createErrorResponse(int code, const std::string& message) {
+    JsonWriter json;
+    json.beginObject().key("code").value(code).key("msg").value(message).key("data").null().endObject();
+    return buildJsonResponse(code, json.str());
 }
 
 std::string HttpUtils::createJsonResponse(const std::string& json_body) {
-    std::ostringstream resp;
-    resp << "HTTP/1.1 200 OK\r\n"
-         << "Content-Type: application/json; charset=utf-8\r\n"
-         << "Access-Control-Allow-Origin: *\r\n"
-         << "Access-Control-Allow-Methods: GET, POST\r\n"
-         << "Access-Control-Allow-Headers: Content-Type\r\n"
-         << "Content-Length: " << json_body.length() << "\r\n"
-         << "\r\n"
-         << json_body;
-    return resp.str();
+    return buildJsonResponse(200, json_body);
 }
 
 std::string HttpUtils::extractJsonBody(const std::string& request) {
@@ -56,7 +61,19 @@ std::string HttpUtils::extractJsonBody(const std::string& request) {
 }
 
 std::string HttpUtils::extractJsonField(const std::string& json, const std::string& key) {
-    return JsonParser::extractString(json, key, "");
+    JsonDocument doc;
+    if (!doc.parse(json)) {
+        return "";
+    }
+    return doc.getString(key);
+}
+
+void HttpUtils::insertHeader(std::string& response, const std::string& header_line) {
+    size_t status_end = response.find("\r\n");
+    if (status_end == std::string::npos) {
+        return;
+    }
+    response.insert(status_end + 2, header_line + "\r\n");
 }
 
 std::string HttpUtils::getContentType(const std::string& filepath) {
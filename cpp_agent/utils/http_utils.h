@@ -47,6 +47,13 @@ public:
      */
     static std::string extractJsonField(const std::string& json, const std::string& key);
     
+    /**
+     * @brief 在已构造好的HTTP响应中插入一个header（紧跟状态行之后）
+     * @param response HTTP响应字符串
+     * @param header_line header内容，不含结尾的\r\n，可包含多行
+     */
+    static void insertHeader(std::string& response, const std::string& header_line);
+    
     /**
      * @brief 获取文件的Content-Type
      * @param filepath 文件路径
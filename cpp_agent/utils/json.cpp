@@ -0,0 +1,706 @@
+#include "json.h"
+#include "json_scan.h"
+#include "metrics.h"
+#include <charconv>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <new>
+#include <chrono>
+
+namespace utils {
+
+// 嵌套层数上限，防止恶意输入耗尽栈空间
+static constexpr int max_depth = 256;
+// arena首个块的大小，后续块逐次翻倍
+static constexpr size_t arena_block_size = 4096;
+static constexpr size_t arena_max_block_size = 64 * 1024;
+
+static const JsonValue null_value;
+static const JsonMember null_member;
+
+static bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// 十六进制字符的值，非十六进制字符为-1
+static constexpr std::array<int8_t, 256> makeHexTable() {
+    std::array<int8_t, 256> table{};
+    for (int c = 0; c < 256; ++c) {
+        table[c] = -1;
+    }
+    for (int c = '0'; c <= '9'; ++c) table[c] = static_cast<int8_t>(c - '0');
+    for (int c = 'a'; c <= 'f'; ++c) table[c] = static_cast<int8_t>(c - 'a' + 10);
+    for (int c = 'A'; c <= 'F'; ++c) table[c] = static_cast<int8_t>(c - 'A' + 10);
+    return table;
+}
+
+static constexpr std::array<int8_t, 256> hex_table = makeHexTable();
+
+// 解析4位十六进制数，非法时返回-1
+static int32_t parseHex4(const char* p) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    int32_t a = hex_table[u[0]];
+    int32_t b = hex_table[u[1]];
+    int32_t c = hex_table[u[2]];
+    int32_t d = hex_table[u[3]];
+    if ((a | b | c | d) < 0) {
+        return -1;
+    }
+    return (a << 12) | (b << 8) | (c << 4) | d;
+}
+
+static char* writeUtf8(char* w, uint32_t cp) {
+    if (cp < 0x80) {
+        *w++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *w++ = static_cast<char>(0xC0 | (cp >> 6));
+        *w++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *w++ = static_cast<char>(0xE0 | (cp >> 12));
+        *w++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *w++ = static_cast<char>(0xF0 | (cp >> 18));
+        *w++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *w++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return w;
+}
+
+/**
+ * @brief 解码一个转义序列，p指向反斜杠；成功时p移到序列之后
+ *
+ * \uXXXX按UTF-16解码，高低代理对合并为一个码点，孤立的代理替换为U+FFFD。
+ * 写出的字节数不超过消耗的输入字节数。
+ */
+static bool decodeEscape(const char*& p, const char* end, char*& w) {
+    if (end - p < 2) {
+        return false;
+    }
+    switch (p[1]) {
+        case '"': *w++ = '"'; break;
+        case '\\': *w++ = '\\'; break;
+        case '/': *w++ = '/'; break;
+        case 'b': *w++ = '\b'; break;
+        case 'f': *w++ = '\f'; break;
+        case 'n': *w++ = '\n'; break;
+        case 'r': *w++ = '\r'; break;
+        case 't': *w++ = '\t'; break;
+        case 'u': {
+            if (end - p < 6) {
+                return false;
+            }
+            int32_t cp = parseHex4(p + 2);
+            if (cp < 0) {
+                return false;
+            }
+            p += 6;
+            if (cp >= 0xD800 && cp <= 0xDBFF) {
+                int32_t low = (end - p >= 6 && p[0] == '\\' && p[1] == 'u') ? parseHex4(p + 2) : -1;
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                } else {
+                    cp = 0xFFFD;
+                }
+            } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                cp = 0xFFFD;
+            }
+            w = writeUtf8(w, static_cast<uint32_t>(cp));
+            return true;
+        }
+        default:
+            return false;
+    }
+    p += 2;
+    return true;
+}
+
+/**
+ * @brief 解码JSON字符串内容[p, end)并追加到out
+ *
+ * 先按输入长度预留空间，用写指针直接写入：转义序列解码后不会变长，
+ * 只有非法UTF-8字节替换为3字节的U+FFFD时才需要扩容。
+ * strict为true时遇到无效转义返回false；否则保留反斜杠原样输出，最后返回false。
+ */
+static bool decodeJsonString(const char* p, const char* end, std::string& out, bool strict) {
+    static const char replacement[] = "\xEF\xBF\xBD";
+    bool ok = true;
+    size_t base = out.size();
+    out.resize(base + (end - p));
+    char* w = &out[base];
+    char* limit = &out[0] + out.size();
+
+    while (p < end) {
+        const char* slash = static_cast<const char*>(std::memchr(p, '\\', end - p));
+        const char* stop = slash ? slash : end;
+        while (p < stop) {
+            size_t valid = validUtf8Prefix(p, stop - p);
+            std::memcpy(w, p, valid);
+            w += valid;
+            p += valid;
+            if (p == stop) {
+                break;
+            }
+            // 非法字节：输出多占2字节，保证剩余输入仍有足够空间
+            if (static_cast<size_t>(limit - w) < static_cast<size_t>(end - p) + 2) {
+                size_t used = w - &out[0];
+                out.resize(out.size() + (end - p) + 16);
+                w = &out[0] + used;
+                limit = &out[0] + out.size();
+            }
+            std::memcpy(w, replacement, 3);
+            w += 3;
+            ++p;
+        }
+        // 连续的转义序列（如整段\uXXXX编码的中文）直接逐个解码
+        while (p < end && *p == '\\') {
+            if (!decodeEscape(p, end, w)) {
+                ok = false;
+                if (strict) {
+                    out.resize(w - &out[0]);
+                    return false;
+                }
+                *w++ = '\\';
+                ++p;
+            }
+        }
+    }
+    out.resize(w - &out[0]);
+    return ok;
+}
+
+/**
+ * @brief 递归下降解析器，单遍扫描输入
+ */
+class JsonParserImpl {
+public:
+    JsonParserImpl(std::string_view input, JsonHandler& handler)
+        : begin_(input.data()), p_(input.data()), end_(input.data() + input.size()),
+          handler_(handler), depth_(0) {}
+
+    bool run(std::string* error) {
+        skipWhitespace();
+        bool ok = parseValue();
+        if (ok) {
+            skipWhitespace();
+            if (p_ != end_) {
+                ok = fail("文档结束后存在多余内容");
+            }
+        }
+        if (!ok && error) {
+            *error = "位置 " + std::to_string(p_ - begin_) + ": " + error_;
+        }
+        return ok;
+    }
+
+private:
+    bool fail(const char* message) {
+        if (error_.empty()) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (p_ < end_ && isWhitespace(*p_)) {
+            ++p_;
+        }
+    }
+
+    bool consumeLiteral(const char* literal, size_t len) {
+        if (static_cast<size_t>(end_ - p_) < len || std::memcmp(p_, literal, len) != 0) {
+            return fail("无效的字面量");
+        }
+        p_ += len;
+        return true;
+    }
+
+    bool parseValue() {
+        if (p_ == end_) {
+            return fail("意外的输入结束");
+        }
+        switch (*p_) {
+            case '{': return parseObject();
+            case '[': return parseArray();
+            case '"': {
+                std::string_view value;
+                if (!parseString(value)) return false;
+                return handler_.onString(value) || fail("解析被中止");
+            }
+            case 't':
+                if (!consumeLiteral("true", 4)) return false;
+                return handler_.onBool(true) || fail("解析被中止");
+            case 'f':
+                if (!consumeLiteral("false", 5)) return false;
+                return handler_.onBool(false) || fail("解析被中止");
+            case 'n':
+                if (!consumeLiteral("null", 4)) return false;
+                return handler_.onNull() || fail("解析被中止");
+            default:
+                if (*p_ == '-' || isDigit(*p_)) {
+                    return parseNumber();
+                }
+                return fail("意外的字符");
+        }
+    }
+
+    bool parseObject() {
+        if (++depth_ > max_depth) {
+            return fail("嵌套层数过深");
+        }
+        ++p_; // '{'
+        if (!handler_.onStartObject()) return fail("解析被中止");
+        size_t count = 0;
+        skipWhitespace();
+        if (p_ < end_ && *p_ == '}') {
+            ++p_;
+        } else {
+            while (true) {
+                if (p_ == end_ || *p_ != '"') {
+                    return fail("需要字符串类型的键");
+                }
+                std::string_view key;
+                if (!parseString(key)) return false;
+                if (!handler_.onKey(key)) return fail("解析被中止");
+                skipWhitespace();
+                if (p_ == end_ || *p_ != ':') {
+                    return fail("键后缺少':'");
+                }
+                ++p_;
+                skipWhitespace();
+                if (!parseValue()) return false;
+                ++count;
+                skipWhitespace();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    skipWhitespace();
+                    continue;
+                }
+                if (p_ < end_ && *p_ == '}') {
+                    ++p_;
+                    break;
+                }
+                return fail("对象中缺少','或'}'");
+            }
+        }
+        --depth_;
+        return handler_.onEndObject(count) || fail("解析被中止");
+    }
+
+    bool parseArray() {
+        if (++depth_ > max_depth) {
+            return fail("嵌套层数过深");
+        }
+        ++p_; // '['
+        if (!handler_.onStartArray()) return fail("解析被中止");
+        size_t count = 0;
+        skipWhitespace();
+        if (p_ < end_ && *p_ == ']') {
+            ++p_;
+        } else {
+            while (true) {
+                if (!parseValue()) return false;
+                ++count;
+                skipWhitespace();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    skipWhitespace();
+                    continue;
+                }
+                if (p_ < end_ && *p_ == ']') {
+                    ++p_;
+                    break;
+                }
+                return fail("数组中缺少','或']'");
+            }
+        }
+        --depth_;
+        return handler_.onEndArray(count) || fail("解析被中止");
+    }
+
+    bool parseNumber() {
+        const char* start = p_;
+        if (*p_ == '-') ++p_;
+        if (p_ == end_) return fail("无效的数字");
+        if (*p_ == '0') {
+            ++p_;
+        } else if (isDigit(*p_)) {
+            while (p_ < end_ && isDigit(*p_)) ++p_;
+        } else {
+            return fail("无效的数字");
+        }
+        if (p_ < end_ && *p_ == '.') {
+            ++p_;
+            if (p_ == end_ || !isDigit(*p_)) return fail("小数点后缺少数字");
+            while (p_ < end_ && isDigit(*p_)) ++p_;
+        }
+        if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+            ++p_;
+            if (p_ < end_ && (*p_ == '+' || *p_ == '-')) ++p_;
+            if (p_ == end_ || !isDigit(*p_)) return fail("指数缺少数字");
+            while (p_ < end_ && isDigit(*p_)) ++p_;
+        }
+        double value = 0;
+        // 语法已校验；超出double范围时from_chars返回错误，value保持0
+        std::from_chars(start, p_, value);
+        return handler_.onNumber(std::string_view(start, p_ - start), value) || fail("解析被中止");
+    }
+
+    /**
+     * @brief 解析字符串，p_指向开头的引号
+     *
+     * 不含转义且UTF-8合法时直接返回输入中的视图；否则先找到结尾的引号，
+     * 再解码到scratch_中，非法UTF-8字节替换为U+FFFD。
+     */
+    bool parseString(std::string_view& out) {
+        ++p_; // '"'
+        const char* start = p_;
+        size_t run = findJsonSpecial(p_, end_ - p_);
+        if (p_ + run < end_ && p_[run] == '"' && validUtf8Prefix(start, run) == run) {
+            out = std::string_view(start, run);
+            p_ += run + 1;
+            return true;
+        }
+
+        p_ += run;
+        while (true) {
+            if (p_ == end_) {
+                return fail("字符串未结束");
+            }
+            if (*p_ == '"') {
+                break;
+            }
+            if (*p_ != '\\') {
+                return fail("字符串中含有未转义的控制字符");
+            }
+            if (end_ - p_ < 2) {
+                return fail("字符串未结束");
+            }
+            p_ += 2; // 跳过转义字符，具体含义在解码时校验
+            p_ += findJsonSpecial(p_, end_ - p_);
+        }
+
+        scratch_.clear();
+        if (!decodeJsonString(start, p_, scratch_, true)) {
+            return fail("无效的转义序列");
+        }
+        ++p_;
+        out = scratch_;
+        return true;
+    }
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    JsonHandler& handler_;
+    int depth_;
+    std::string scratch_;
+    std::string error_;
+};
+
+bool JsonReader::parse(std::string_view input, JsonHandler& handler, std::string* error) {
+    JsonParserImpl parser(input, handler);
+    return parser.run(error);
+}
+
+bool JsonReader::unescape(std::string_view escaped, std::string& out) {
+    return decodeJsonString(escaped.data(), escaped.data() + escaped.size(), out, false);
+}
+
+/**
+ * @brief 把SAX事件组装成DOM
+ *
+ * 已完成的值按顺序压入栈中，容器结束时把属于它的那一段拷贝到arena。
+ */
+class JsonDomBuilder : public JsonHandler {
+public:
+    JsonDomBuilder(JsonDocument& doc, std::string_view input) : doc_(doc), input_(input) {}
+
+    // 解析成功后栈中恰好剩下根节点
+    const JsonValue* result() {
+        void* memory = doc_.allocate(sizeof(JsonValue), alignof(JsonValue));
+        return new (memory) JsonValue(stack_.front().value);
+    }
+
+    bool onNull() override {
+        push(JsonValue());
+        return true;
+    }
+
+    bool onBool(bool value) override {
+        JsonValue v;
+        v.type_ = JsonType::Bool;
+        v.bool_ = value;
+        push(v);
+        return true;
+    }
+
+    bool onNumber(std::string_view raw, double value) override {
+        JsonValue v;
+        v.type_ = JsonType::Number;
+        v.number_ = value;
+        v.str_ = keep(raw);
+        push(v);
+        return true;
+    }
+
+    bool onString(std::string_view value) override {
+        JsonValue v;
+        v.type_ = JsonType::String;
+        v.str_ = keep(value);
+        push(v);
+        return true;
+    }
+
+    bool onKey(std::string_view key) override {
+        key_ = keep(key);
+        return true;
+    }
+
+    bool onStartObject() override {
+        frames_.push_back(Frame{stack_.size(), key_});
+        return true;
+    }
+
+    bool onEndObject(size_t member_count) override {
+        JsonValue v;
+        v.type_ = JsonType::Object;
+        v.members_ = popMembers(member_count);
+        v.size_ = member_count;
+        push(v);
+        return true;
+    }
+
+    bool onStartArray() override {
+        frames_.push_back(Frame{stack_.size(), key_});
+        return true;
+    }
+
+    bool onEndArray(size_t element_count) override {
+        const JsonMember* members = popMembers(element_count);
+        auto* items = static_cast<JsonValue*>(
+            doc_.allocate(sizeof(JsonValue) * element_count, alignof(JsonValue)));
+        for (size_t i = 0; i < element_count; ++i) {
+            new (&items[i]) JsonValue(members[i].value);
+        }
+        JsonValue v;
+        v.type_ = JsonType::Array;
+        v.items_ = items;
+        v.size_ = element_count;
+        push(v);
+        return true;
+    }
+
+private:
+    struct Frame {
+        size_t start;            // 容器的第一个子值在stack_中的位置
+        std::string_view key;    // 容器自身在父对象中的键
+    };
+
+    // 指向输入的视图直接保留，指向解析器临时缓冲区的拷贝到arena
+    std::string_view keep(std::string_view text) {
+        if (text.data() >= input_.data() && text.data() + text.size() <= input_.data() + input_.size()) {
+            return text;
+        }
+        return doc_.store(text);
+    }
+
+    void push(const JsonValue& value) {
+        stack_.push_back(JsonMember{key_, value});
+        key_ = std::string_view();
+    }
+
+    const JsonMember* popMembers(size_t count) {
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        auto* members = static_cast<JsonMember*>(
+            doc_.allocate(sizeof(JsonMember) * count, alignof(JsonMember)));
+        std::uninitialized_copy(stack_.begin() + frame.start, stack_.end(), members);
+        stack_.resize(frame.start);
+        key_ = frame.key;
+        return members;
+    }
+
+    JsonDocument& doc_;
+    std::string_view input_;
+    std::vector<JsonMember> stack_;
+    std::vector<Frame> frames_;
+    std::string_view key_;
+};
+
+bool JsonValue::asBool(bool default_value) const {
+    return type_ == JsonType::Bool ? bool_ : default_value;
+}
+
+double JsonValue::asNumber(double default_value) const {
+    return type_ == JsonType::Number ? number_ : default_value;
+}
+
+long long JsonValue::asInt(long long default_value) const {
+    if (type_ != JsonType::Number) {
+        return default_value;
+    }
+    long long value = 0;
+    // 整数直接按文本转换，避免大整数经double丢失精度
+    auto result = std::from_chars(str_.data(), str_.data() + str_.size(), value);
+    if (result.ec == std::errc() && result.ptr == str_.data() + str_.size()) {
+        return value;
+    }
+    if (number_ >= -9.2e18 && number_ <= 9.2e18) {
+        return static_cast<long long>(number_);
+    }
+    return default_value;
+}
+
+std::string_view JsonValue::asString(std::string_view default_value) const {
+    return type_ == JsonType::String ? str_ : default_value;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    if (type_ != JsonType::Array || index >= size_) {
+        return null_value;
+    }
+    return items_[index];
+}
+
+const JsonMember& JsonValue::member(size_t index) const {
+    if (type_ != JsonType::Object || index >= size_) {
+        return null_member;
+    }
+    return members_[index];
+}
+
+const JsonValue* JsonValue::get(std::string_view key) const {
+    if (type_ != JsonType::Object) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < size_; ++i) {
+        if (members_[i].key == key) {
+            return &members_[i].value;
+        }
+    }
+    return nullptr;
+}
+
+const JsonValue* JsonValue::find(std::string_view path) const {
+    const JsonValue* current = this;
+    size_t pos = 0;
+    while (pos < path.size() && current) {
+        if (path[pos] == '.') {
+            ++pos;
+            continue;
+        }
+        if (path[pos] == '[') {
+            size_t close = path.find(']', pos);
+            if (close == std::string_view::npos) {
+                return nullptr;
+            }
+            size_t index = 0;
+            auto result = std::from_chars(path.data() + pos + 1, path.data() + close, index);
+            if (result.ec != std::errc() || result.ptr != path.data() + close ||
+                !current->isArray() || index >= current->size_) {
+                return nullptr;
+            }
+            current = &current->items_[index];
+            pos = close + 1;
+            continue;
+        }
+        size_t next = path.find_first_of(".[", pos);
+        if (next == std::string_view::npos) {
+            next = path.size();
+        }
+        current = current->get(path.substr(pos, next - pos));
+        pos = next;
+    }
+    return current;
+}
+
+JsonDocument::JsonDocument() : block_index_(0), block_used_(0), root_(&null_value) {
+}
+
+JsonDocument::~JsonDocument() = default;
+
+void JsonDocument::resetArena() {
+    // 保留已分配的块，重复解析时复用
+    block_index_ = 0;
+    block_used_ = 0;
+}
+
+void* JsonDocument::allocate(size_t size, size_t align) {
+    if (size == 0) {
+        size = 1;
+    }
+    while (block_index_ < blocks_.size()) {
+        Block& block = blocks_[block_index_];
+        size_t offset = (block_used_ + align - 1) & ~(align - 1);
+        if (offset + size <= block.size) {
+            block_used_ = offset + size;
+            return block.data.get() + offset;
+        }
+        ++block_index_;
+        block_used_ = 0;
+    }
+    size_t block_size = blocks_.empty() ? arena_block_size
+                                        : std::min(blocks_.back().size * 2, arena_max_block_size);
+    block_size = std::max(block_size, size + align);
+    // new char[]的返回值按max_align_t对齐，满足所有节点类型
+    blocks_.push_back(Block{std::unique_ptr<char[]>(new char[block_size]), block_size});
+    block_index_ = blocks_.size() - 1;
+    block_used_ = size;
+    return blocks_.back().data.get();
+}
+
+std::string_view JsonDocument::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    char* data = static_cast<char*>(allocate(text.size(), 1));
+    std::memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
+}
+
+bool JsonDocument::parse(std::string_view input) {
+    static Histogram& parse_seconds = MetricsRegistry::getInstance().histogram(
+        "agent_json_parse_seconds", "JsonDocument::parse解析一个JSON文档的耗时");
+    auto start = std::chrono::steady_clock::now();
+    resetArena();
+    bool ok = build(input);
+    parse_seconds.observeSince(start);
+    return ok;
+}
+
+bool JsonDocument::parseCopy(std::string_view input) {
+    resetArena();
+    return build(store(input));
+}
+
+bool JsonDocument::build(std::string_view input) {
+    root_ = &null_value;
+    error_.clear();
+
+    JsonDomBuilder builder(*this, input);
+    if (!JsonReader::parse(input, builder, &error_)) {
+        return false;
+    }
+    root_ = builder.result();
+    return true;
+}
+
+std::string JsonDocument::getString(std::string_view path, const std::string& default_value) const {
+    const JsonValue* value = find(path);
+    if (!value || !value->isString()) {
+        return default_value;
+    }
+    return std::string(value->asString());
+}
+
+} // namespace utils
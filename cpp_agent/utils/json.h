@@ -0,0 +1,165 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+
+enum class JsonType : uint8_t { Null, Bool, Number, String, Array, Object };
+
+/**
+ * @brief SAX回调接口，返回false中止解析
+ *
+ * 字符串参数已反转义且为合法UTF-8（非法字节替换为U+FFFD）；不含转义字符时直接指向输入，
+ * 否则指向内部临时缓冲区，仅在回调期间有效。
+ */
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+
+    virtual bool onNull() = 0;
+    virtual bool onBool(bool value) = 0;
+    virtual bool onNumber(std::string_view raw, double value) = 0;
+    virtual bool onString(std::string_view value) = 0;
+    virtual bool onKey(std::string_view key) = 0;
+    virtual bool onStartObject() = 0;
+    virtual bool onEndObject(size_t member_count) = 0;
+    virtual bool onStartArray() = 0;
+    virtual bool onEndArray(size_t element_count) = 0;
+};
+
+/**
+ * @brief 单遍JSON解析器（SAX），严格遵循RFC 8259
+ */
+class JsonReader {
+public:
+    /**
+     * @brief 解析input，依次回调handler
+     * @param error 失败时写入错误描述（含出错位置）
+     * @return 解析成功且handler未中止时返回true
+     */
+    static bool parse(std::string_view input, JsonHandler& handler, std::string* error = nullptr);
+
+    /**
+     * @brief 解码JSON字符串的内容（不含两侧引号），结果追加到out
+     *
+     * \uXXXX（含代理对）解码为UTF-8，孤立代理和非法UTF-8字节替换为U+FFFD；
+     * 无效的转义序列原样保留并返回false。
+     */
+    static bool unescape(std::string_view escaped, std::string& out);
+};
+
+struct JsonMember;
+
+/**
+ * @brief DOM节点，由JsonDocument在其arena中分配，生命周期与文档相同
+ */
+class JsonValue {
+public:
+    JsonValue() : type_(JsonType::Null), bool_(false), number_(0), items_(nullptr), size_(0) {}
+
+    JsonType type() const { return type_; }
+    bool isNull() const { return type_ == JsonType::Null; }
+    bool isBool() const { return type_ == JsonType::Bool; }
+    bool isNumber() const { return type_ == JsonType::Number; }
+    bool isString() const { return type_ == JsonType::String; }
+    bool isArray() const { return type_ == JsonType::Array; }
+    bool isObject() const { return type_ == JsonType::Object; }
+
+    // 类型不符时返回默认值
+    bool asBool(bool default_value = false) const;
+    double asNumber(double default_value = 0) const;
+    long long asInt(long long default_value = 0) const;
+    std::string_view asString(std::string_view default_value = std::string_view()) const;
+    // 数字的原始文本（如"0.10"），其他类型返回空
+    std::string_view numberText() const { return type_ == JsonType::Number ? str_ : std::string_view(); }
+
+    // 数组元素个数或对象成员个数
+    size_t size() const { return type_ == JsonType::Array || type_ == JsonType::Object ? size_ : 0; }
+
+    // 数组下标访问，越界或非数组时返回null节点
+    const JsonValue& operator[](size_t index) const;
+    // 对象成员（按出现顺序），仅对对象有效
+    const JsonMember& member(size_t index) const;
+    // 按键查找对象成员，找不到返回nullptr
+    const JsonValue* get(std::string_view key) const;
+
+    /**
+     * @brief 路径查询，如 "output.choices[0].message.content"
+     * @return 找不到返回nullptr
+     */
+    const JsonValue* find(std::string_view path) const;
+
+private:
+    friend class JsonDomBuilder;
+
+    JsonType type_;
+    bool bool_;
+    double number_;
+    std::string_view str_;          // 字符串值，或数字的原始文本
+    union {
+        const JsonValue* items_;    // 数组元素
+        const JsonMember* members_; // 对象成员
+    };
+    size_t size_;
+};
+
+struct JsonMember {
+    std::string_view key;
+    JsonValue value;
+};
+
+/**
+ * @brief JSON文档：解析后的DOM，所有节点和反转义后的字符串分配在内部arena中
+ *
+ * 不含转义字符的字符串直接指向输入（零拷贝），因此input必须比文档活得久；
+ * 需要文档自行持有输入时使用parseCopy()。
+ */
+class JsonDocument {
+public:
+    JsonDocument();
+    ~JsonDocument();
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    bool parse(std::string_view input);
+    bool parseCopy(std::string_view input);
+
+    const JsonValue& root() const { return *root_; }
+    const std::string& error() const { return error_; }
+
+    const JsonValue* find(std::string_view path) const { return root_->find(path); }
+
+    /**
+     * @brief 按路径取字符串值，不存在或不是字符串时返回默认值
+     */
+    std::string getString(std::string_view path, const std::string& default_value = "") const;
+
+    // arena分配（供DOM构建使用）
+    void* allocate(size_t size, size_t align);
+    std::string_view store(std::string_view text);
+
+private:
+    void resetArena();
+    bool build(std::string_view input);
+
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+    std::vector<Block> blocks_;
+    size_t block_index_;
+    size_t block_used_;
+
+    const JsonValue* root_;
+    std::string error_;
+};
+
+} // namespace utils
+
+#endif // JSON_H
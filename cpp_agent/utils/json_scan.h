@@ -0,0 +1,132 @@
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace utils {
+
+/**
+ * @brief 返回第一个JSON字符串中需要特殊处理的字节（'"'、'\\'、控制字符）的下标，没有时返回size
+ *
+ * 按16字节（SSE2）或32字节（AVX2）一组比较，解析和转义共用
+ */
+inline size_t findJsonSpecial(const char* data, size_t size) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i control32 = _mm256_set1_epi8(0x1f);
+    for (; i + 32 <= size; i += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        // 无符号比较 c <= 0x1f 等价于 max(c, 0x1f) == 0x1f
+        __m256i hits = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote32), _mm256_cmpeq_epi8(chunk, backslash32)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control32), control32));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; i + 16 <= size; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < size; ++i) {
+        unsigned char c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c < 0x20) {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief 返回data中合法UTF-8前缀的字节数（拒绝超长编码、代理区码点和大于U+10FFFF的码点）
+ *
+ * 纯ASCII部分按16字节一组跳过，小端平台上三字节序列按4字节一组判断
+ */
+inline size_t validUtf8Prefix(const char* data, size_t size) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+    while (i < size) {
+#if defined(__SSE2__)
+        while (i + 16 <= size &&
+               _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i))) == 0) {
+            i += 16;
+        }
+#endif
+        while (i < size && p[i] < 0x80) {
+            ++i;
+        }
+        // 连续的多字节序列（如中文文本）在标量循环中处理，遇到ASCII再回到上面的快速跳过
+        while (i < size && p[i] >= 0x80) {
+            // 最常见的三字节序列（含全部常用汉字和全角标点）按4字节一次判断：
+            // 首字节E1-EC/EE-EF，后两个字节为10xxxxxx
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            uint32_t word;
+            while (size - i >= 4) {
+                std::memcpy(&word, p + i, sizeof(word));
+                uint32_t lead = word & 0xFF;
+                if ((word & 0xC0C0F0u) != 0x8080E0u || lead == 0xE0 || lead == 0xED) {
+                    break;
+                }
+                i += 3;
+            }
+#endif
+            if (i >= size || p[i] < 0x80) {
+                break;
+            }
+            unsigned char c = p[i];
+            size_t left = size - i;
+            size_t len;
+            unsigned char lo = 0x80;
+            unsigned char hi = 0xBF;
+            if (c >= 0xC2 && c <= 0xDF) {
+                len = 2;
+            } else if (c >= 0xE0 && c <= 0xEF) {
+                len = 3;
+                if (c == 0xE0) lo = 0xA0;       // 超长编码
+                else if (c == 0xED) hi = 0x9F;  // 代理区
+            } else if (c >= 0xF0 && c <= 0xF4) {
+                len = 4;
+                if (c == 0xF0) lo = 0x90;       // 超长编码
+                else if (c == 0xF4) hi = 0x8F;  // 大于U+10FFFF
+            } else {
+                return i;
+            }
+            if (left < len || p[i + 1] < lo || p[i + 1] > hi) {
+                return i;
+            }
+            for (size_t k = 2; k < len; ++k) {
+                if ((p[i + k] & 0xC0) != 0x80) {
+                    return i;
+                }
+            }
+            i += len;
+        }
+    }
+    return size;
+}
+
+} // namespace utils
+
+#endif // JSON_SCAN_H
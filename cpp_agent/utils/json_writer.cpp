@@ -0,0 +1,207 @@
+#include "json_writer.h"
+#include "json_scan.h"
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace utils {
+
+// 线程复用缓冲区超过该容量时在释放后收缩，避免偶发的大请求长期占用内存
+static constexpr size_t max_retained_capacity = 256 * 1024;
+
+struct ThreadBuffer {
+    std::string buffer;
+    bool in_use = false;
+};
+
+static thread_local ThreadBuffer thread_buffer;
+
+// 每个字节的转义方式：0不转义，'u'写为\u00XX，其他为反斜杠后的字符
+static constexpr std::array<char, 256> makeEscapeTable() {
+    std::array<char, 256> table{};
+    for (int c = 0; c < 0x20; ++c) {
+        table[c] = 'u';
+    }
+    table['\b'] = 'b';
+    table['\f'] = 'f';
+    table['\n'] = 'n';
+    table['\r'] = 'r';
+    table['\t'] = 't';
+    table['"'] = '"';
+    table['\\'] = '\\';
+    return table;
+}
+
+static constexpr std::array<char, 256> escape_table = makeEscapeTable();
+
+void JsonWriter::appendEscaped(std::string& out, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    out.reserve(out.size() + text.size() + 2);
+    const char* data = text.data();
+    size_t size = text.size();
+    size_t pos = 0;
+    while (pos < size) {
+        size_t run = findJsonSpecial(data + pos, size - pos);
+        out.append(data + pos, run);
+        pos += run;
+        if (pos == size) {
+            break;
+        }
+        unsigned char c = static_cast<unsigned char>(data[pos++]);
+        char escape = escape_table[c];
+        if (escape == 'u') {
+            char unicode[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f]};
+            out.append(unicode, sizeof(unicode));
+        } else {
+            char pair[2] = {'\\', escape};
+            out.append(pair, sizeof(pair));
+        }
+    }
+}
+
+JsonWriter::JsonWriter()
+    : out_(&owned_), uses_thread_buffer_(false), depth_(0), has_items_(0), after_key_(false) {
+    if (!thread_buffer.in_use) {
+        thread_buffer.in_use = true;
+        thread_buffer.buffer.clear();
+        out_ = &thread_buffer.buffer;
+        uses_thread_buffer_ = true;
+    }
+}
+
+JsonWriter::JsonWriter(std::string& out)
+    : out_(&out), uses_thread_buffer_(false), depth_(0), has_items_(0), after_key_(false) {
+}
+
+JsonWriter::~JsonWriter() {
+    if (uses_thread_buffer_) {
+        if (thread_buffer.buffer.capacity() > max_retained_capacity) {
+            std::string().swap(thread_buffer.buffer);
+        }
+        thread_buffer.in_use = false;
+    }
+}
+
+void JsonWriter::separate() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+    if (depth_ > 0) {
+        uint64_t bit = 1ULL << (depth_ - 1);
+        if (has_items_ & bit) {
+            out_->push_back(',');
+        }
+        has_items_ |= bit;
+    }
+}
+
+void JsonWriter::push(char open) {
+    separate();
+    if (depth_ >= max_depth) {
+        throw std::length_error("JsonWriter: 嵌套层数过深");
+    }
+    out_->push_back(open);
+    has_items_ &= ~(1ULL << depth_);
+    depth_++;
+}
+
+void JsonWriter::pop(char close) {
+    if (depth_ == 0) {
+        throw std::logic_error("JsonWriter: 容器开闭不匹配");
+    }
+    depth_--;
+    out_->push_back(close);
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    push('{');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    pop('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    push('[');
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    pop(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    out_->push_back('"');
+    appendEscaped(*out_, name);
+    out_->append("\":", 2);
+    after_key_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    out_->push_back('"');
+    appendEscaped(*out_, text);
+    out_->push_back('"');
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separate();
+    if (flag) {
+        out_->append("true", 4);
+    } else {
+        out_->append("false", 5);
+    }
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    separate();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    out_->append(buf, result.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(unsigned long long number) {
+    separate();
+    char buf[24];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    out_->append(buf, result.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    separate();
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), number);
+    out_->append(buf, result.ptr - buf);
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out_->append("null", 4);
+    return *this;
+}
+
+JsonWriter& JsonWriter::rawMembers(std::string_view members) {
+    if (members.empty()) {
+        return *this;
+    }
+    separate();
+    out_->append(members.data(), members.size());
+    return *this;
+}
+
+} // namespace utils
@@ -0,0 +1,85 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+namespace utils {
+
+/**
+ * @brief 流式JSON写入器，逗号和引号由写入器负责
+ *
+ * 用法：
+ *   JsonWriter json;
+ *   json.beginObject().key("code").value(200).key("msg").value("success").endObject();
+ *   send(json.str());
+ *
+ * 默认构造时写入当前线程复用的缓冲区，构造请求体和响应体不再每次重新分配；
+ * 同一线程上嵌套创建的写入器自动改用独立缓冲区。str()的结果在写入器析构前有效。
+ */
+class JsonWriter {
+public:
+    JsonWriter();
+    // 追加到调用方提供的字符串
+    explicit JsonWriter(std::string& out);
+    ~JsonWriter();
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(int number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(long number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(long long number);
+    JsonWriter& value(unsigned number) { return value(static_cast<unsigned long long>(number)); }
+    JsonWriter& value(unsigned long number) { return value(static_cast<unsigned long long>(number)); }
+    JsonWriter& value(unsigned long long number);
+    // NaN和无穷大写为null
+    JsonWriter& value(double number);
+    JsonWriter& null();
+
+    /**
+     * @brief 插入已序列化的若干对象成员（形如 "a":1,"b":2），用于拼接预先生成的固定片段
+     */
+    JsonWriter& rawMembers(std::string_view members);
+
+    const std::string& str() const { return *out_; }
+
+    /**
+     * @brief 把text转义后追加到out（不含两侧引号）
+     *
+     * 按16/32字节一组扫描需要转义的字符（引号、反斜杠、控制字符），无需转义的部分整段拷贝
+     */
+    static void appendEscaped(std::string& out, std::string_view text);
+
+private:
+    // 写入值或键之前调用：同一容器内非首个元素前补逗号
+    void separate();
+    void push(char open);
+    void pop(char close);
+
+    // 嵌套层数上限；每层用一位记录该层是否已写入元素
+    static constexpr int max_depth = 64;
+
+    std::string owned_;
+    std::string* out_;
+    bool uses_thread_buffer_;
+    int depth_;
+    uint64_t has_items_;      // 第i位表示第i层容器已有元素
+    bool after_key_;          // 刚写完键，下一个值不需要逗号
+};
+
+} // namespace utils
+
+#endif // JSON_WRITER_H
@@ -1,21 +1,176 @@
 #include "logger.h"
 #include "config.h"
+#include "json_writer.h"
 #include <iostream>
 #include <cstdlib>
-#include <iomanip>
-#include <sstream>
+#include <cstring>
+#include <cmath>
 #include <ctime>
+#include <chrono>
+#include <cerrno>
 #include <algorithm>
+#include <random>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace utils {
 
-Logger::Logger() : current_level_(LogLevel::INFO) {
+// 单次write的批量上限，避免长时间积压后一次分配过大的缓冲区
+static constexpr size_t max_batch_bytes = 256 * 1024;
+// 限流丢弃条数的汇总间隔
+static constexpr auto suppressed_report_interval = std::chrono::seconds(1);
+
+static thread_local LogContextPtr current_log_context;
+
+static size_t roundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static const char* levelToString(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO ";
+        case LogLevel::WARN:  return "WARN ";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+// JSON格式使用的级别名（不补空格）
+static const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO";
+        case LogLevel::WARN:  return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+static void appendJsonString(std::string& out, std::string_view key, std::string_view value) {
+    out += ",\"";
+    out.append(key.data(), key.size());
+    out += "\":\"";
+    JsonWriter::appendEscaped(out, value);
+    out += '"';
+}
+
+// 追加"YYYY-MM-DD HH:MM:SS.mmm"；秒级前缀按线程缓存，同一秒内只需格式化毫秒
+static void appendTimestamp(std::string& out) {
+    struct TimeCache {
+        time_t second = -1;
+        char prefix[20] = {0};
+    };
+    static thread_local TimeCache cache;
+
+    auto now = std::chrono::system_clock::now();
+    auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    time_t second = static_cast<time_t>(ms_since_epoch / 1000);
+    int ms = static_cast<int>(ms_since_epoch % 1000);
+
+    if (second != cache.second) {
+        std::tm tm_buf;
+        if (localtime_r(&second, &tm_buf) == nullptr ||
+            std::strftime(cache.prefix, sizeof(cache.prefix), "%Y-%m-%d %H:%M:%S", &tm_buf) == 0) {
+            std::memcpy(cache.prefix, "0000-00-00 00:00:00", sizeof(cache.prefix));
+        }
+        cache.second = second;
+    }
+    out.append(cache.prefix, 19);
+    char millis[4] = {'.', static_cast<char>('0' + ms / 100), static_cast<char>('0' + ms / 10 % 10),
+                      static_cast<char>('0' + ms % 10)};
+    out.append(millis, sizeof(millis));
+}
+
+LogContextPtr LogContext::current() {
+    return current_log_context;
+}
+
+std::string LogContext::newRequestId() {
+    // 进程启动时取随机起点再递增：进程内不重复，不同进程（重启前后）之间也不易撞号
+    static const uint64_t origin = [] {
+        std::random_device rd;
+        return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }();
+    static std::atomic<uint64_t> counter{0};
+    uint64_t id = origin + counter.fetch_add(1, std::memory_order_relaxed);
+
+    static const char hex[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        text[i] = hex[id & 0xf];
+        id >>= 4;
+    }
+    return text;
+}
+
+ScopedLogContext::ScopedLogContext(LogContextPtr context)
+    : previous_(std::move(current_log_context)) {
+    current_log_context = std::move(context);
+}
+
+ScopedLogContext::ScopedLogContext(const std::string& user_id, const std::string& session_id)
+    : previous_(current_log_context) {
+    auto context = std::make_shared<LogContext>();
+    if (previous_) {
+        context->request_id = previous_->request_id;
+    }
+    context->user_id = user_id;
+    context->session_id = session_id;
+    current_log_context = std::move(context);
+}
+
+ScopedLogContext::~ScopedLogContext() {
+    current_log_context = std::move(previous_);
+}
+
+LogFields& LogFields::add(const char* key, std::string_view value) {
+    fields_.push_back(Field{key, std::string(value), true});
+    return *this;
+}
+
+LogFields& LogFields::add(const char* key, long long value) {
+    fields_.push_back(Field{key, std::to_string(value), false});
+    return *this;
+}
+
+LogFields& LogFields::add(const char* key, double value) {
+    char buf[32];
+    int n = std::isfinite(value) ? snprintf(buf, sizeof(buf), "%.3f", value) : snprintf(buf, sizeof(buf), "null");
+    fields_.push_back(Field{key, std::string(buf, static_cast<size_t>(n)), false});
+    return *this;
+}
+
+Logger::Logger()
+    : current_level_(LogLevel::INFO), json_format_(false), limits_enabled_(false),
+      default_rate_per_sec_(0), default_sample_every_(1), capacity_(0), enqueue_pos_(0), dequeue_pos_(0), dropped_(0),
+      running_(false), producers_(0), should_stop_(false), flush_interval_ms_(100), log_fd_(-1) {
     // 构造函数中不读取配置，等待init()调用
 }
 
 Logger::~Logger() {
-    if (log_file_ && log_file_->is_open()) {
-        log_file_->close();
+    close();
+    if (log_fd_ >= 0) {
+        ::close(log_fd_);
     }
 }
 
@@ -28,102 +183,383 @@ void Logger::init() {
     // 从配置文件读取日志级别
     auto& config = Config::getInstance();
     std::string level_str = config.getString("log_level", "INFO");
-    
+
     std::transform(level_str.begin(), level_str.end(), level_str.begin(), ::toupper);
     if (level_str == "DEBUG") {
-        current_level_ = LogLevel::DEBUG;
+        setLogLevel(LogLevel::DEBUG);
     } else if (level_str == "INFO") {
-        current_level_ = LogLevel::INFO;
+        setLogLevel(LogLevel::INFO);
     } else if (level_str == "WARN") {
-        current_level_ = LogLevel::WARN;
+        setLogLevel(LogLevel::WARN);
     } else if (level_str == "ERROR") {
-        current_level_ = LogLevel::ERROR;
+        setLogLevel(LogLevel::ERROR);
     }
-    
+
     // 从配置文件读取日志文件路径
     std::string log_file = config.getString("log_file", "");
     if (!log_file.empty()) {
         setLogFile(log_file);
     }
+
+    // 输出格式：text（默认）或json
+    std::string format = config.getString("log_format", "text");
+    std::transform(format.begin(), format.end(), format.begin(), ::tolower);
+    json_format_ = (format == "json");
+
+    if (running_) {
+        return;
+    }
+
+    // DEBUG/INFO日志的限流和采样：全局默认值，log_module_limits按模块覆盖
+    default_rate_per_sec_ = std::max(0, config.getInt("log_rate_limit_per_sec", 0));
+    default_sample_every_ = std::max(1, config.getInt("log_sample_every", 1));
+    parseModuleLimits(config.getString("log_module_limits", ""));
+    limits_enabled_ = default_rate_per_sec_ > 0 || default_sample_every_ > 1 || !module_limits_.empty();
+
+    capacity_ = roundUpPowerOfTwo(static_cast<size_t>(std::max(2, config.getInt("log_queue_capacity", 8192))));
+    flush_interval_ms_ = std::max(1, config.getInt("log_flush_interval_ms", 100));
+    slots_.reset(new Slot[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i) {
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_ = 0;
+    should_stop_ = false;
+    writer_thread_ = std::thread(&Logger::writeLoop, this);
+    running_.store(true, std::memory_order_release);
+}
+
+void Logger::close() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        should_stop_ = true;
+    }
+    wake_cv_.notify_one();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+    // 在running_切换前已看到true的生产者可能仍在入队，等它们完成；
+    // 之后到达的生产者会看到running_为false，改为同步写出
+    while (producers_.load() != 0) {
+        std::this_thread::yield();
+    }
+    // 写线程退出后仍可能有在running_切换前入队的日志，最后再取一次
+    std::string batch;
+    while (drainTo(batch) > 0) {
+        writeBatch(batch);
+        batch.clear();
+    }
 }
 
 void Logger::setLogLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    current_level_ = level;
+    current_level_.store(level, std::memory_order_relaxed);
 }
 
 void Logger::setLogFile(const std::string& filepath) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(file_mutex_);
     log_filepath_ = filepath;
-    
-    if (log_file_ && log_file_->is_open()) {
-        log_file_->close();
+
+    if (log_fd_ >= 0) {
+        ::close(log_fd_);
+        log_fd_ = -1;
     }
-    
+
     if (!filepath.empty()) {
-        log_file_ = std::make_unique<std::ofstream>(filepath, std::ios::app);
-        if (!log_file_->is_open()) {
+        log_fd_ = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (log_fd_ < 0) {
             std::cerr << "[Logger Error] 无法打开日志文件: " << filepath << std::endl;
-            log_file_.reset();
         }
-    } else {
-        log_file_.reset();
     }
 }
 
-std::string Logger::levelToString(LogLevel level) {
-    switch (level) {
-        case LogLevel::DEBUG: return "DEBUG";
-        case LogLevel::INFO:  return "INFO ";
-        case LogLevel::WARN:  return "WARN ";
-        case LogLevel::ERROR: return "ERROR";
-        default: return "UNKNOWN";
+bool Logger::tryPush(std::string&& line, size_t& pos) {
+    pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+        Slot& slot = slots_[pos & (capacity_ - 1)];
+        size_t seq = slot.seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.line = std::move(line);
+                slot.seq.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;   // 队列已满
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
     }
 }
 
-std::string Logger::getCurrentTime() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::tm* tm_ptr = std::localtime(&time_t);
-    if (!tm_ptr) {
-        return "0000-00-00 00:00:00.000";
+size_t Logger::drainTo(std::string& batch) {
+    size_t count = 0;
+    while (batch.size() < max_batch_bytes) {
+        Slot& slot = slots_[dequeue_pos_ & (capacity_ - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != dequeue_pos_ + 1) {
+            break;
+        }
+        batch += slot.line;
+        slot.line.clear();
+        slot.seq.store(dequeue_pos_ + capacity_, std::memory_order_release);
+        dequeue_pos_++;
+        count++;
     }
-    
-    std::ostringstream oss;
-    oss << std::put_time(tm_ptr, "%Y-%m-%d %H:%M:%S");
-    oss << "." << std::setfill('0') << std::setw(3) << ms.count();
-    return oss.str();
+    return count;
 }
 
-void Logger::writeLog(const std::string& log_message) {
-    // 输出到控制台
-    std::cout << log_message << std::endl;
-    
-    // 输出到文件（如果已设置）
-    if (log_file_ && log_file_->is_open()) {
-        *log_file_ << log_message << std::endl;
-        log_file_->flush();
+void Logger::writeBatch(const std::string& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(file_mutex_);
+    writeAll(STDOUT_FILENO, batch.data(), batch.size());
+    if (log_fd_ >= 0) {
+        writeAll(log_fd_, batch.data(), batch.size());
+    }
+}
+
+void Logger::writeLoop() {
+    std::string batch;
+    uint64_t reported_dropped = 0;
+    auto last_report = std::chrono::steady_clock::now();
+    while (true) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_), [this] { return should_stop_; });
+            stop = should_stop_;
+        }
+
+        // 一直取到队列为空，每批一次write
+        while (true) {
+            batch.clear();
+            size_t count = drainTo(batch);
+            writeBatch(batch);
+            if (count == 0 || batch.size() < max_batch_bytes) {
+                break;
+            }
+        }
+
+        batch.clear();
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped) {
+            uint64_t count = dropped - reported_dropped;
+            formatLine(batch, LogLevel::WARN, "Logger", "日志队列已满，丢弃了 " + std::to_string(count) + " 条日志",
+                       &LogFields().add("dropped", static_cast<long long>(count)));
+            reported_dropped = dropped;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (limits_enabled_ && (stop || now - last_report >= suppressed_report_interval)) {
+            reportSuppressed(batch);
+            last_report = now;
+        }
+        writeBatch(batch);
+
+        if (stop) {
+            break;
+        }
     }
 }
 
 void Logger::log(LogLevel level, const std::string& module, const std::string& message) {
-    // 检查日志级别
-    if (level < current_level_) {
+    logLine(level, module, message, nullptr);
+}
+
+void Logger::log(LogLevel level, const std::string& module, const std::string& message, const LogFields& fields) {
+    logLine(level, module, message, &fields);
+}
+
+void Logger::logLine(LogLevel level, const std::string& module, const std::string& message,
+                     const LogFields* fields) {
+    // 检查日志级别（直接调用log()/debug()等接口时同样生效）
+    if (!shouldLog(level)) {
+        return;
+    }
+    // 限流只作用于DEBUG/INFO，警告和错误总是输出
+    if (limits_enabled_ && level < LogLevel::WARN && !admit(module)) {
+        return;
+    }
+
+    std::string line;
+    formatLine(line, level, module, message, fields);
+
+    // producers_与running_都用顺序一致的读写：要么close()看到本次登记并等待，
+    // 要么这里看到running_已为false
+    producers_.fetch_add(1);
+    if (!running_.load()) {
+        producers_.fetch_sub(1);
+        // 写线程未启动或已停止：同步写出
+        writeBatch(line);
+        return;
+    }
+    size_t pos = 0;
+    bool pushed = tryPush(std::move(line), pos);
+    producers_.fetch_sub(1);
+    if (!pushed) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
         return;
     }
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::ostringstream log_stream;
-    log_stream << "[" << getCurrentTime() << "] "
-               << "[" << levelToString(level) << "] "
-               << "[" << module << "] "
-               << message;
-    
-    writeLog(log_stream.str());
+    // 错误日志尽快写出；每入队半个队列的日志也唤醒一次写线程，突发日志不必等满一个周期
+    if (level == LogLevel::ERROR || (pos & (capacity_ / 2 - 1)) == 0) {
+        wake_cv_.notify_one();
+    }
+}
+
+void Logger::formatLine(std::string& line, LogLevel level, std::string_view module, std::string_view message,
+                        const LogFields* fields) const {
+    const LogContext* context = current_log_context.get();
+    line.reserve(module.size() + message.size() + (json_format_ ? 160 : 48));
+
+    if (json_format_) {
+        line += "{\"ts\":\"";
+        appendTimestamp(line);
+        line += "\",\"level\":\"";
+        line += levelName(level);
+        line += '"';
+        appendJsonString(line, "module", module);
+        appendJsonString(line, "msg", message);
+        if (context != nullptr) {
+            if (!context->request_id.empty()) {
+                appendJsonString(line, "request_id", context->request_id);
+            }
+            if (!context->user_id.empty()) {
+                appendJsonString(line, "user_id", context->user_id);
+            }
+            if (!context->session_id.empty()) {
+                appendJsonString(line, "session_id", context->session_id);
+            }
+        }
+        if (fields != nullptr) {
+            for (const auto& field : fields->fields_) {
+                if (field.quoted) {
+                    appendJsonString(line, field.key, field.value);
+                } else {
+                    line += ",\"";
+                    line += field.key;
+                    line += "\":";
+                    line += field.value;
+                }
+            }
+        }
+        line += "}\n";
+        return;
+    }
+
+    // 文本格式：用户和会话已写在各条消息中，这里只追加request_id和附带字段
+    line += '[';
+    appendTimestamp(line);
+    line += "] [";
+    line += levelToString(level);
+    line += "] [";
+    line.append(module.data(), module.size());
+    line += "] ";
+    line.append(message.data(), message.size());
+    if (context != nullptr && !context->request_id.empty()) {
+        line += " request_id=";
+        line += context->request_id;
+    }
+    if (fields != nullptr) {
+        for (const auto& field : fields->fields_) {
+            line += ' ';
+            line += field.key;
+            line += '=';
+            line += field.value;
+        }
+    }
+    line += '\n';
+}
+
+void Logger::parseModuleLimits(const std::string& spec) {
+    // 形如 "HTTP=200/10,TTS=50"：模块名=每秒上限[/采样间隔]
+    module_limits_.clear();
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        std::string item = spec.substr(start, end - start);
+        start = end + 1;
+        item.erase(std::remove(item.begin(), item.end(), ' '), item.end());
+        if (item.empty()) {
+            continue;
+        }
+
+        size_t eq = item.find('=');
+        int rate = -1;
+        int sample = default_sample_every_;
+        if (eq != std::string::npos && eq > 0) {
+            size_t slash = item.find('/', eq + 1);
+            rate = std::atoi(item.substr(eq + 1, slash == std::string::npos ? std::string::npos : slash - eq - 1).c_str());
+            if (slash != std::string::npos) {
+                sample = std::atoi(item.c_str() + slash + 1);
+            }
+        }
+        if (rate < 0 || sample < 1) {
+            LOG_WARN("Logger", "忽略无效的log_module_limits配置: " + item);
+            continue;
+        }
+        module_limits_[item.substr(0, eq)] = std::make_pair(rate, sample);
+    }
+}
+
+Logger::ModuleLimiter* Logger::limiterFor(const std::string& module) {
+    // 模块名有限，每个线程缓存查找结果，之后无需加锁
+    static thread_local std::unordered_map<std::string, ModuleLimiter*> cache;
+    auto cached = cache.find(module);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+
+    std::lock_guard<std::mutex> lock(limiter_mutex_);
+    auto& limiter = limiters_[module];
+    if (!limiter) {
+        limiter = std::make_unique<ModuleLimiter>();
+        auto it = module_limits_.find(module);
+        limiter->rate_per_sec = it != module_limits_.end() ? it->second.first : default_rate_per_sec_;
+        limiter->sample_every = it != module_limits_.end() ? it->second.second : default_sample_every_;
+    }
+    cache.emplace(module, limiter.get());
+    return limiter.get();
+}
+
+bool Logger::admit(const std::string& module) {
+    ModuleLimiter* limiter = limiterFor(module);
+    if (limiter->sample_every > 1 &&
+        limiter->sample_counter.fetch_add(1, std::memory_order_relaxed) % limiter->sample_every != 0) {
+        limiter->suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (limiter->rate_per_sec > 0) {
+        // 按秒的固定窗口计数；窗口切换时的并发竞争只会让个别日志多放行或少放行
+        int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t window = limiter->window.load(std::memory_order_relaxed);
+        if (window != now && limiter->window.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+            limiter->window_count.store(0, std::memory_order_relaxed);
+        }
+        if (limiter->window_count.fetch_add(1, std::memory_order_relaxed) >= limiter->rate_per_sec) {
+            limiter->suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+void Logger::reportSuppressed(std::string& batch) {
+    std::lock_guard<std::mutex> lock(limiter_mutex_);
+    for (const auto& item : limiters_) {
+        uint64_t suppressed = item.second->suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) {
+            formatLine(batch, LogLevel::WARN, "Logger",
+                       "模块[" + item.first + "]的日志被限流/采样丢弃了 " + std::to_string(suppressed) + " 条",
+                       &LogFields().add("limited_module", item.first).add("suppressed", static_cast<long long>(suppressed)));
+        }
+    }
 }
 
 void Logger::debug(const std::string& module, const std::string& message) {
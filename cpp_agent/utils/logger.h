@@ -2,13 +2,16 @@
 #define LOGGER_H
 
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
 #include <mutex>
 #include <memory>
 #include <sstream>
-#include <chrono>
-#include <iomanip>
-#include <ctime>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
 
 namespace utils {
 
@@ -19,12 +22,88 @@ enum class LogLevel {
     ERROR = 3
 };
 
+// 编译期最低日志级别（LogLevel的数值），低于该级别的LOG_*调用点在编译时整体移除；
+// Release构建定义为1（去掉DEBUG），默认0保留全部
+#ifndef AGENT_MIN_LOG_LEVEL
+#define AGENT_MIN_LOG_LEVEL 0
+#endif
+
+/**
+ * @brief 日志上下文：当前线程正在处理的请求
+ *
+ * 由ScopedLogContext按作用域安装到当前线程。跨线程的异步回调在提交时用current()取得
+ * 上下文、执行时重新安装，同一请求在各线程输出的日志带有相同的request_id。
+ */
+struct LogContext {
+    std::string request_id;
+    std::string user_id;
+    std::string session_id;
+
+    // 当前线程的上下文，没有时返回空指针
+    static std::shared_ptr<const LogContext> current();
+    // 生成新的请求ID（16位十六进制，进程内唯一）
+    static std::string newRequestId();
+};
+
+using LogContextPtr = std::shared_ptr<const LogContext>;
+
+class ScopedLogContext {
+public:
+    explicit ScopedLogContext(LogContextPtr context);
+    // 沿用当前上下文的request_id，补充用户和会话
+    ScopedLogContext(const std::string& user_id, const std::string& session_id);
+    ~ScopedLogContext();
+
+    ScopedLogContext(const ScopedLogContext&) = delete;
+    ScopedLogContext& operator=(const ScopedLogContext&) = delete;
+
+private:
+    LogContextPtr previous_;
+};
+
+/**
+ * @brief 一条日志附带的类型化字段：JSON格式中是独立的字符串/数值字段，文本格式中追加为key=value
+ */
+class LogFields {
+public:
+    LogFields& add(const char* key, std::string_view value);
+    LogFields& add(const char* key, const char* value) { return add(key, std::string_view(value)); }
+    LogFields& add(const char* key, const std::string& value) { return add(key, std::string_view(value)); }
+    LogFields& add(const char* key, long long value);
+    LogFields& add(const char* key, int value) { return add(key, static_cast<long long>(value)); }
+    LogFields& add(const char* key, long value) { return add(key, static_cast<long long>(value)); }
+    LogFields& add(const char* key, unsigned long value) { return add(key, static_cast<long long>(value)); }
+    LogFields& add(const char* key, double value);
+
+private:
+    friend class Logger;
+    struct Field {
+        const char* key;
+        std::string value;
+        bool quoted;
+    };
+    std::vector<Field> fields_;
+};
+
+/**
+ * @brief 异步日志
+ *
+ * 调用线程只负责格式化一行日志并放入有界的多生产者单消费者环形队列（无锁），
+ * 后台写线程每log_flush_interval_ms把队列中的日志拼成一批，用一次write(2)写到控制台和日志文件。
+ * 队列满时丢弃并计数，不阻塞调用方；init()之前和close()之后同步写出。
+ *
+ * log_format为json时每行输出一个JSON对象（ts/level/module/msg、当前LogContext和LogFields中的字段）。
+ * DEBUG/INFO日志可按模块限流（每秒条数）和采样（每N条保留1条），WARN/ERROR不受限制；
+ * 被限流丢弃的条数由写线程按模块汇总输出。
+ */
 class Logger {
 public:
     static Logger& getInstance();
     
-    // 初始化日志系统（从配置文件读取设置）
+    // 初始化日志系统（从配置文件读取设置）并启动写线程
     void init();
+    // 写出队列中剩余的日志并停止写线程
+    void close();
     
     // 设置日志级别
     void setLogLevel(LogLevel level);
@@ -32,8 +111,17 @@ public:
     // 设置日志文件（可选，如果为空则只输出到控制台）
     void setLogFile(const std::string& filepath);
     
+    // 该级别当前是否输出（运行期级别，可随时修改）
+    bool shouldLog(LogLevel level) const {
+        return level >= current_level_.load(std::memory_order_relaxed);
+    }
+    
     // 日志输出接口
     void log(LogLevel level, const std::string& module, const std::string& message);
+    void log(LogLevel level, const std::string& module, const std::string& message, const LogFields& fields);
+    
+    // 因队列满被丢弃的日志条数
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
     
     // 便捷方法
     void debug(const std::string& module, const std::string& message);
@@ -45,21 +133,27 @@ public:
     class LogStream {
     public:
         LogStream(Logger* logger, LogLevel level, const std::string& module)
-            : logger_(logger), level_(level), module_(module) {}
+            : logger_(logger), level_(level), enabled_(logger->shouldLog(level)), module_(module) {}
         
         ~LogStream() {
-            logger_->log(level_, module_, stream_.str());
+            if (enabled_) {
+                logger_->log(level_, module_, stream_.str());
+            }
         }
         
+        // 级别未开启时不做任何格式化
         template<typename T>
         LogStream& operator<<(const T& value) {
-            stream_ << value;
+            if (enabled_) {
+                stream_ << value;
+            }
             return *this;
         }
         
     private:
         Logger* logger_;
         LogLevel level_;
+        bool enabled_;
         std::string module_;
         std::ostringstream stream_;
     };
@@ -86,27 +180,107 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
     
-    std::string levelToString(LogLevel level);
-    std::string getCurrentTime();
-    void writeLog(const std::string& log_message);
+    // 环形队列的槽位：seq为Vyukov有界队列的序号，表示该槽当前可写还是可读
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq;
+        std::string line;
+    };
+    
+    // 单个模块的限流/采样状态，创建后不会删除
+    struct ModuleLimiter {
+        int rate_per_sec = 0;     // 每秒最多输出的条数，0表示不限
+        int sample_every = 1;     // 每N条保留1条
+        std::atomic<int64_t> window{0};
+        std::atomic<int> window_count{0};
+        std::atomic<uint64_t> sample_counter{0};
+        std::atomic<uint64_t> suppressed{0};
+    };
+    
+    void logLine(LogLevel level, const std::string& module, const std::string& message, const LogFields* fields);
+    void formatLine(std::string& line, LogLevel level, std::string_view module, std::string_view message,
+                    const LogFields* fields) const;
+    bool admit(const std::string& module);
+    ModuleLimiter* limiterFor(const std::string& module);
+    void parseModuleLimits(const std::string& spec);
+    void reportSuppressed(std::string& batch);
+    
+    // 入队成功返回true，pos为该条日志的入队序号
+    bool tryPush(std::string&& line, size_t& pos);
+    // 取出所有已就绪的日志追加到batch，返回条数
+    size_t drainTo(std::string& batch);
+    void writeBatch(const std::string& batch);
+    void writeLoop();
+    
+    std::atomic<LogLevel> current_level_;   // 只作级别判断，relaxed读写即可
+    bool json_format_;
+    
+    // 限流配置在init()中确定；limiters_只增不删，调用线程缓存其中的指针
+    bool limits_enabled_;
+    int default_rate_per_sec_;
+    int default_sample_every_;
+    std::unordered_map<std::string, std::pair<int, int>> module_limits_;
+    std::mutex limiter_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<ModuleLimiter>> limiters_;
     
-    LogLevel current_level_;
-    std::mutex mutex_;
-    std::unique_ptr<std::ofstream> log_file_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) size_t dequeue_pos_;         // 只由写线程访问
+    std::atomic<uint64_t> dropped_;
+    
+    std::atomic<bool> running_;
+    // 正在入队的生产者数；close()在最后一次取队列前等它归零，避免入队的日志无人写出
+    std::atomic<int> producers_;
+    bool should_stop_;
+    int flush_interval_ms_;
+    std::thread writer_thread_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    
+    // 保护日志文件描述符及同步写出路径
+    std::mutex file_mutex_;
+    int log_fd_;
     std::string log_filepath_;
 };
 
-// 全局便捷宏
-#define LOG_DEBUG(module, msg) utils::Logger::getInstance().debug(module, msg)
-#define LOG_INFO(module, msg) utils::Logger::getInstance().info(module, msg)
-#define LOG_WARN(module, msg) utils::Logger::getInstance().warn(module, msg)
-#define LOG_ERROR(module, msg) utils::Logger::getInstance().error(module, msg)
-
-// 流式日志宏
-#define LOG_DEBUG_STREAM(module) utils::Logger::getInstance().debug(module)
-#define LOG_INFO_STREAM(module) utils::Logger::getInstance().info(module)
-#define LOG_WARN_STREAM(module) utils::Logger::getInstance().warn(module)
-#define LOG_ERROR_STREAM(module) utils::Logger::getInstance().error(module)
+// 全局便捷宏：先判断级别再求值参数，级别未开启时msg表达式（字符串拼接等）不会被执行；
+// 低于AGENT_MIN_LOG_LEVEL的级别在编译期即被移除
+#define AGENT_LOG_ENABLED(level) \
+    (static_cast<int>(level) >= AGENT_MIN_LOG_LEVEL && utils::Logger::getInstance().shouldLog(level))
+
+#define AGENT_LOG(level, module, msg) \
+    do { \
+        if (AGENT_LOG_ENABLED(level)) { \
+            utils::Logger::getInstance().log(level, module, msg); \
+        } \
+    } while (0)
+
+#define AGENT_LOG_FIELDS(level, module, msg, fields) \
+    do { \
+        if (AGENT_LOG_ENABLED(level)) { \
+            utils::Logger::getInstance().log(level, module, msg, fields); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(module, msg) AGENT_LOG(utils::LogLevel::DEBUG, module, msg)
+#define LOG_INFO(module, msg) AGENT_LOG(utils::LogLevel::INFO, module, msg)
+#define LOG_WARN(module, msg) AGENT_LOG(utils::LogLevel::WARN, module, msg)
+#define LOG_ERROR(module, msg) AGENT_LOG(utils::LogLevel::ERROR, module, msg)
+
+// 带类型化字段的日志，如 LOG_INFO_FIELDS("HTTP", "请求完成", utils::LogFields().add("latency_ms", ms))
+#define LOG_DEBUG_FIELDS(module, msg, fields) AGENT_LOG_FIELDS(utils::LogLevel::DEBUG, module, msg, fields)
+#define LOG_INFO_FIELDS(module, msg, fields) AGENT_LOG_FIELDS(utils::LogLevel::INFO, module, msg, fields)
+#define LOG_WARN_FIELDS(module, msg, fields) AGENT_LOG_FIELDS(utils::LogLevel::WARN, module, msg, fields)
+#define LOG_ERROR_FIELDS(module, msg, fields) AGENT_LOG_FIELDS(utils::LogLevel::ERROR, module, msg, fields)
+
+// 流式日志宏：级别未开启时<<右侧的表达式不会被求值
+#define AGENT_LOG_STREAM(level, module) \
+    if (!AGENT_LOG_ENABLED(level)) {} else utils::Logger::LogStream(&utils::Logger::getInstance(), level, module)
+
+#define LOG_DEBUG_STREAM(module) AGENT_LOG_STREAM(utils::LogLevel::DEBUG, module)
+#define LOG_INFO_STREAM(module) AGENT_LOG_STREAM(utils::LogLevel::INFO, module)
+#define LOG_WARN_STREAM(module) AGENT_LOG_STREAM(utils::LogLevel::WARN, module)
+#define LOG_ERROR_STREAM(module) AGENT_LOG_STREAM(utils::LogLevel::ERROR, module)
 
 } // namespace utils
 
@@ -0,0 +1,164 @@
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <cstdint>
+#include <string_view>
+#include <initializer_list>
+#include <list>
+#include <iterator>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+
+namespace utils {
+
+/**
+ * @brief 计算缓存键：对各字段做64位FNV-1a哈希（字段间加分隔符，避免拼接歧义）
+ */
+inline uint64_t cacheKey(std::initializer_list<std::string_view> fields) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::string_view field : fields) {
+        for (unsigned char c : field) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0x1f;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief 缓存统计
+ */
+struct LruCacheStats {
+    size_t entries = 0;
+    size_t bytes = 0;            // 当前占用（按put时给出的大小累计）
+    size_t max_bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;      // 因超出内存预算被淘汰
+    uint64_t expirations = 0;    // 因过期被移除
+
+    double hitRatio() const {
+        uint64_t total = hits + misses;
+        return total ? static_cast<double>(hits) / total : 0.0;
+    }
+};
+
+/**
+ * @brief 线程安全的LRU缓存，按内存预算淘汰，每个条目带过期时间
+ *
+ * 键为64位哈希（见cacheKey），冲突概率可忽略；max_bytes为0时缓存关闭。
+ */
+template <typename V>
+class LruCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit LruCache(size_t max_bytes = 0) : max_bytes_(max_bytes) {}
+
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+
+    bool enabled() const { return max_bytes_ > 0; }
+
+    /**
+     * @brief 查找未过期的条目，命中时移到最近使用端
+     */
+    bool get(uint64_t key, V& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            misses_++;
+            return false;
+        }
+        if (it->second->expires_at <= Clock::now()) {
+            eraseLocked(it->second);
+            expirations_++;
+            misses_++;
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        value = it->second->value;
+        hits_++;
+        return true;
+    }
+
+    /**
+     * @brief 写入条目（已存在则覆盖），超出预算时从最久未使用端淘汰
+     * @param bytes 条目占用的内存估计
+     */
+    void put(uint64_t key, V value, size_t bytes, Clock::time_point expires_at) {
+        if (max_bytes_ == 0 || bytes > max_bytes_) {
+            return; // 关闭或单个条目超过整个预算
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            eraseLocked(it->second);
+        }
+        lru_.push_front(Entry{key, std::move(value), bytes, expires_at});
+        index_[key] = lru_.begin();
+        bytes_ += bytes;
+
+        while (bytes_ > max_bytes_ && !lru_.empty()) {
+            auto last = std::prev(lru_.end());
+            if (last->expires_at <= Clock::now()) {
+                expirations_++;
+            } else {
+                evictions_++;
+            }
+            eraseLocked(last);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    LruCacheStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        LruCacheStats s;
+        s.entries = index_.size();
+        s.bytes = bytes_;
+        s.max_bytes = max_bytes_;
+        s.hits = hits_;
+        s.misses = misses_;
+        s.evictions = evictions_;
+        s.expirations = expirations_;
+        return s;
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        V value;
+        size_t bytes;
+        Clock::time_point expires_at;
+    };
+    using EntryIter = typename std::list<Entry>::iterator;
+
+    void eraseLocked(EntryIter entry) {
+        bytes_ -= entry->bytes;
+        index_.erase(entry->key);
+        lru_.erase(entry);
+    }
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;                          // 头部为最近使用
+    std::unordered_map<uint64_t, EntryIter> index_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t evictions_ = 0;
+    uint64_t expirations_ = 0;
+};
+
+} // namespace utils
+
+#endif // LRU_CACHE_H
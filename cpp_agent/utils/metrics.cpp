@@ -0,0 +1,157 @@
+#include "metrics.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace utils {
+
+static void appendNumber(std::string& out, double value) {
+    char buf[32];
+    int n = snprintf(buf, sizeof(buf), "%.9g", value);
+    out.append(buf, static_cast<size_t>(n));
+}
+
+static void appendNumber(std::string& out, uint64_t value) {
+    out += std::to_string(value);
+}
+
+static void appendHeader(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+// 进程当前的线程数：/proc/self/stat的第20个字段
+static long processThreads() {
+    std::ifstream file("/proc/self/stat");
+    std::string stat;
+    if (!std::getline(file, stat)) {
+        return 0;
+    }
+    // 第2个字段（进程名）可能含空格，从最后一个')'之后开始数
+    size_t pos = stat.rfind(')');
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    int field = 2;
+    for (size_t i = pos + 1; i < stat.size(); ++i) {
+        if (stat[i] == ' ' && ++field == 20) {
+            return std::atol(stat.c_str() + i + 1);
+        }
+    }
+    return 0;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void Counter::render(std::string& out, const std::string& name) const {
+    out += name;
+    out += ' ';
+    appendNumber(out, value());
+    out += '\n';
+}
+
+void Gauge::render(std::string& out, const std::string& name) const {
+    out += name;
+    out += ' ';
+    out += std::to_string(value());
+    out += '\n';
+}
+
+void Histogram::render(std::string& out, const std::string& name) const {
+    uint64_t counts[bucket_count + 1] = {};
+    uint64_t sum_us = 0;
+    for (const auto& shard : shards_) {
+        for (size_t i = 0; i <= bucket_count; ++i) {
+            counts[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        sum_us += shard.sum_us.load(std::memory_order_relaxed);
+    }
+
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i <= bucket_count; ++i) {
+        cumulative += counts[i];
+        out += name;
+        out += "_bucket{le=\"";
+        if (i < bucket_count) {
+            appendNumber(out, static_cast<double>(uint64_t(1) << i) / 1e6);
+        } else {
+            out += "+Inf";
+        }
+        out += "\"} ";
+        appendNumber(out, cumulative);
+        out += '\n';
+    }
+    out += name;
+    out += "_sum ";
+    appendNumber(out, static_cast<double>(sum_us) / 1e6);
+    out += '\n';
+    out += name;
+    out += "_count ";
+    appendNumber(out, cumulative);
+    out += '\n';
+}
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+template <typename T>
+T& MetricsRegistry::getOrCreate(const std::string& name, const std::string& help, const char* type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& entry : entries_) {
+        if (entry.name == name) {
+            return static_cast<T&>(*entry.metric);
+        }
+    }
+    entries_.push_back(Entry{name, help, type, std::make_unique<T>()});
+    return static_cast<T&>(*entries_.back().metric);
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    return getOrCreate<Counter>(name, help, "counter");
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    return getOrCreate<Gauge>(name, help, "gauge");
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help) {
+    return getOrCreate<Histogram>(name, help, "histogram");
+}
+
+void MetricsRegistry::render(std::string& out) const {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : entries_) {
+            appendHeader(out, entry.name, entry.help, entry.type);
+            entry.metric->render(out, entry.name);
+        }
+    }
+    appendSample(out, "agent_process_threads", "gauge", "进程当前的线程数",
+                 static_cast<double>(processThreads()));
+}
+
+void MetricsRegistry::appendSample(std::string& out, const char* name, const char* type, const char* help,
+                                   double value) {
+    appendHeader(out, name, help, type);
+    out += name;
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+
+} // namespace utils
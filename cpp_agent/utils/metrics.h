@@ -0,0 +1,144 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace utils {
+
+// 计数器和直方图的分片数：每个线程固定写其中一个分片，不同线程之间几乎不争用缓存行
+static constexpr size_t metrics_shards = 16;
+
+// 当前线程使用的分片下标（线程首次调用时按顺序分配）
+inline size_t metricsShard() {
+    static std::atomic<size_t> next{0};
+    static thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % metrics_shards;
+    return shard;
+}
+
+class Metric {
+public:
+    virtual ~Metric() = default;
+    // 按Prometheus文本格式输出该指标的样本行（不含HELP/TYPE）
+    virtual void render(std::string& out, const std::string& name) const = 0;
+};
+
+/**
+ * @brief 单调递增计数器，按线程分片累加，读取时求和
+ */
+class Counter : public Metric {
+public:
+    void inc(uint64_t n = 1) {
+        shards_[metricsShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+    uint64_t value() const;
+    void render(std::string& out, const std::string& name) const override;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    Shard shards_[metrics_shards];
+};
+
+/**
+ * @brief 可增可减的瞬时值（如当前连接数）
+ */
+class Gauge : public Metric {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+    void render(std::string& out, const std::string& name) const override;
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief 耗时直方图：按2的幂划分桶（1微秒到约67秒，共27个桶加+Inf），按线程分片计数
+ *
+ * 记录时只做一次前导零计数和两次relaxed原子加；输出时各分片求和并转成以秒为单位的累积桶。
+ */
+class Histogram : public Metric {
+public:
+    static constexpr size_t bucket_count = 27;
+
+    void observeMicros(uint64_t micros) {
+        Shard& shard = shards_[metricsShard()];
+        shard.buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum_us.fetch_add(micros, std::memory_order_relaxed);
+    }
+    void observeSince(std::chrono::steady_clock::time_point start) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        observeMicros(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    }
+    void render(std::string& out, const std::string& name) const override;
+
+private:
+    // 第i个桶的上界为2^i微秒，最后一个下标对应+Inf
+    static size_t bucketIndex(uint64_t micros) {
+        if (micros <= 1) {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(64 - __builtin_clzll(micros - 1));
+        return index < bucket_count ? index : bucket_count;
+    }
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[bucket_count + 1] = {};
+        std::atomic<uint64_t> sum_us{0};
+    };
+    Shard shards_[metrics_shards];
+};
+
+/**
+ * @brief 进程内指标注册表
+ *
+ * 指标在首次使用时注册（通常保存为函数内静态引用），之后记录数据无需加锁；
+ * 同名指标重复注册返回同一个对象。render()输出Prometheus文本格式，另附进程线程数。
+ */
+class MetricsRegistry {
+public:
+    static MetricsRegistry& getInstance();
+
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+    Histogram& histogram(const std::string& name, const std::string& help);
+
+    void render(std::string& out) const;
+
+    /**
+     * @brief 追加一个单值样本（带HELP/TYPE），用于在输出时从各模块统计接口读取的值
+     * @param type "counter"或"gauge"
+     */
+    static void appendSample(std::string& out, const char* name, const char* type, const char* help, double value);
+
+private:
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    struct Entry {
+        std::string name;
+        std::string help;
+        const char* type;
+        std::unique_ptr<Metric> metric;
+    };
+
+    template <typename T>
+    T& getOrCreate(const std::string& name, const std::string& help, const char* type);
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+} // namespace utils
+
+#endif // METRICS_H
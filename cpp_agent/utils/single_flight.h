@@ -0,0 +1,83 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+#include <exception>
+#include "logger.h"
+
+namespace utils {
+
+/**
+ * @brief 异步请求合并：同一个键同时只有一个上游请求在进行
+ *
+ * 用法：
+ *   if (flight.join(key, callback)) {
+ *       // 本次调用是发起者，负责发起上游请求，完成后调用 flight.complete(key, ...)
+ *   }
+ *   // 否则callback已挂到进行中的请求上，complete时一并回调
+ */
+template <typename V>
+class SingleFlight {
+public:
+    using Callback = std::function<void(const V& value, std::exception_ptr error)>;
+
+    /**
+     * @brief 加入对key的请求
+     * @return true表示没有进行中的请求，调用方需发起请求并最终调用complete()
+     */
+    bool join(uint64_t key, Callback callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = calls_.find(key);
+        if (it != calls_.end()) {
+            it->second.push_back(Waiter{std::move(callback), LogContext::current()});
+            coalesced_++;
+            return false;
+        }
+        calls_[key].push_back(Waiter{std::move(callback), LogContext::current()});
+        return true;
+    }
+
+    /**
+     * @brief 完成请求，依次回调所有等待者（在锁外执行，各自恢复加入时的日志上下文）
+     */
+    void complete(uint64_t key, const V& value, std::exception_ptr error) {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = calls_.find(key);
+            if (it == calls_.end()) {
+                return;
+            }
+            waiters.swap(it->second);
+            calls_.erase(it);
+        }
+        for (auto& waiter : waiters) {
+            ScopedLogContext log_scope(std::move(waiter.log_context));
+            waiter.callback(value, error);
+        }
+    }
+
+    // 被合并（未单独发起上游请求）的调用次数
+    uint64_t coalesced() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return coalesced_;
+    }
+
+private:
+    struct Waiter {
+        Callback callback;
+        LogContextPtr log_context;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint64_t, std::vector<Waiter>> calls_;
+    uint64_t coalesced_ = 0;
+};
+
+} // namespace utils
+
+#endif // SINGLE_FLIGHT_H
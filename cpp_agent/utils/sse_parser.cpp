@@ -0,0 +1,77 @@
+#include "sse_parser.h"
+#include <cstring>
+
+namespace utils {
+
+SseParser::SseParser(EventCallback on_event)
+    : on_event_(std::move(on_event)), has_data_(false) {
+}
+
+void SseParser::feed(const char* data, size_t len) {
+    size_t start = 0;
+    while (start < len) {
+        const void* nl = std::memchr(data + start, '\n', len - start);
+        if (!nl) {
+            line_buf_.append(data + start, len - start);
+            return;
+        }
+        size_t end = static_cast<const char*>(nl) - data;
+        if (line_buf_.empty()) {
+            // 常见情况：整行都在本块内，不拷贝
+            size_t line_len = end - start;
+            if (line_len > 0 && data[end - 1] == '\r') {
+                --line_len;
+            }
+            processLine(data + start, line_len);
+        } else {
+            line_buf_.append(data + start, end - start);
+            if (!line_buf_.empty() && line_buf_.back() == '\r') {
+                line_buf_.pop_back();
+            }
+            processLine(line_buf_.data(), line_buf_.size());
+            line_buf_.clear();
+        }
+        start = end + 1;
+    }
+}
+
+void SseParser::processLine(const char* line, size_t len) {
+    if (len == 0) {
+        dispatch();
+        return;
+    }
+    if (line[0] == ':') {
+        return; // 注释行
+    }
+
+    const char* colon = static_cast<const char*>(std::memchr(line, ':', len));
+    size_t name_len = colon ? static_cast<size_t>(colon - line) : len;
+    const char* value = colon ? colon + 1 : line + len;
+    size_t value_len = len - (value - line);
+    if (value_len > 0 && value[0] == ' ') {
+        ++value;
+        --value_len;
+    }
+
+    if (name_len == 4 && std::memcmp(line, "data", 4) == 0) {
+        if (has_data_) {
+            data_.push_back('\n');
+        }
+        data_.append(value, value_len);
+        has_data_ = true;
+    } else if (name_len == 5 && std::memcmp(line, "event", 5) == 0) {
+        event_.assign(value, value_len);
+    }
+    // id、retry等字段不需要
+}
+
+void SseParser::dispatch() {
+    if (has_data_) {
+        on_event_(event_.empty() ? "message" : event_, data_);
+    }
+    event_.clear();
+    data_.clear();
+    has_data_ = false;
+}
+
+} // namespace utils
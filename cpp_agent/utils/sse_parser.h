@@ -0,0 +1,40 @@
+#ifndef SSE_PARSER_H
+#define SSE_PARSER_H
+
+#include <string>
+#include <functional>
+
+namespace utils {
+
+/**
+ * @brief 增量式Server-Sent Events解析器
+ *
+ * 数据可以按任意边界分块传入，每凑齐一个完整事件（以空行结束）回调一次。
+ * 支持\n和\r\n换行；多行data以\n拼接；以':'开头的注释行会被忽略。
+ */
+class SseParser {
+public:
+    // event为事件类型（未指定时为"message"），data为事件数据
+    using EventCallback = std::function<void(const std::string& event, const std::string& data)>;
+
+    explicit SseParser(EventCallback on_event);
+
+    /**
+     * @brief 输入一块数据
+     */
+    void feed(const char* data, size_t len);
+
+private:
+    void processLine(const char* line, size_t len);
+    void dispatch();
+
+    EventCallback on_event_;
+    std::string line_buf_;   // 尚未遇到换行的半行数据
+    std::string event_;
+    std::string data_;
+    bool has_data_;
+};
+
+} // namespace utils
+
+#endif // SSE_PARSER_H
@@ -0,0 +1,80 @@
+#include "thread_pool.h"
+#include "logger.h"
+#include "trace.h"
+
+namespace utils {
+
+ThreadPool::ThreadPool(size_t num_threads, const std::string& name)
+    : name_(name), stopping_(false) {
+    if (num_threads == 0) {
+        num_threads = 1;
+    }
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+    LOG_INFO("ThreadPool", name_ + " 线程池启动，线程数: " + std::to_string(num_threads));
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+bool ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tasks_.size();
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    Tracer::setThreadName(name_);
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                break; // stopping_ 且任务已清空
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        try {
+            task();
+        } catch (const std::exception& e) {
+            LOG_ERROR("ThreadPool", name_ + " 任务异常: " + std::string(e.what()));
+        } catch (...) {
+            LOG_ERROR("ThreadPool", name_ + " 任务抛出未知异常");
+        }
+    }
+}
+
+} // namespace utils
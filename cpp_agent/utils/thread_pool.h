@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace utils {
+
+/**
+ * @brief 固定大小的工作线程池
+ *
+ * 线程数量在构造时确定，不随任务数增长；任务按提交顺序(FIFO)执行。
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief 创建线程池并立即启动工作线程
+     * @param num_threads 工作线程数量（至少为1）
+     * @param name 线程池名称（用于日志）
+     */
+    ThreadPool(size_t num_threads, const std::string& name);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief 提交任务
+     * @param task 待执行的任务
+     * @return 线程池已停止时返回false
+     */
+    bool submit(std::function<void()> task);
+
+    /**
+     * @brief 停止线程池，执行完已提交的任务后回收所有线程
+     */
+    void stop();
+
+    size_t size() const { return workers_.size(); }
+    size_t pending() const;
+
+private:
+    void workerLoop();
+
+    std::string name_;
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<bool> stopping_;
+};
+
+} // namespace utils
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,257 @@
+#include "trace.h"
+#include "config.h"
+#include "logger.h"
+#include "json_writer.h"
+#include <fstream>
+#include <algorithm>
+#include <ctime>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace utils {
+
+// 单次采集的最长时间
+static constexpr int max_capture_seconds = 60;
+// 每个线程在一次采集中最多保留的span数，超出的丢弃并计数
+static constexpr size_t max_events_per_thread = 100000;
+
+// 逐级创建目录（已存在不算错误）
+static bool makeDirectories(const std::string& path) {
+    for (size_t pos = 1; pos <= path.size(); ++pos) {
+        if (pos != path.size() && path[pos] != '/') {
+            continue;
+        }
+        std::string prefix = path.substr(0, pos);
+        if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Tracer::Tracer()
+    : enabled_(false), origin_(std::chrono::steady_clock::now()), capturing_(false), stop_capture_(false) {
+}
+
+Tracer::~Tracer() {
+    close();
+}
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::ThreadBuffer& Tracer::threadBuffer() {
+    // 缓冲区由注册表和线程共同持有，线程退出后已记录的span仍可导出
+    static thread_local std::shared_ptr<ThreadBuffer> current;
+    if (!current) {
+        current = std::make_shared<ThreadBuffer>();
+        current->tid = static_cast<long>(::syscall(SYS_gettid));
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.push_back(current);
+    }
+    return *current;
+}
+
+void Tracer::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = getInstance().threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.thread_name = name;
+}
+
+void Tracer::appendArg(std::string& args, const char* key, std::string_view value) {
+    if (!args.empty()) {
+        args += ',';
+    }
+    args += '"';
+    args += key;
+    args += "\":\"";
+    JsonWriter::appendEscaped(args, value);
+    args += '"';
+}
+
+void Tracer::appendArg(std::string& args, const char* key, long long value) {
+    if (!args.empty()) {
+        args += ',';
+    }
+    args += '"';
+    args += key;
+    args += "\":";
+    args += std::to_string(value);
+}
+
+void Tracer::record(const char* name, const char* category,
+                    std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end,
+                    std::string args) {
+    if (!enabled()) {
+        return;
+    }
+    LogContextPtr context = LogContext::current();
+    if (context && !context->request_id.empty()) {
+        std::string with_request;
+        appendArg(with_request, "request_id", context->request_id);
+        if (!args.empty()) {
+            with_request += ',';
+            with_request += args;
+        }
+        args.swap(with_request);
+    }
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.ts_us = std::chrono::duration_cast<std::chrono::microseconds>(start - origin_).count();
+    event.dur_us = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+    event.args = std::move(args);
+
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    if (buffer.events.size() >= max_events_per_thread) {
+        buffer.dropped++;
+        return;
+    }
+    buffer.events.push_back(std::move(event));
+}
+
+bool Tracer::startCapture(int seconds, CaptureCallback done) {
+    std::lock_guard<std::mutex> lock(capture_mutex_);
+    if (capturing_) {
+        return false;
+    }
+    // 上一次采集的线程已结束，回收后再开始新的采集
+    if (capture_thread_.joinable()) {
+        capture_thread_.join();
+    }
+    {
+        std::lock_guard<std::mutex> buffers_lock(buffers_mutex_);
+        for (const auto& buffer : buffers_) {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            buffer->events.clear();
+            buffer->dropped = 0;
+        }
+    }
+
+    seconds = std::min(std::max(seconds, 1), max_capture_seconds);
+    capturing_ = true;
+    stop_capture_ = false;
+    enabled_.store(true, std::memory_order_relaxed);
+    capture_thread_ = std::thread(&Tracer::captureLoop, this, seconds, std::move(done));
+    LOG_INFO("Trace", "开始采集trace (" + std::to_string(seconds) + "秒)");
+    return true;
+}
+
+void Tracer::close() {
+    {
+        std::lock_guard<std::mutex> lock(capture_mutex_);
+        stop_capture_ = true;
+    }
+    capture_cv_.notify_all();
+    if (capture_thread_.joinable()) {
+        capture_thread_.join();
+    }
+}
+
+void Tracer::captureLoop(int seconds, CaptureCallback done) {
+    {
+        std::unique_lock<std::mutex> lock(capture_mutex_);
+        capture_cv_.wait_for(lock, std::chrono::seconds(seconds), [this] { return stop_capture_; });
+    }
+    enabled_.store(false, std::memory_order_relaxed);
+
+    std::string json = collect();
+    std::string path = writeFile(json);
+    if (done) {
+        done(!path.empty(), path, json);
+    }
+
+    std::lock_guard<std::mutex> lock(capture_mutex_);
+    capturing_ = false;
+}
+
+std::string Tracer::collect() {
+    std::string json;
+    json.reserve(1 << 20);
+    json += "{\"traceEvents\":[";
+    long pid = static_cast<long>(::getpid());
+    bool first = true;
+    uint64_t dropped = 0;
+    size_t count = 0;
+
+    std::lock_guard<std::mutex> buffers_lock(buffers_mutex_);
+    for (const auto& buffer : buffers_) {
+        std::vector<Event> events;
+        std::string thread_name;
+        {
+            std::lock_guard<std::mutex> lock(buffer->mutex);
+            events.swap(buffer->events);
+            thread_name = buffer->thread_name;
+            dropped += buffer->dropped;
+            buffer->dropped = 0;
+        }
+        if (events.empty()) {
+            continue;
+        }
+        if (!thread_name.empty()) {
+            json += first ? "" : ",";
+            first = false;
+            json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(pid) +
+                    ",\"tid\":" + std::to_string(buffer->tid) + ",\"args\":{\"name\":\"";
+            JsonWriter::appendEscaped(json, thread_name);
+            json += "\"}}";
+        }
+        for (const auto& event : events) {
+            json += first ? "" : ",";
+            first = false;
+            json += "{\"name\":\"";
+            JsonWriter::appendEscaped(json, event.name);
+            json += "\",\"cat\":\"";
+            JsonWriter::appendEscaped(json, event.category);
+            json += "\",\"ph\":\"X\",\"ts\":";
+            json += std::to_string(event.ts_us);
+            json += ",\"dur\":";
+            json += std::to_string(event.dur_us);
+            json += ",\"pid\":";
+            json += std::to_string(pid);
+            json += ",\"tid\":";
+            json += std::to_string(buffer->tid);
+            json += ",\"args\":{";
+            json += event.args;
+            json += "}}";
+        }
+        count += events.size();
+    }
+    json += "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":";
+    json += std::to_string(dropped);
+    json += "}}";
+    LOG_INFO("Trace", "trace采集结束 (span数: " + std::to_string(count) + ", 丢弃: " + std::to_string(dropped) + ")");
+    return json;
+}
+
+std::string Tracer::writeFile(const std::string& json) {
+    std::string dir = Config::getInstance().getString("trace_dir", "./data/traces");
+    if (!makeDirectories(dir)) {
+        LOG_ERROR("Trace", "创建trace目录失败: " + dir);
+        return "";
+    }
+
+    char name[64];
+    std::time_t now = std::time(nullptr);
+    std::tm tm_buf;
+    localtime_r(&now, &tm_buf);
+    std::strftime(name, sizeof(name), "trace-%Y%m%d-%H%M%S.json", &tm_buf);
+    std::string path = dir + "/" + name;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open() || !file.write(json.data(), static_cast<std::streamsize>(json.size()))) {
+        LOG_ERROR("Trace", "写入trace文件失败: " + path);
+        return "";
+    }
+    LOG_INFO("Trace", "trace已写入: " + path);
+    return path;
+}
+
+} // namespace utils
@@ -0,0 +1,140 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+#include <cstdint>
+
+namespace utils {
+
+/**
+ * @brief 按需开启的请求追踪，导出为Chrome trace_event格式（可在chrome://tracing或Perfetto中打开）
+ *
+ * 平时关闭，记录点只做一次relaxed原子读；startCapture()开启后，各线程把span写入自己的
+ * 缓冲区（每线程一把几乎不争用的锁），采集结束时汇总为JSON，写入trace_dir下的文件并交给回调。
+ * 每个span自动带上当前LogContext中的request_id。
+ */
+class Tracer {
+public:
+    using CaptureCallback = std::function<void(bool ok, const std::string& path, const std::string& json)>;
+
+    static Tracer& getInstance();
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 开始采集seconds秒，结束后在采集线程中调用done
+     * @return 已有采集在进行时返回false
+     */
+    bool startCapture(int seconds, CaptureCallback done);
+
+    /**
+     * @brief 结束进行中的采集（仍会写出已记录的部分）并回收采集线程
+     */
+    void close();
+
+    /**
+     * @brief 记录一个已完成的span（时间为steady_clock）；args为已序列化的JSON对象成员（形如 "a":1），可为空
+     */
+    void record(const char* name, const char* category,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end,
+                std::string args = std::string());
+
+    // 为当前线程命名，在trace中显示为线程名
+    static void setThreadName(const std::string& name);
+
+    // 向args追加一个参数（自动补逗号、转义字符串）
+    static void appendArg(std::string& args, const char* key, std::string_view value);
+    static void appendArg(std::string& args, const char* key, long long value);
+
+private:
+    Tracer();
+    ~Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    struct Event {
+        const char* name;
+        const char* category;
+        int64_t ts_us;
+        int64_t dur_us;
+        std::string args;
+    };
+
+    struct ThreadBuffer {
+        std::mutex mutex;
+        long tid = 0;
+        std::string thread_name;
+        std::vector<Event> events;
+        uint64_t dropped = 0;
+    };
+
+    ThreadBuffer& threadBuffer();
+    void captureLoop(int seconds, CaptureCallback done);
+    std::string collect();
+    std::string writeFile(const std::string& json);
+
+    std::atomic<bool> enabled_;
+    std::chrono::steady_clock::time_point origin_;
+
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    std::mutex capture_mutex_;
+    std::condition_variable capture_cv_;
+    bool capturing_;
+    bool stop_capture_;
+    std::thread capture_thread_;
+};
+
+/**
+ * @brief RAII span：构造时计时，析构时记录；追踪关闭时不做任何事
+ *
+ * name和category必须是字符串字面量（只保存指针）。
+ */
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category)
+        : name_(name), category_(category), active_(Tracer::getInstance().enabled()) {
+        if (active_) {
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceSpan() {
+        if (active_) {
+            Tracer::getInstance().record(name_, category_, start_, std::chrono::steady_clock::now(),
+                                         std::move(args_));
+        }
+    }
+
+    // 追加一个参数（只在追踪开启时生效）
+    void arg(const char* key, std::string_view value) {
+        if (active_) {
+            Tracer::appendArg(args_, key, value);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    bool active_;
+    std::chrono::steady_clock::time_point start_;
+    std::string args_;
+};
+
+} // namespace utils
+
+#endif // TRACE_H